@@ -0,0 +1,35 @@
+TEMPLATE = app
+TARGET = benchmarks
+CONFIG += console c++17 thread
+CONFIG -= app_bundle
+CONFIG -= qt
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        bench_runner.cpp \
+        main.cpp \
+        ../document.cpp \
+        ../document_store.cpp \
+        ../inverted_index.cpp \
+        ../matched_documents.cpp \
+        ../metrics.cpp \
+        ../prepared_query.cpp \
+        ../process_queries.cpp \
+        ../query_cache.cpp \
+        ../query_executor.cpp \
+        ../query_stats.cpp \
+        ../read_input_functions.cpp \
+        ../remove_duplicates.cpp \
+        ../request_queue.cpp \
+        ../search_server.cpp \
+        ../segmented_index.cpp \
+        ../snapshot_file.cpp \
+        ../string_processing.cpp \
+        ../term_dictionary.cpp \
+        ../versioned_search_server.cpp \
+        ../Tests/workload.cpp
+
+HEADERS += \
+    bench_runner.h \
+    ../Tests/workload.h
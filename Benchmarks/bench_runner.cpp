@@ -0,0 +1,82 @@
+#include "bench_runner.h"
+#include "../Tests/workload.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+
+// Значение с рангом ceil(share * n) в упорядоченной выборке
+double Percentile(const vector<double>& sorted, double share) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const size_t rank = static_cast<size_t>(ceil(share * sorted.size()));
+    return sorted[min(max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+void WriteString(ostream& out, const string& str) {
+    out << '"';
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+BenchmarkResult MakeBenchmarkResult(string name, size_t warmup, size_t items_per_iteration,
+                                    vector<double> seconds) {
+    BenchmarkResult result;
+    result.name = move(name);
+    result.iterations = seconds.size();
+    result.warmup = warmup;
+    result.items_per_iteration = items_per_iteration;
+    if (seconds.empty()) {
+        return result;
+    }
+    sort(seconds.begin(), seconds.end());
+    const double total = accumulate(seconds.begin(), seconds.end(), 0.0);
+    result.p50_us = Percentile(seconds, 0.50) * 1e6;
+    result.p99_us = Percentile(seconds, 0.99) * 1e6;
+    result.mean_us = total / seconds.size() * 1e6;
+    if (total > 0.0) {
+        result.throughput_per_s = seconds.size() * items_per_iteration / total;
+    }
+    return result;
+}
+
+void WriteBenchmarkReport(ostream& out, const WorkloadOptions& options,
+                          const vector<BenchmarkResult>& results) {
+    out << "{\n";
+    out << "  \"workload\": {\n";
+    out << "    \"seed\": " << options.seed << ",\n";
+    out << "    \"documents\": " << options.document_count << ",\n";
+    out << "    \"vocabulary\": " << options.vocabulary_size << ",\n";
+    out << "    \"zipf\": " << options.zipf_exponent << ",\n";
+    out << "    \"queries\": " << options.query_count << ",\n";
+    out << "    \"minus_word_share\": " << options.minus_word_share << ",\n";
+    out << "    \"duplicate_share\": " << options.duplicate_share << "\n";
+    out << "  },\n";
+    out << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"name\": ";
+        WriteString(out, result.name);
+        out << ", \"iterations\": " << result.iterations
+            << ", \"warmup\": " << result.warmup
+            << ", \"items_per_iteration\": " << result.items_per_iteration
+            << ", \"p50_us\": " << result.p50_us
+            << ", \"p99_us\": " << result.p99_us
+            << ", \"mean_us\": " << result.mean_us
+            << ", \"throughput_per_s\": " << result.throughput_per_s << "}";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Результат одного замера. Задержки в микросекундах, разогревочные
+// вызовы в статистику не входят
+struct BenchmarkResult {
+    std::string name;
+    size_t iterations = 0;
+    size_t warmup = 0;
+    // Количество элементов (документов, запросов), обрабатываемых за вызов
+    size_t items_per_iteration = 1;
+    double p50_us = 0.0;
+    double p99_us = 0.0;
+    double mean_us = 0.0;
+    // Элементов в секунду по суммарному времени замеренных вызовов
+    double throughput_per_s = 0.0;
+};
+
+// Статистика по длительностям замеренных вызовов в секундах
+BenchmarkResult MakeBenchmarkResult(std::string name, size_t warmup, size_t items_per_iteration,
+                                    std::vector<double> seconds);
+
+// Замер func(i) для i из [0, warmup + iterations), первые warmup вызовов
+// не учитываются
+template <typename Func>
+BenchmarkResult MeasureLatency(std::string name, size_t warmup, size_t iterations, Func func) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> seconds;
+    seconds.reserve(iterations);
+    for (size_t i = 0; i < warmup + iterations; ++i) {
+        const auto start = Clock::now();
+        func(i);
+        const std::chrono::duration<double> duration = Clock::now() - start;
+        if (i >= warmup) {
+            seconds.push_back(duration.count());
+        }
+    }
+    return MakeBenchmarkResult(std::move(name), warmup, 1, std::move(seconds));
+}
+
+// Замер пакетной операции: перед каждым вызовом run(state) подготовка
+// state = setup() выполняется вне замера
+template <typename Setup, typename Run>
+BenchmarkResult MeasureBatch(std::string name, size_t warmup, size_t iterations,
+                             size_t items_per_iteration, Setup setup, Run run) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> seconds;
+    seconds.reserve(iterations);
+    for (size_t i = 0; i < warmup + iterations; ++i) {
+        auto state = setup();
+        const auto start = Clock::now();
+        run(state);
+        const std::chrono::duration<double> duration = Clock::now() - start;
+        if (i >= warmup) {
+            seconds.push_back(duration.count());
+        }
+    }
+    return MakeBenchmarkResult(std::move(name), warmup, items_per_iteration, std::move(seconds));
+}
+
+struct WorkloadOptions;
+
+// Отчет в формате JSON: параметры нагрузки и результаты замеров
+void WriteBenchmarkReport(std::ostream& out, const WorkloadOptions& options,
+                          const std::vector<BenchmarkResult>& results);
@@ -0,0 +1,209 @@
+#include "bench_runner.h"
+#include "../Tests/workload.h"
+
+#include "../process_queries.h"
+#include "../remove_duplicates.h"
+#include "../search_server.h"
+
+#include <cstdlib>
+#include <execution>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct BenchmarkOptions {
+    WorkloadOptions workload;
+    size_t warmup = 100;
+    // Повторы пакетных замеров: загрузка корпуса, пакет запросов, удаление повторов
+    size_t batch_iterations = 3;
+    string output;
+};
+
+void PrintUsage(ostream& out) {
+    out << "Usage: benchmarks [--documents N] [--vocabulary N] [--zipf X] [--queries N]\n"
+           "                  [--seed N] [--warmup N] [--batches N] [--output FILE]\n";
+}
+
+BenchmarkOptions ParseOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const string_view name = argv[i];
+        if (name == "--help"sv) {
+            PrintUsage(cout);
+            exit(0);
+        }
+        if (i + 1 == argc) {
+            throw invalid_argument("missing value for "s + string(name));
+        }
+        const string value = argv[++i];
+        if (name == "--documents"sv) {
+            options.workload.document_count = stoull(value);
+        } else if (name == "--vocabulary"sv) {
+            options.workload.vocabulary_size = stoull(value);
+        } else if (name == "--zipf"sv) {
+            options.workload.zipf_exponent = stod(value);
+        } else if (name == "--queries"sv) {
+            options.workload.query_count = stoull(value);
+        } else if (name == "--seed"sv) {
+            options.workload.seed = stoull(value);
+        } else if (name == "--warmup"sv) {
+            options.warmup = stoull(value);
+        } else if (name == "--batches"sv) {
+            options.batch_iterations = stoull(value);
+        } else if (name == "--output"sv) {
+            options.output = value;
+        } else {
+            throw invalid_argument("unknown option "s + string(name));
+        }
+    }
+    if (options.workload.document_count == 0 || options.workload.vocabulary_size == 0
+        || options.workload.query_count == 0) {
+        throw invalid_argument("documents, vocabulary and queries must be positive"s);
+    }
+    return options;
+}
+
+using DocumentBatch = vector<tuple<int, string_view, DocumentStatus, vector<int>>>;
+
+DocumentBatch MakeDocumentBatch(const Workload& workload) {
+    DocumentBatch batch;
+    batch.reserve(workload.GetDocuments().size());
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        batch.emplace_back(document.id, document.text, DocumentStatus::ACTUAL, document.ratings);
+    }
+    return batch;
+}
+
+SearchServer MakeServer(const Workload& workload, const DocumentBatch& batch) {
+    SearchServer server(workload.GetStopWords());
+    server.AddDocuments(execution::par, batch);
+    return server;
+}
+
+vector<BenchmarkResult> RunBenchmarks(const Workload& workload, const BenchmarkOptions& options) {
+    const vector<GeneratedDocument>& documents = workload.GetDocuments();
+    const vector<string>& queries = workload.GetQueries();
+    const DocumentBatch batch = MakeDocumentBatch(workload);
+    const size_t document_count = documents.size();
+    const size_t query_count = queries.size();
+    // Разогрев не должен съедать весь набор документов или запросов
+    const size_t document_warmup = min(options.warmup, document_count / 10);
+    const size_t query_warmup = min(options.warmup, query_count / 10);
+    const size_t batch_warmup = 1;
+    vector<BenchmarkResult> results;
+
+    {
+        SearchServer server(workload.GetStopWords());
+        results.push_back(MeasureLatency("AddDocument", document_warmup, document_count - document_warmup,
+                                         [&](size_t i) {
+            server.AddDocument(documents[i].id, documents[i].text, DocumentStatus::ACTUAL, documents[i].ratings);
+        }));
+    }
+    const auto make_empty_server = [&] {
+        return SearchServer(workload.GetStopWords());
+    };
+    results.push_back(MeasureBatch("AddDocuments/seq", batch_warmup, options.batch_iterations, document_count,
+                                   make_empty_server, [&](SearchServer& server) {
+        server.AddDocuments(execution::seq, batch);
+    }));
+    results.push_back(MeasureBatch("AddDocuments/par", batch_warmup, options.batch_iterations, document_count,
+                                   make_empty_server, [&](SearchServer& server) {
+        server.AddDocuments(execution::par, batch);
+    }));
+
+    const SearchServer server = MakeServer(workload, batch);
+    results.push_back(MeasureLatency("FindTopDocuments/seq", query_warmup, query_count - query_warmup,
+                                     [&](size_t i) {
+        server.FindTopDocuments(execution::seq, queries[i]);
+    }));
+    results.push_back(MeasureLatency("FindTopDocuments/par", query_warmup, query_count - query_warmup,
+                                     [&](size_t i) {
+        server.FindTopDocuments(execution::par, queries[i]);
+    }));
+    results.push_back(MeasureLatency("MatchDocument/seq", query_warmup, query_count - query_warmup,
+                                     [&](size_t i) {
+        server.MatchDocument(execution::seq, queries[i], documents[i % document_count].id);
+    }));
+    results.push_back(MeasureLatency("MatchDocument/par", query_warmup, query_count - query_warmup,
+                                     [&](size_t i) {
+        server.MatchDocument(execution::par, queries[i], documents[i % document_count].id);
+    }));
+    results.push_back(MeasureBatch("ProcessQueries", batch_warmup, options.batch_iterations, query_count,
+                                   [] { return 0; }, [&](int) {
+        ProcessQueries(server, queries);
+    }));
+
+    {
+        SearchServer removable = MakeServer(workload, batch);
+        results.push_back(MeasureLatency("RemoveDocument/seq", document_warmup, document_count - document_warmup,
+                                         [&](size_t i) {
+            removable.RemoveDocument(execution::seq, documents[i].id);
+        }));
+    }
+    {
+        SearchServer removable = MakeServer(workload, batch);
+        results.push_back(MeasureLatency("RemoveDocument/par", document_warmup, document_count - document_warmup,
+                                         [&](size_t i) {
+            removable.RemoveDocument(execution::par, documents[i].id);
+        }));
+    }
+    {
+        vector<int> document_ids;
+        for (const GeneratedDocument& document : documents) {
+            document_ids.push_back(document.id);
+        }
+        results.push_back(MeasureBatch("RemoveDocuments/seq", batch_warmup, options.batch_iterations,
+                                       document_count, [&] { return MakeServer(workload, batch); },
+                                       [&](SearchServer& removable) {
+            removable.RemoveDocuments(execution::seq, document_ids);
+        }));
+        results.push_back(MeasureBatch("RemoveDocuments/par", batch_warmup, options.batch_iterations,
+                                       document_count, [&] { return MakeServer(workload, batch); },
+                                       [&](SearchServer& removable) {
+            removable.RemoveDocuments(execution::par, document_ids);
+        }));
+    }
+    results.push_back(MeasureBatch("RemoveDuplicates", batch_warmup, options.batch_iterations, document_count,
+                                   [&] { return MakeServer(workload, batch); }, [](SearchServer& removable) {
+        RemoveDuplicates(removable);
+    }));
+    return results;
+}
+
+} // namespace
+
+// Замеры основных операций сервера на синтетическом корпусе.
+// Отчет в JSON выводится в stdout или в файл --output
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (const exception& e) {
+        cerr << e.what() << '\n';
+        PrintUsage(cerr);
+        return 1;
+    }
+
+    const Workload workload(options.workload);
+    const vector<BenchmarkResult> results = RunBenchmarks(workload, options);
+
+    if (options.output.empty()) {
+        WriteBenchmarkReport(cout, options.workload, results);
+        return 0;
+    }
+    ofstream out(options.output);
+    WriteBenchmarkReport(out, options.workload, results);
+    if (!out) {
+        cerr << "cannot write "s << options.output << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -1,88 +1,412 @@
 #pragma once
 
-#include <cstdlib>
-#include <limits>
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <numeric>
-#include <vector>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+// Хеш-таблица для целочисленных ключей, разбитая на сегменты. Внутри сегмента
+// открытая адресация с линейным пробированием: пары хранятся в одном массиве,
+// поиск не ходит по указателям. Каждый сегмент занимает собственные строки
+// кэша, поэтому потоки, работающие с разными сегментами, не мешают друг другу.
+// Add не берет блокировок: ячейка для нового ключа занимается сравнением
+// с обменом, значение меняется атомарно. Рост таблицы, удаление, доступ
+// через operator[] и выгрузка получают сегмент в монопольное владение,
+// на это время Add в том же сегменте ждет на мьютексе сегмента
 template <typename Key, typename Value>
 class ConcurrentMap {
 public:
     static_assert(std::is_integral_v<Key>, "ConcurrentMap supports only integer keys");
+    static_assert(std::is_arithmetic_v<Value>, "ConcurrentMap supports only arithmetic values");
     class Access;
 
-    explicit ConcurrentMap(const size_t bucket_count) : maps_(bucket_count) {}
+    // Количество сегментов округляется вверх до степени двойки
+    explicit ConcurrentMap(size_t bucket_count);
+
+    // Доступ к значению при монопольном владении сегментом, отсутствующий
+    // ключ добавляется. Значение записывается в таблицу при уничтожении Access
     Access operator[](const Key& key);
+    // Атомарное прибавление к значению ключа без блокировки
+    void Add(const Key& key, const Value& delta);
     void erase(const Key& key);
-    std::map<Key, Value> BuildOrdinaryMap();
+
+    size_t size() const;
+    // Все пары, упорядоченные по ключу. Сегменты копируются параллельно
+    // в заранее выделенный вектор
+    template <typename ExPol>
+    std::vector<std::pair<Key, Value>> Export(ExPol&& ex_po) const;
+    std::vector<std::pair<Key, Value>> Export() const;
+    std::map<Key, Value> BuildOrdinaryMap() const;
 
 private:
-    struct ProtectedMap;
+    static constexpr size_t MIN_SHARD_CAPACITY = 16;
+
+    // Состояния ячейки: свободна, ключ записывается, ключ записан
+    static constexpr uint8_t EMPTY = 0;
+    static constexpr uint8_t BUSY = 1;
+    static constexpr uint8_t READY = 2;
+
+    enum class AddResult {
+        ADDED,
+        // Добавлен новый ключ, таблица заполнена больше чем наполовину
+        ADDED_NEEDS_GROW,
+        BLOCKED
+    };
+
+    struct Slot {
+        std::atomic<uint8_t> state{EMPTY};
+        Key key{};
+        std::atomic<Value> value{};
+    };
+
+    struct alignas(64) Shard {
+        // Упорядочивает монопольные операции над сегментом
+        mutable std::mutex mutex;
+        // Сегмент во владении монопольной операции, Add идет через мьютекс
+        mutable std::atomic<bool> exclusive{false};
+        // Количество Add, работающих с таблицей без блокировки
+        mutable std::atomic<size_t> active_adds{0};
+        std::unique_ptr<Slot[]> slots;
+        size_t capacity = 0;
+        std::atomic<size_t> size{0};
+
+        // Ячейка ключа при монопольном владении, отсутствующий ключ добавляется
+        Slot& FindOrInsert(const Key& key, uint64_t hash);
+        // Прибавление без блокировки. BLOCKED, если сегмент во владении
+        // монопольной операции или в таблице нет свободной ячейки
+        AddResult TryAdd(const Key& key, uint64_t hash, const Value& delta);
+        void Erase(const Key& key, uint64_t hash);
+        void Grow();
+    };
+
+    // Монопольное владение сегментом: дожидается выхода из таблицы
+    // всех Add без блокировки, новые Add идут через мьютекс
+    class ExclusiveLock {
+    public:
+        explicit ExclusiveLock(const Shard& shard);
+        ExclusiveLock(const ExclusiveLock&) = delete;
+        ExclusiveLock& operator=(const ExclusiveLock&) = delete;
+        ~ExclusiveLock();
 
-    std::vector<ProtectedMap> maps_;
-    ProtectedMap& GetProtectedMap(const Key& key);
+    private:
+        const Shard& shard_;
+    };
+
+    std::vector<Shard> shards_;
+    size_t shard_shift_;
+
+    static uint64_t Hash(const Key& key);
+    Shard& GetShard(uint64_t hash);
+    static void AtomicAdd(std::atomic<Value>& value, const Value& delta);
 };
 
 template <typename Key, typename Value>
 class ConcurrentMap<Key, Value>::Access {
 public:
-    Access(Value& value, std::mutex& lck) : ref_to_value_(value),
-                                            lock_mtx_(lck) {}
+    Access(Shard& shard, const Key& key, uint64_t hash)
+        : lock_(shard)
+        , slot_(shard.FindOrInsert(key, hash))
+        , value_(slot_.value.load(std::memory_order_relaxed)) {
+    }
+    Access(const Access&) = delete;
+    Access& operator=(const Access&) = delete;
     ~Access() {
-        lock_mtx_.unlock();
+        slot_.value.store(value_, std::memory_order_relaxed);
     }
 
-    operator Value&();
+    operator Value&() {
+        return value_;
+    }
 
 private:
-    Value& ref_to_value_;
-    std::mutex& lock_mtx_;
+    ExclusiveLock lock_;
+    Slot& slot_;
+    Value value_;
+
+public:
+    Value& ref_to_value = value_;
 };
 
 template <typename Key, typename Value>
-ConcurrentMap<Key, Value>::Access::operator Value&() {
-    return ref_to_value_;
+ConcurrentMap<Key, Value>::ConcurrentMap(size_t bucket_count) {
+    size_t shard_count = 1;
+    size_t shard_bits = 0;
+    while (shard_count < bucket_count) {
+        shard_count <<= 1;
+        ++shard_bits;
+    }
+    shards_ = std::vector<Shard>(shard_count);
+    // Сегмент выбирается по старшим битам хеша, ячейка в сегменте по младшим
+    shard_shift_ = 64 - shard_bits;
 }
 
-template <typename Key, typename Value>
-struct ConcurrentMap<Key, Value>::ProtectedMap {
-    std::map<Key, Value> map_values;
-    std::mutex           mutex_map;
-};
-
-
 template <typename Key, typename Value>
 typename ConcurrentMap<Key, Value>::Access
 ConcurrentMap<Key, Value>::operator[](const Key& key) {
-    auto& prot_map = GetProtectedMap(key);
-    prot_map.mutex_map.lock();
-    return Access(prot_map.map_values[key], prot_map.mutex_map);
+    const uint64_t hash = Hash(key);
+    return Access(GetShard(hash), key, hash);
+}
+
+template <typename Key, typename Value>
+void ConcurrentMap<Key, Value>::Add(const Key& key, const Value& delta) {
+    const uint64_t hash = Hash(key);
+    Shard& shard = GetShard(hash);
+    const AddResult result = shard.TryAdd(key, hash, delta);
+    if (result == AddResult::BLOCKED) {
+        ExclusiveLock lock(shard);
+        AtomicAdd(shard.FindOrInsert(key, hash).value, delta);
+    } else if (result == AddResult::ADDED_NEEDS_GROW) {
+        // Таблица заполняется не более чем наполовину, рост откладывается
+        // до выхода из таблицы, чтобы не ждать самого себя
+        ExclusiveLock lock(shard);
+        if (shard.size.load(std::memory_order_relaxed) * 2 > shard.capacity) {
+            shard.Grow();
+        }
+    }
 }
 
 template <typename Key, typename Value>
 void ConcurrentMap<Key, Value>::erase(const Key& key) {
-    auto& prot_map = GetProtectedMap(key);
-    std::lock_guard<std::mutex> guard(prot_map.mutex_map);
-    prot_map.map_values.erase(key);
+    const uint64_t hash = Hash(key);
+    Shard& shard = GetShard(hash);
+    ExclusiveLock lock(shard);
+    shard.Erase(key, hash);
+}
+
+template <typename Key, typename Value>
+size_t ConcurrentMap<Key, Value>::size() const {
+    size_t result = 0;
+    for (const Shard& shard : shards_) {
+        result += shard.size.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+template <typename Key, typename Value>
+template <typename ExPol>
+std::vector<std::pair<Key, Value>> ConcurrentMap<Key, Value>::Export(ExPol&& ex_po) const {
+    // Сегменты захватываются по порядку, как и одиночными операциями,
+    // поэтому одновременные выгрузки не ждут друг друга по кругу
+    std::vector<std::unique_ptr<ExclusiveLock>> locks;
+    locks.reserve(shards_.size());
+    for (const Shard& shard : shards_) {
+        locks.push_back(std::make_unique<ExclusiveLock>(shard));
+    }
+
+    // Место каждого сегмента в результате по префиксным суммам размеров
+    std::vector<size_t> offsets(shards_.size() + 1, 0);
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        offsets[i + 1] = offsets[i] + shards_[i].size.load(std::memory_order_relaxed);
+    }
+    std::vector<std::pair<Key, Value>> result(offsets.back());
+
+    std::vector<size_t> shard_ids(shards_.size());
+    std::iota(shard_ids.begin(), shard_ids.end(), 0);
+    std::for_each(ex_po, shard_ids.begin(), shard_ids.end(), [this, &offsets, &result](size_t shard_id) {
+        const Shard& shard = shards_[shard_id];
+        auto out = result.begin() + offsets[shard_id];
+        for (size_t pos = 0; pos < shard.capacity; ++pos) {
+            const Slot& slot = shard.slots[pos];
+            if (slot.state.load(std::memory_order_relaxed) == READY) {
+                *out++ = {slot.key, slot.value.load(std::memory_order_relaxed)};
+            }
+        }
+    });
+    locks.clear();
+
+    std::sort(ex_po, result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+    return result;
+}
+
+template <typename Key, typename Value>
+std::vector<std::pair<Key, Value>> ConcurrentMap<Key, Value>::Export() const {
+    return Export(std::execution::seq);
 }
 
 template <typename Key, typename Value>
-std::map<Key, Value> ConcurrentMap<Key, Value>::BuildOrdinaryMap() {
+std::map<Key, Value> ConcurrentMap<Key, Value>::BuildOrdinaryMap() const {
     std::map<Key, Value> result_map;
-    for (auto& m : maps_) {
-        std::lock_guard<std::mutex> guard(m.mutex_map);
-        result_map.insert(m.map_values.begin(), m.map_values.end());
+    for (auto& [key, value] : Export(std::execution::par)) {
+        result_map.emplace_hint(result_map.end(), key, std::move(value));
     }
     return result_map;
 }
 
 template <typename Key, typename Value>
-typename ConcurrentMap<Key, Value>::ProtectedMap&
-ConcurrentMap<Key, Value>::GetProtectedMap(const Key& key) {
-    return maps_[static_cast<uint64_t>(key) % maps_.size()];
+ConcurrentMap<Key, Value>::ExclusiveLock::ExclusiveLock(const Shard& shard)
+    : shard_(shard) {
+    shard_.mutex.lock();
+    // Флаг и счетчик используют последовательную согласованность: либо Add
+    // увидит флаг и уйдет на мьютекс, либо здесь будет виден его счетчик
+    shard_.exclusive.store(true);
+    while (shard_.active_adds.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+template <typename Key, typename Value>
+ConcurrentMap<Key, Value>::ExclusiveLock::~ExclusiveLock() {
+    shard_.exclusive.store(false);
+    shard_.mutex.unlock();
+}
+
+template <typename Key, typename Value>
+typename ConcurrentMap<Key, Value>::AddResult
+ConcurrentMap<Key, Value>::Shard::TryAdd(const Key& key, uint64_t hash, const Value& delta) {
+    active_adds.fetch_add(1);
+    if (exclusive.load() || capacity == 0) {
+        active_adds.fetch_sub(1, std::memory_order_release);
+        return AddResult::BLOCKED;
+    }
+
+    // Ячейки только занимаются, пока в таблице есть Add без блокировки, поэтому
+    // все потоки, добавляющие один ключ, проходят те же ячейки и сходятся в одной
+    AddResult result = AddResult::BLOCKED;
+    const size_t mask = capacity - 1;
+    size_t pos = hash & mask;
+    for (size_t probe = 0; probe < capacity; ++probe, pos = (pos + 1) & mask) {
+        Slot& slot = slots[pos];
+        uint8_t state = slot.state.load(std::memory_order_acquire);
+        if (state == EMPTY && slot.state.compare_exchange_strong(state, BUSY, std::memory_order_acquire)) {
+            slot.key = key;
+            slot.value.store(delta, std::memory_order_relaxed);
+            slot.state.store(READY, std::memory_order_release);
+            const size_t new_size = size.fetch_add(1, std::memory_order_relaxed) + 1;
+            result = new_size * 2 > capacity ? AddResult::ADDED_NEEDS_GROW : AddResult::ADDED;
+            break;
+        }
+        // Ключ в занятую ячейку записывается несколькими инструкциями
+        while (state == BUSY) {
+            std::this_thread::yield();
+            state = slot.state.load(std::memory_order_acquire);
+        }
+        if (slot.key == key) {
+            AtomicAdd(slot.value, delta);
+            result = AddResult::ADDED;
+            break;
+        }
+    }
+    active_adds.fetch_sub(1, std::memory_order_release);
+    return result;
+}
+
+template <typename Key, typename Value>
+typename ConcurrentMap<Key, Value>::Slot&
+ConcurrentMap<Key, Value>::Shard::FindOrInsert(const Key& key, uint64_t hash) {
+    // Таблица заполняется не более чем наполовину
+    if ((size.load(std::memory_order_relaxed) + 1) * 2 > capacity) {
+        Grow();
+    }
+    const size_t mask = capacity - 1;
+    for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+        Slot& slot = slots[pos];
+        if (slot.state.load(std::memory_order_relaxed) == EMPTY) {
+            slot.key = key;
+            slot.value.store(Value{}, std::memory_order_relaxed);
+            slot.state.store(READY, std::memory_order_relaxed);
+            size.fetch_add(1, std::memory_order_relaxed);
+            return slot;
+        }
+        if (slot.key == key) {
+            return slot;
+        }
+    }
+}
+
+template <typename Key, typename Value>
+void ConcurrentMap<Key, Value>::Shard::Erase(const Key& key, uint64_t hash) {
+    if (capacity == 0) {
+        return;
+    }
+    const auto occupied = [this](size_t pos) {
+        return slots[pos].state.load(std::memory_order_relaxed) == READY;
+    };
+    const size_t mask = capacity - 1;
+    size_t pos = hash & mask;
+    for (;; pos = (pos + 1) & mask) {
+        if (!occupied(pos)) {
+            return;
+        }
+        if (slots[pos].key == key) {
+            break;
+        }
+    }
+
+    // Сдвиг следующих элементов цепочки на освободившееся место,
+    // чтобы поиск не прерывался на пустой ячейке
+    size_t hole = pos;
+    for (size_t next = (hole + 1) & mask; occupied(next); next = (next + 1) & mask) {
+        const size_t home = Hash(slots[next].key) & mask;
+        // Элемент можно перенести, если его исходная ячейка не лежит
+        // на циклическом отрезке (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            slots[hole].key = slots[next].key;
+            slots[hole].value.store(slots[next].value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            hole = next;
+        }
+    }
+    slots[hole].state.store(EMPTY, std::memory_order_relaxed);
+    slots[hole].key = Key{};
+    size.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template <typename Key, typename Value>
+void ConcurrentMap<Key, Value>::Shard::Grow() {
+    const size_t new_capacity = std::max(MIN_SHARD_CAPACITY, capacity * 2);
+    std::unique_ptr<Slot[]> new_slots(new Slot[new_capacity]);
+    const size_t mask = new_capacity - 1;
+    for (size_t i = 0; i < capacity; ++i) {
+        const Slot& slot = slots[i];
+        if (slot.state.load(std::memory_order_relaxed) != READY) {
+            continue;
+        }
+        size_t pos = Hash(slot.key) & mask;
+        while (new_slots[pos].state.load(std::memory_order_relaxed) == READY) {
+            pos = (pos + 1) & mask;
+        }
+        new_slots[pos].key = slot.key;
+        new_slots[pos].value.store(slot.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        new_slots[pos].state.store(READY, std::memory_order_relaxed);
+    }
+    slots = std::move(new_slots);
+    capacity = new_capacity;
+}
+
+// Перемешивание splitmix64: соседние ключи попадают в разные сегменты
+template <typename Key, typename Value>
+uint64_t ConcurrentMap<Key, Value>::Hash(const Key& key) {
+    uint64_t hash = static_cast<uint64_t>(key) + 0x9E3779B97F4A7C15ULL;
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+template <typename Key, typename Value>
+typename ConcurrentMap<Key, Value>::Shard&
+ConcurrentMap<Key, Value>::GetShard(uint64_t hash) {
+    // Сдвиг на 64 не определен, единственный сегмент выбирается отдельно
+    return shards_.size() == 1 ? shards_[0] : shards_[hash >> shard_shift_];
+}
+
+template <typename Key, typename Value>
+void ConcurrentMap<Key, Value>::AtomicAdd(std::atomic<Value>& value, const Value& delta) {
+    if constexpr (std::is_integral_v<Value>) {
+        value.fetch_add(delta, std::memory_order_relaxed);
+    } else {
+        // fetch_add для чисел с плавающей точкой появился только в C++20
+        Value current = value.load(std::memory_order_relaxed);
+        while (!value.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+        }
+    }
 }
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Освобождение памяти по эпохам. Читатель на время работы с разделяемыми
+// объектами закрепляет текущую эпоху (Pin) и не берет блокировок. Писатель,
+// заменивший объект, передает старый объект в Retire: объект удаляется, когда
+// завершатся все чтения, начатые до замены
+class EpochReclaimer {
+public:
+    // Количество ячеек читателей. Читатели, которым не хватило ячейки, не ждут:
+    // они учитываются в общем счетчике вместе с наименьшей своей эпохой
+    static constexpr size_t MAX_READERS = 128;
+
+private:
+    static constexpr uint64_t IDLE = std::numeric_limits<uint64_t>::max();
+
+    // Общий счетчик: количество читателей в младших битах, наименьшая
+    // их эпоха в старших 40 битах. Оба поля меняются одной операцией,
+    // поэтому Reclaim не увидит читателей без эпохи
+    static constexpr int OVERFLOW_COUNT_BITS = 24;
+    static constexpr uint64_t OVERFLOW_COUNT_MASK = (uint64_t{1} << OVERFLOW_COUNT_BITS) - 1;
+    static constexpr uint64_t OVERFLOW_IDLE_EPOCH = IDLE >> OVERFLOW_COUNT_BITS;
+
+    // Ячейка читателя занимает собственную строку кэша
+    struct alignas(64) Slot {
+        std::atomic<bool> busy{false};
+        std::atomic<uint64_t> epoch{IDLE};
+    };
+
+public:
+    // Закрепление эпохи, действует до разрушения объекта
+    class Guard {
+    public:
+        explicit Guard(Slot* slot) : slot_(slot) {
+        }
+        // Читатель, учтенный в общем счетчике
+        explicit Guard(EpochReclaimer* overflow) : overflow_(overflow) {
+        }
+        Guard(Guard&& other) noexcept
+            : slot_(std::exchange(other.slot_, nullptr))
+            , overflow_(std::exchange(other.overflow_, nullptr)) {
+        }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        Guard& operator=(Guard&&) = delete;
+        ~Guard() {
+            if (slot_ != nullptr) {
+                slot_->epoch.store(IDLE, std::memory_order_release);
+                slot_->busy.store(false, std::memory_order_release);
+            }
+            if (overflow_ != nullptr) {
+                overflow_->LeaveOverflow();
+            }
+        }
+
+    private:
+        Slot* slot_ = nullptr;
+        EpochReclaimer* overflow_ = nullptr;
+    };
+
+    EpochReclaimer() = default;
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+    // Вызывается, когда закрепленных читателей не осталось
+    ~EpochReclaimer() {
+        for (auto& [epoch, deleter] : retired_) {
+            deleter();
+        }
+    }
+
+    // Закрепление текущей эпохи. Указатели на разделяемые объекты
+    // нужно читать после вызова Pin. Каждая ячейка пробуется один раз,
+    // при занятых ячейках читатель учитывается в общем счетчике
+    Guard Pin() {
+        thread_local const size_t hint = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        for (size_t attempt = 0; attempt < MAX_READERS; ++attempt) {
+            Slot& slot = slots_[(hint + attempt) % MAX_READERS];
+            if (!slot.busy.load(std::memory_order_relaxed)
+                && !slot.busy.exchange(true, std::memory_order_acquire)) {
+                // Последовательная согласованность записи эпохи и последующего
+                // чтения указателя гарантирует, что писатель либо увидит
+                // эпоху читателя, либо читатель увидит новый указатель
+                slot.epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+                return Guard(&slot);
+            }
+        }
+        JoinOverflow();
+        return Guard(this);
+    }
+
+    // Передача объекта, который уже недоступен новым читателям
+    template <typename T>
+    void Retire(const T* object) {
+        if (object != nullptr) {
+            Retire(std::function<void()>([object] {
+                delete object;
+            }));
+        }
+    }
+    void Retire(std::function<void()> deleter) {
+        const uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst);
+        std::lock_guard lock(retired_mutex_);
+        retired_.emplace_back(epoch, std::move(deleter));
+    }
+
+    // Удаление объектов, которые не может видеть ни один закрепленный читатель
+    void Reclaim() {
+        uint64_t min_epoch = IDLE;
+        for (const Slot& slot : slots_) {
+            min_epoch = std::min(min_epoch, slot.epoch.load(std::memory_order_seq_cst));
+        }
+        if (const uint64_t overflow = overflow_.load(std::memory_order_seq_cst);
+            (overflow & OVERFLOW_COUNT_MASK) != 0) {
+            min_epoch = std::min(min_epoch, overflow >> OVERFLOW_COUNT_BITS);
+        }
+
+        std::vector<std::function<void()>> deleters;
+        {
+            std::lock_guard lock(retired_mutex_);
+            const auto it = std::partition(retired_.begin(), retired_.end(), [min_epoch](const auto& retired) {
+                return retired.first >= min_epoch;
+            });
+            for (auto reclaimed = it; reclaimed != retired_.end(); ++reclaimed) {
+                deleters.push_back(std::move(reclaimed->second));
+            }
+            retired_.erase(it, retired_.end());
+        }
+        for (auto& deleter : deleters) {
+            deleter();
+        }
+    }
+
+private:
+    std::array<Slot, MAX_READERS> slots_;
+    alignas(64) std::atomic<uint64_t> overflow_{OVERFLOW_IDLE_EPOCH << OVERFLOW_COUNT_BITS};
+    alignas(64) std::atomic<uint64_t> epoch_{0};
+    std::mutex retired_mutex_;
+    std::vector<std::pair<uint64_t, std::function<void()>>> retired_;
+
+    // Эпоха, прочитанная до изменения счетчика, не больше текущей, поэтому
+    // наименьшая эпоха счетчика защищает все, что могут видеть его читатели
+    void JoinOverflow() {
+        const uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+        uint64_t current = overflow_.load(std::memory_order_relaxed);
+        uint64_t updated;
+        do {
+            const uint64_t min_epoch = std::min(current >> OVERFLOW_COUNT_BITS, epoch);
+            updated = (min_epoch << OVERFLOW_COUNT_BITS) | ((current & OVERFLOW_COUNT_MASK) + 1);
+        } while (!overflow_.compare_exchange_weak(current, updated, std::memory_order_seq_cst));
+    }
+
+    // Последний вышедший читатель сбрасывает эпоху счетчика. Пока в счетчике
+    // есть читатели, эпоха остается наименьшей из их эпох, даже если читатель
+    // с этой эпохой уже вышел
+    void LeaveOverflow() {
+        uint64_t current = overflow_.load(std::memory_order_relaxed);
+        uint64_t updated;
+        do {
+            const uint64_t count = (current & OVERFLOW_COUNT_MASK) - 1;
+            updated = count == 0 ? OVERFLOW_IDLE_EPOCH << OVERFLOW_COUNT_BITS
+                                 : (current & ~OVERFLOW_COUNT_MASK) | count;
+        } while (!overflow_.compare_exchange_weak(current, updated, std::memory_order_seq_cst));
+    }
+};
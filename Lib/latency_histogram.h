@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Снимок гистограммы: количество значений в каждой ячейке
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::vector<uint64_t> buckets;
+
+    double Mean() const noexcept {
+        return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+    }
+    // Значение, не превышаемое долей quantile значений, с точностью до ширины ячейки
+    uint64_t Percentile(double quantile) const noexcept;
+};
+
+// Гистограмма целых неотрицательных значений (длительностей в наносекундах)
+// с логарифмически-линейными ячейками, как в HdrHistogram: каждая степень
+// двойки делится на 16 равных ячеек, поэтому относительная погрешность
+// не больше 1/16 во всем диапазоне 64-битных значений.
+// Запись не использует блокировок: потоки пишут в разные сегменты,
+// выбираемые по номеру потока, счетчики сегмента атомарные
+class LatencyHistogram {
+public:
+    static constexpr size_t SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKET_COUNT = size_t{1} << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKET_COUNT * (64 - SUB_BUCKET_BITS + 1);
+    static constexpr size_t SHARD_COUNT = 8;
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(uint64_t value) noexcept {
+        Shard& shard = shards_[GetShardIndex()];
+        shard.buckets[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = shard.max.load(std::memory_order_relaxed);
+        while (value > max && !shard.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Сумма сегментов. Записи, выполняемые во время снимка, могут
+    // попасть в него частично
+    HistogramSnapshot Snapshot() const {
+        HistogramSnapshot snapshot;
+        snapshot.buckets.assign(BUCKET_COUNT, 0);
+        for (const Shard& shard : shards_) {
+            for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+                snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+            }
+            snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+            snapshot.max = std::max(snapshot.max, shard.max.load(std::memory_order_relaxed));
+        }
+        // Количество считается по ячейкам, чтобы совпадать с ними
+        for (const uint64_t bucket : snapshot.buckets) {
+            snapshot.count += bucket;
+        }
+        return snapshot;
+    }
+
+    void Reset() noexcept {
+        for (Shard& shard : shards_) {
+            for (auto& bucket : shard.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            shard.sum.store(0, std::memory_order_relaxed);
+            shard.max.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static size_t GetBucketIndex(uint64_t value) noexcept {
+        if (value < SUB_BUCKET_COUNT) {
+            return static_cast<size_t>(value);
+        }
+        const size_t exponent = HighestBit(value);
+        const size_t shift = exponent - SUB_BUCKET_BITS;
+        // Старшие SUB_BUCKET_BITS бит после ведущей единицы
+        const size_t sub_bucket = static_cast<size_t>(value >> shift) - SUB_BUCKET_COUNT;
+        return SUB_BUCKET_COUNT * (shift + 1) + sub_bucket;
+    }
+    // Наименьшее значение ячейки и количество значений в ней
+    static uint64_t GetBucketLowerBound(size_t index) noexcept {
+        if (index < SUB_BUCKET_COUNT) {
+            return index;
+        }
+        const size_t shift = index / SUB_BUCKET_COUNT - 1;
+        return (SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT) << shift;
+    }
+    static uint64_t GetBucketWidth(size_t index) noexcept {
+        return index < SUB_BUCKET_COUNT ? 1 : uint64_t{1} << (index / SUB_BUCKET_COUNT - 1);
+    }
+
+    // Потоки получают сегменты по кругу в порядке первого обращения
+    static size_t GetShardIndex() noexcept {
+        static std::atomic<size_t> next_index{0};
+        thread_local const size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+        return index;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+    };
+
+    std::array<Shard, SHARD_COUNT> shards_;
+
+    static size_t HighestBit(uint64_t value) noexcept {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(value);
+#else
+        size_t bit = 0;
+        while (value >>= 1) {
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+};
+
+// Счетчик, разбитый на сегменты так же, как LatencyHistogram
+class ShardedCounter {
+public:
+    void Add(uint64_t value) noexcept {
+        shards_[LatencyHistogram::GetShardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+    uint64_t Get() const noexcept {
+        uint64_t result = 0;
+        for (const Shard& shard : shards_) {
+            result += shard.value.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+    void Reset() noexcept {
+        for (Shard& shard : shards_) {
+            shard.value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, LatencyHistogram::SHARD_COUNT> shards_;
+};
+
+inline uint64_t HistogramSnapshot::Percentile(double quantile) const noexcept {
+    if (count == 0) {
+        return 0;
+    }
+    const double clamped = std::clamp(quantile, 0.0, 1.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped * count + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // Середина ячейки, но не больше наибольшего записанного значения
+            const uint64_t lower = LatencyHistogram::GetBucketLowerBound(i);
+            return std::min(max, lower + (LatencyHistogram::GetBucketWidth(i) - 1) / 2);
+        }
+    }
+    return max;
+}
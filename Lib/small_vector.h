@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// Вектор простых значений, первые N элементов которого хранятся внутри
+// объекта. Память в куче выделяется только при превышении N
+template <typename T, size_t N>
+class SmallVector {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector supports only trivially copyable types");
+
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+    SmallVector(const SmallVector& other) {
+        *this = other;
+    }
+    SmallVector(SmallVector&& other) noexcept {
+        *this = std::move(other);
+    }
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            clear();
+            reserve(other.size_);
+            std::copy(other.begin(), other.end(), data());
+            size_ = other.size_;
+        }
+        return *this;
+    }
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            if (other.heap_) {
+                heap_ = std::move(other.heap_);
+                capacity_ = other.capacity_;
+            } else {
+                heap_.reset();
+                capacity_ = N;
+                std::copy(other.begin(), other.end(), inline_);
+            }
+            size_ = other.size_;
+            other.size_ = 0;
+            other.capacity_ = N;
+        }
+        return *this;
+    }
+
+    void push_back(const T& value) {
+        if (size_ == capacity_) {
+            reserve(capacity_ * 2);
+        }
+        data()[size_++] = value;
+    }
+    void reserve(size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        std::unique_ptr<T[]> heap(new T[capacity]);
+        std::copy(begin(), end(), heap.get());
+        heap_ = std::move(heap);
+        capacity_ = capacity;
+    }
+    // Уменьшение размера, память не освобождается
+    void erase(iterator first, iterator last) noexcept {
+        std::copy(last, end(), first);
+        size_ -= last - first;
+    }
+    void clear() noexcept {
+        size_ = 0;
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+    // Хранятся ли элементы во встроенном буфере
+    bool IsInline() const noexcept {
+        return !heap_;
+    }
+
+    T* data() noexcept {
+        return heap_ ? heap_.get() : inline_;
+    }
+    const T* data() const noexcept {
+        return heap_ ? heap_.get() : inline_;
+    }
+    T& operator[](size_t index) noexcept {
+        return data()[index];
+    }
+    const T& operator[](size_t index) const noexcept {
+        return data()[index];
+    }
+    iterator begin() noexcept {
+        return data();
+    }
+    iterator end() noexcept {
+        return data() + size_;
+    }
+    const_iterator begin() const noexcept {
+        return data();
+    }
+    const_iterator end() const noexcept {
+        return data() + size_;
+    }
+
+    bool operator==(const SmallVector& other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+private:
+    T inline_[N];
+    std::unique_ptr<T[]> heap_;
+    size_t size_ = 0;
+    size_t capacity_ = N;
+};
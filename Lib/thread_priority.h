@@ -0,0 +1,17 @@
+#pragma once
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#define THREAD_PRIORITY_USE_SCHED_IDLE
+#endif
+
+// Перевод вызывающего потока в наименьший приоритет: поток получает
+// процессор, только когда он не нужен остальным потокам. Где такого класса
+// планирования нет, приоритет не меняется
+inline void SetIdleThreadPriority() {
+#ifdef THREAD_PRIORITY_USE_SCHED_IDLE
+    sched_param param{};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Ограниченная куча для отбора K лучших элементов.
+// Better(a, b) возвращает true, если a лучше b. В вершине кучи хранится
+// худший из отобранных элементов, поэтому каждая вставка стоит O(log K)
+template <typename T, typename Better>
+class TopKHeap {
+public:
+    explicit TopKHeap(size_t k, Better better = Better{}) : k_(k), better_(better) {
+        heap_.reserve(k);
+    }
+
+    void Push(T value);
+    // Перенос элементов другой кучи
+    void Merge(TopKHeap&& other);
+
+    bool Full() const noexcept {
+        return heap_.size() == k_;
+    }
+    size_t size() const noexcept {
+        return heap_.size();
+    }
+    // Худший из отобранных элементов, куча не должна быть пустой
+    const T& Worst() const {
+        return heap_.front();
+    }
+
+    // Отобранные элементы, упорядоченные от лучшего к худшему
+    std::vector<T> TakeSorted();
+
+private:
+    size_t k_;
+    Better better_;
+    std::vector<T> heap_;
+};
+
+template <typename T, typename Better>
+void TopKHeap<T, Better>::Push(T value) {
+    if (heap_.size() < k_) {
+        heap_.push_back(std::move(value));
+        std::push_heap(heap_.begin(), heap_.end(), better_);
+    } else if (k_ > 0 && better_(value, heap_.front())) {
+        std::pop_heap(heap_.begin(), heap_.end(), better_);
+        heap_.back() = std::move(value);
+        std::push_heap(heap_.begin(), heap_.end(), better_);
+    }
+}
+
+template <typename T, typename Better>
+void TopKHeap<T, Better>::Merge(TopKHeap&& other) {
+    for (T& value : other.heap_) {
+        Push(std::move(value));
+    }
+    other.heap_.clear();
+}
+
+template <typename T, typename Better>
+std::vector<T> TopKHeap<T, Better>::TakeSorted() {
+    std::sort_heap(heap_.begin(), heap_.end(), better_);
+    return std::move(heap_);
+}
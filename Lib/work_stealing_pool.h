@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Пул потоков с перехватом задач. У каждого исполнителя своя очередь:
+// новые задачи исполнитель берет с конца своей очереди, а освободившиеся
+// исполнители забирают задачи с начала чужих очередей.
+// Поток, вызвавший ParallelFor, сам является одним из исполнителей и, пока
+// ждет завершения, выполняет задачи пула. Поэтому вложенные ParallelFor
+// не блокируют исполнителей и не создают новых потоков
+class WorkStealingPool {
+public:
+    // Политика выполнения для алгоритмов сервера, поддерживающих пул
+    struct Policy {
+        WorkStealingPool* pool;
+    };
+
+    // worker_count - число одновременно работающих потоков вместе
+    // с вызывающим, 0 - по числу ядер
+    explicit WorkStealingPool(size_t worker_count = 0)
+        : worker_count_(worker_count != 0 ? worker_count
+                                          : std::max(1u, std::thread::hardware_concurrency()))
+        , queues_(worker_count_) {
+        threads_.reserve(worker_count_ - 1);
+        for (size_t index = 0; index + 1 < worker_count_; ++index) {
+            threads_.emplace_back([this, index] {
+                WorkerLoop(index);
+            });
+        }
+    }
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    ~WorkStealingPool() {
+        {
+            std::lock_guard lock(sleep_mutex_);
+            stop_ = true;
+        }
+        wake_up_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    size_t WorkerCount() const noexcept {
+        return worker_count_;
+    }
+    Policy GetPolicy() noexcept {
+        return Policy{this};
+    }
+
+    // Вызов func(i) для i из [0, count). Возвращает управление после
+    // завершения всех вызовов, первое исключение передается вызывающему
+    template <typename Func>
+    void ParallelFor(size_t count, Func func) {
+        if (count == 0) {
+            return;
+        }
+        if (count == 1 || worker_count_ == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                func(i);
+            }
+            return;
+        }
+
+        struct State {
+            std::atomic<size_t> remaining;
+            std::mutex error_mutex;
+            std::exception_ptr error;
+        } state;
+        state.remaining.store(count, std::memory_order_relaxed);
+
+        // Задачи кладутся в обратном порядке, чтобы вызывающий поток,
+        // забирающий задачи с конца своей очереди, начал с первой
+        const size_t own = OwnQueue();
+        for (size_t i = count; i-- > 1;) {
+            Push(own, [&state, &func, i] {
+                try {
+                    func(i);
+                } catch (...) {
+                    std::lock_guard lock(state.error_mutex);
+                    if (!state.error) {
+                        state.error = std::current_exception();
+                    }
+                }
+                // Последнее обращение к состоянию: после него вызывающий
+                // поток может выйти из ParallelFor
+                state.remaining.fetch_sub(1, std::memory_order_acq_rel);
+            });
+        }
+        try {
+            func(0);
+        } catch (...) {
+            std::lock_guard lock(state.error_mutex);
+            if (!state.error) {
+                state.error = std::current_exception();
+            }
+        }
+        state.remaining.fetch_sub(1, std::memory_order_acq_rel);
+
+        while (state.remaining.load(std::memory_order_acquire) != 0) {
+            if (!TryRunTask(own)) {
+                std::this_thread::yield();
+            }
+        }
+        if (state.error) {
+            std::rethrow_exception(state.error);
+        }
+    }
+
+private:
+    struct alignas(64) TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    const size_t worker_count_;
+    // Очереди фоновых потоков и последняя общая очередь внешних потоков
+    std::vector<TaskQueue> queues_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<size_t> queued_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_up_;
+    bool stop_ = false;
+
+    struct WorkerIdentity {
+        const WorkStealingPool* pool = nullptr;
+        size_t index = 0;
+    };
+    static WorkerIdentity& CurrentWorker() {
+        thread_local WorkerIdentity identity;
+        return identity;
+    }
+
+    size_t OwnQueue() const {
+        const WorkerIdentity& worker = CurrentWorker();
+        return worker.pool == this ? worker.index : worker_count_ - 1;
+    }
+
+    void Push(size_t queue_index, std::function<void()> task) {
+        {
+            TaskQueue& queue = queues_[queue_index];
+            std::lock_guard lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        queued_.fetch_add(1, std::memory_order_release);
+        // Блокировка исключает потерю пробуждения между проверкой
+        // условия и засыпанием исполнителя
+        {
+            std::lock_guard lock(sleep_mutex_);
+        }
+        wake_up_.notify_one();
+    }
+
+    // Задача из своей очереди, иначе перехваченная из чужой
+    bool TryRunTask(size_t own) {
+        std::function<void()> task;
+        {
+            TaskQueue& queue = queues_[own];
+            std::lock_guard lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+        }
+        for (size_t shift = 1; !task && shift < queues_.size(); ++shift) {
+            TaskQueue& queue = queues_[(own + shift) % queues_.size()];
+            std::lock_guard lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+        if (!task) {
+            return false;
+        }
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        task();
+        return true;
+    }
+
+    void WorkerLoop(size_t index) {
+        CurrentWorker() = WorkerIdentity{this, index};
+        while (true) {
+            if (TryRunTask(index)) {
+                continue;
+            }
+            std::unique_lock lock(sleep_mutex_);
+            wake_up_.wait(lock, [this] {
+                return stop_ || queued_.load(std::memory_order_acquire) != 0;
+            });
+            if (stop_ && queued_.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+};
@@ -3,32 +3,97 @@ CONFIG += console c++17 thread
 CONFIG -= app_bundle
 CONFIG -= qt
 
+# Сбор статистики этапов запросов (query_stats.h) включается
+# в сборке SearchServer_query_stats.pro
+
 SOURCES += \
+        Tests/add_documents_par.cpp \
+        Tests/conc_map.cpp \
+        Tests/dedup.cpp \
+        Tests/doc_texts.cpp \
         Tests/find_top_docs_par.cpp \
+        Tests/match_batch.cpp \
         Tests/match_doc_par.cpp \
+        Tests/op_metrics.cpp \
+        Tests/prepared.cpp \
         Tests/proc_queries.cpp \
+        Tests/query_exec.cpp \
+        Tests/query_trace.cpp \
+        Tests/remove_batch.cpp \
         Tests/removed_doc_par.cpp \
+        Tests/req_queue.cpp \
+        Tests/result_cache.cpp \
+        Tests/segments.cpp \
+        Tests/snapshot.cpp \
+        Tests/workload.cpp \
         document.cpp \
+        document_store.cpp \
+        inverted_index.cpp \
+        term_dictionary.cpp \
         main.cpp \
+        matched_documents.cpp \
+        metrics.cpp \
+        prepared_query.cpp \
         process_queries.cpp \
+        query_cache.cpp \
+        query_executor.cpp \
+        query_stats.cpp \
         read_input_functions.cpp \
         remove_duplicates.cpp \
         request_queue.cpp \
         search_server.cpp \
-        string_processing.cpp
+        segmented_index.cpp \
+        snapshot_file.cpp \
+        string_processing.cpp \
+        versioned_search_server.cpp
 
 HEADERS += \
     Lib/concurrent_map.h \
+    Lib/epoch_reclaimer.h \
+    Lib/latency_histogram.h \
+    Lib/small_vector.h \
+    Lib/thread_priority.h \
+    Lib/top_k_heap.h \
+    Lib/work_stealing_pool.h \
+    Tests/add_documents_par.h \
+    Tests/conc_map.h \
+    Tests/dedup.h \
+    Tests/doc_texts.h \
     Tests/log_duration.h \
     Tests/finde_top_docs_par.h \
+    Tests/legacy_concurrent_map.h \
+    Tests/match_batch.h \
     Tests/match_doc_par.h \
+    Tests/op_metrics.h \
+    Tests/prepared.h \
     Tests/proc_queries.h \
+    Tests/query_exec.h \
+    Tests/query_trace.h \
+    Tests/remove_batch.h \
     Tests/removed_doc_par.h \
+    Tests/req_queue.h \
+    Tests/result_cache.h \
+    Tests/segments.h \
+    Tests/snapshot.h \
+    Tests/workload.h \
     document.h \
+    document_store.h \
+    inverted_index.h \
+    matched_documents.h \
+    metrics.h \
     paginator.h \
+    prepared_query.h \
     process_queries.h \
+    query_cache.h \
+    query_executor.h \
+    query_stats.h \
     read_input_functions.h \
+    relevance_accumulator.h \
     remove_duplicates.h \
     request_queue.h \
     search_server.h \
-    string_processing.h
+    segmented_index.h \
+    snapshot_file.h \
+    string_processing.h \
+    term_dictionary.h \
+    versioned_search_server.h
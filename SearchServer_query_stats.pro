@@ -0,0 +1,6 @@
+# Сборка тестов со сбором статистики этапов запросов (query_stats.h).
+# Проверяет статистику в TestsQueryStats, которая без макроса не собирается
+include(SearchServer.pro)
+
+TARGET = SearchServer_query_stats
+DEFINES += SEARCH_SERVER_QUERY_STATS
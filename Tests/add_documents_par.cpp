@@ -0,0 +1,100 @@
+#include "add_documents_par.h"
+
+#include "log_duration.h"
+#include "search_server.h"
+#include "workload.h"
+
+#include <execution>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+void TestWorkParAdd();
+void TestTimeWorkAdd();
+
+void TestsAddDocumentsPar() {
+    cout << "TestsAddDocumentsPar"s << endl;
+    TestWorkParAdd();
+    TestTimeWorkAdd();
+    cout << endl;
+}
+
+void TestWorkParAdd() {
+    SearchServer search_server("and with"s);
+
+    const vector<tuple<int, string, DocumentStatus, vector<int>>> documents = {
+        {1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7}},
+        {2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2}},
+        {3, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, {1, 2, 8}},
+        {4, "pet with rat and rat and rat"s, DocumentStatus::BANNED, {1, 2}},
+        {5, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, {1, 2}},
+    };
+    search_server.AddDocuments(execution::par, documents);
+
+    const string query = "curly and funny -not"s;
+    cout << search_server.GetDocumentCount() << " documents total, "s
+         << search_server.FindTopDocuments(query).size() << " documents for query ["s << query << "]"s << endl;
+    // 5 documents total, 3 documents for query [curly and funny -not]
+
+    // Повторяющийся id: набор не добавляется целиком
+    try {
+        search_server.AddDocuments(vector<tuple<int, string, DocumentStatus, vector<int>>>{
+            {6, "big dog"s, DocumentStatus::ACTUAL, {1}},
+            {3, "small dog"s, DocumentStatus::ACTUAL, {1}},
+        });
+    } catch (const invalid_argument&) {
+        cout << "Duplicate id rejected, "s << search_server.GetDocumentCount() << " documents total"s << endl;
+    }
+
+    // Недопустимый символ: набор не добавляется целиком
+    try {
+        search_server.AddDocuments(execution::par, vector<tuple<int, string, DocumentStatus, vector<int>>>{
+            {6, "big dog"s, DocumentStatus::ACTUAL, {1}},
+            {7, "small d\x12og"s, DocumentStatus::ACTUAL, {1}},
+        });
+    } catch (const invalid_argument&) {
+        cout << "Invalid word rejected, "s << search_server.GetDocumentCount() << " documents total"s << endl;
+    }
+}
+
+template <typename ExecutionPolicy>
+void TestAdd(string_view mark, const string& stop_words,
+             const vector<tuple<int, string, DocumentStatus, vector<int>>>& documents,
+             ExecutionPolicy&& policy) {
+    LOG_DURATION(mark);
+    SearchServer search_server(stop_words);
+    search_server.AddDocuments(policy, documents);
+    cout << search_server.GetDocumentCount() << endl;
+}
+
+#define TEST_ADD(policy) TestAdd(#policy, workload.GetStopWords(), documents, execution::policy)
+
+void TestTimeWorkAdd() {
+    WorkloadOptions options;
+    options.document_count = 100'000;
+    options.vocabulary_size = 10'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 1;
+    options.max_document_words = 100;
+    options.query_count = 0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+    vector<tuple<int, string, DocumentStatus, vector<int>>> documents;
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        documents.push_back({document.id, document.text, DocumentStatus::ACTUAL, document.ratings});
+    }
+
+    {
+        LOG_DURATION("AddDocument"sv);
+        SearchServer search_server(workload.GetStopWords());
+        for (const auto& [id, text, status, ratings] : documents) {
+            search_server.AddDocument(id, text, status, ratings);
+        }
+        cout << search_server.GetDocumentCount() << endl;
+    }
+    TEST_ADD(seq);
+    TEST_ADD(par);
+}
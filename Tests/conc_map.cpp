@@ -0,0 +1,146 @@
+#include "conc_map.h"
+
+#include "legacy_concurrent_map.h"
+#include "log_duration.h"
+#include "../Lib/concurrent_map.h"
+
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+void TestWorkConcurrentMap();
+void TestTimeWorkConcurrentMap();
+
+void TestsConcurrentMap() {
+    cout << "TestsConcurrentMap"s << endl;
+    TestWorkConcurrentMap();
+    TestTimeWorkConcurrentMap();
+    cout << endl;
+}
+
+void TestWorkConcurrentMap() {
+    // Суммы, накопленные несколькими потоками, совпадают с последовательными
+    const int thread_count = 4;
+    const int key_count = 1000;
+    ConcurrentMap<int, long long> map(8);
+    vector<thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&map, t] {
+            for (int key = 0; key < key_count; ++key) {
+                map.Add(key, key + t);
+            }
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    for (int key = 0; key < key_count; key += 3) {
+        map.erase(key);
+    }
+    map[-5].ref_to_value = 7;
+    map[2].ref_to_value += 1;
+
+    const auto items = map.Export(execution::par);
+    bool correct = items.size() == map.size();
+    for (const auto& [key, value] : items) {
+        if (key >= 0) {
+            correct = correct && key % 3 != 0
+                      && value == 4LL * key + 6 + (key == 2 ? 1 : 0);
+        }
+    }
+    const auto ordinary_map = map.BuildOrdinaryMap();
+    cout << items.size() << " "s << ordinary_map.begin()->first << " "s << ordinary_map.at(-5) << " "s
+         << ordinary_map.at(2) << " "s << (correct ? "ok"s : "mismatch"s) << endl;
+
+    // Add без блокировки одновременно с монопольными operator[], erase
+    // и выгрузкой: ни одно прибавление не теряется
+    ConcurrentMap<int, double> mixed_map(4);
+    vector<thread> adders;
+    for (int t = 0; t < thread_count; ++t) {
+        adders.emplace_back([&mixed_map] {
+            for (int i = 0; i < 100'000; ++i) {
+                mixed_map.Add(i % key_count, 0.5);
+            }
+        });
+    }
+    for (int i = 0; i < 2'000; ++i) {
+        static_cast<double&>(mixed_map[key_count + i]) += 1.0;
+        if (i > 0) {
+            mixed_map.erase(key_count + i - 1);
+        }
+        if (i % 100 == 0) {
+            mixed_map.Export();
+        }
+    }
+    for (thread& worker : adders) {
+        worker.join();
+    }
+    double sum = 0;
+    for (const auto& [key, value] : mixed_map.Export(execution::par)) {
+        sum += value;
+    }
+    cout << mixed_map.size() << " "s << sum << endl;
+}
+
+template <typename Map, typename AddFunc>
+void RunContention(string_view mark, const vector<int>& keys, int thread_count, AddFunc add) {
+    Map map(100);
+    {
+        LOG_DURATION(mark);
+        vector<thread> threads;
+        for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&map, &keys, &add, t, thread_count] {
+                for (size_t i = t; i < keys.size(); i += thread_count) {
+                    add(map, keys[i]);
+                }
+            });
+        }
+        for (thread& worker : threads) {
+            worker.join();
+        }
+    }
+    double sum = 0;
+    for (const auto& [key, value] : map.BuildOrdinaryMap()) {
+        sum += value;
+    }
+    cout << sum << endl;
+}
+
+void TestTimeWorkConcurrentMap() {
+    // Ключи распределены неравномерно, как номера документов в запросах
+    mt19937 generator;
+    vector<int> keys(2'000'000);
+    for (int& key : keys) {
+        key = static_cast<int>(uniform_int_distribution(0, 100'000)(generator)
+                               * uniform_int_distribution(0, 1)(generator)
+                               + uniform_int_distribution(0, 1'000)(generator));
+    }
+
+    RunContention<LegacyConcurrentMap<int, double>>("LegacyConcurrentMap"sv, keys, 8,
+                                                    [](auto& map, int key) {
+        static_cast<double&>(map[key]) += 0.5;
+    });
+    RunContention<ConcurrentMap<int, double>>("ConcurrentMap"sv, keys, 8, [](auto& map, int key) {
+        map.Add(key, 0.5);
+    });
+
+    LegacyConcurrentMap<int, double> legacy_map(100);
+    ConcurrentMap<int, double> map(100);
+    for (int key : keys) {
+        static_cast<double&>(legacy_map[key]) += 0.5;
+        map.Add(key, 0.5);
+    }
+    {
+        LOG_DURATION("LegacyConcurrentMap BuildOrdinaryMap"sv);
+        cout << legacy_map.BuildOrdinaryMap().size() << endl;
+    }
+    {
+        LOG_DURATION("ConcurrentMap Export"sv);
+        cout << map.Export(execution::par).size() << endl;
+    }
+}
@@ -0,0 +1,197 @@
+#include "dedup.h"
+
+#include "log_duration.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+#include "string_processing.h"
+#include "workload.h"
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void TestWorkRemoveDuplicates();
+void TestTimeWorkRemoveDuplicates();
+void TestWorkNearDuplicates();
+void TestTimeWorkNearDuplicates();
+
+void TestsRemoveDuplicates() {
+    cout << "TestsRemoveDuplicates"s << endl;
+    TestWorkRemoveDuplicates();
+    TestTimeWorkRemoveDuplicates();
+    TestWorkNearDuplicates();
+    TestTimeWorkNearDuplicates();
+    cout << endl;
+}
+
+// Прежняя реализация: набор слов каждого документа - ключ упорядоченного словаря
+void RemoveDuplicatesByMap(SearchServer& search_server) {
+    map<vector<TermId>, set<int>> words_in_documents;
+    for (auto it = search_server.begin(); it != search_server.end(); ++it) {
+        vector<TermId> words_in_document;
+        for (const auto& [term, freq] : search_server.GetDocumentTerms(*it)) {
+            words_in_document.push_back(term);
+        }
+        words_in_documents[words_in_document].insert(*it);
+    }
+    for (const auto& [words, ids] : words_in_documents) {
+        for (auto it = next(ids.begin()); it != ids.end(); ++it) {
+            search_server.RemoveDocument(*it);
+        }
+    }
+}
+
+void TestWorkRemoveDuplicates() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    // дубликат документа 2, будет удалён
+    search_server.AddDocument(3, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    // отличие только в стоп-словах, считаем дубликатом
+    search_server.AddDocument(4, "funny pet and curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    // множество слов такое же, считаем дубликатом документа 1
+    search_server.AddDocument(5, "funny funny pet and nasty nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    // добавились новые слова, дубликатом не является
+    search_server.AddDocument(6, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    // множество слов такое же, как в id 6, несмотря на другой порядок, считаем дубликатом
+    search_server.AddDocument(7, "very nasty rat and not very funny pet"s, DocumentStatus::ACTUAL, {1, 2});
+    // есть не все слова, не является дубликатом
+    search_server.AddDocument(8, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, {1, 2});
+    // слова из разных документов, не является дубликатом
+    search_server.AddDocument(9, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    // только стоп-слова, дубликат документа 11
+    search_server.AddDocument(10, "and with"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(11, "with and with"s, DocumentStatus::ACTUAL, {1});
+
+    cout << "Before duplicates removed: "s << search_server.GetDocumentCount() << endl;
+    RemoveDuplicates(search_server);
+    cout << "After duplicates removed: "s << search_server.GetDocumentCount() << endl;
+    for (const int document_id : search_server) {
+        cout << document_id << " "s;
+    }
+    cout << endl;
+}
+
+void TestTimeWorkRemoveDuplicates() {
+    // Каждый документ собирается из нескольких слов небольшого словаря,
+    // поэтому многие наборы слов повторяются
+    WorkloadOptions options;
+    options.document_count = 200'000;
+    options.vocabulary_size = 30;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 1;
+    options.max_document_words = 4;
+    options.query_count = 0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+    SearchServer search_server(workload.GetStopWords());
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, {1});
+    }
+    SearchServer reference_server = search_server;
+
+    {
+        LOG_DURATION("RemoveDuplicates by map"sv);
+        RemoveDuplicatesByMap(reference_server);
+    }
+    {
+        LOG_DURATION("RemoveDuplicates"sv);
+        RemoveDuplicates(search_server);
+    }
+    const vector<int> ids(search_server.begin(), search_server.end());
+    const vector<int> reference_ids(reference_server.begin(), reference_server.end());
+    cout << ids.size() << " documents left, "s << (ids == reference_ids ? "same"s : "differ"s) << endl;
+}
+
+void TestWorkNearDuplicates() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat with curly hair and big tail"s, DocumentStatus::ACTUAL, {1});
+    // лишнее слово, мера Жаккара 7/8
+    search_server.AddDocument(2, "funny pet and nasty rat with curly hair and big long tail"s, DocumentStatus::ACTUAL, {1});
+    // похож на документ 2 (7/9), но тот сам повтор, а с документом 1 мера 6/9
+    search_server.AddDocument(3, "funny pet and nasty rat with curly long tail"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(4, "big dog sparrow and fancy collar"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(5, "big dog sparrow with fancy collar"s, DocumentStatus::ACTUAL, {1});
+
+    for (const double threshold : {0.85, 0.7}) {
+        NearDuplicateOptions options;
+        options.jaccard_threshold = threshold;
+        cout << "Threshold "s << threshold << ":"s;
+        for (const NearDuplicate& duplicate : FindNearDuplicates(search_server, options)) {
+            cout << " "s << duplicate.document_id << "->"s << duplicate.original_id
+                 << " ("s << duplicate.similarity << ")"s;
+        }
+        cout << endl;
+    }
+    RemoveNearDuplicates(search_server);
+    cout << "After near duplicates removed: "s << search_server.GetDocumentCount() << endl;
+
+    // Одинаковые документы 3 и 4 попадают в одну корзину с документом 2,
+    // когда у документа 2 минимален хеш слова x. Документ 2 - повтор
+    // документа 1, но пара 3 и 4 все равно должна сравниваться
+    SearchServer bucket_server(""s);
+    bucket_server.AddDocument(1, "a b c d e f g h"s, DocumentStatus::ACTUAL, {1});
+    bucket_server.AddDocument(2, "a b c d e f g h x"s, DocumentStatus::ACTUAL, {1});
+    bucket_server.AddDocument(3, "x y"s, DocumentStatus::ACTUAL, {1});
+    bucket_server.AddDocument(4, "x y"s, DocumentStatus::ACTUAL, {1});
+    int found_seeds = 0;
+    for (uint64_t seed = 1; seed <= 200; ++seed) {
+        NearDuplicateOptions options;
+        options.hash_count = 1;
+        options.band_count = 1;
+        options.seed = seed;
+        for (const NearDuplicate& duplicate : FindNearDuplicates(bucket_server, options)) {
+            found_seeds += duplicate.document_id == 4 && duplicate.original_id == 3;
+        }
+    }
+    cout << "Identical pair found for "s << found_seeds << " of 200 seeds"s << endl;
+}
+
+void TestTimeWorkNearDuplicates() {
+    // Копии базовых текстов, в каждой заменено одно слово из двадцати
+    WorkloadOptions options;
+    options.document_count = 20'000;
+    options.vocabulary_size = 20'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 20;
+    options.max_document_words = 20;
+    options.query_count = 0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+    const vector<GeneratedDocument>& bases = workload.GetDocuments();
+    const vector<string>& dictionary = workload.GetVocabulary();
+
+    mt19937 generator;
+    SearchServer search_server(workload.GetStopWords());
+    for (int id = 0; id < 100'000; ++id) {
+        vector<string_view> words = SplitIntoWords(bases[uniform_int_distribution<size_t>(0, bases.size() - 1)(generator)].text);
+        words[uniform_int_distribution<size_t>(0, words.size() - 1)(generator)]
+            = dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+        string text;
+        for (const string_view word : words) {
+            text += word;
+            text.push_back(' ');
+        }
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, {1});
+    }
+
+    vector<NearDuplicate> duplicates;
+    {
+        LOG_DURATION("FindNearDuplicates"sv);
+        duplicates = FindNearDuplicates(search_server, NearDuplicateOptions{0.7});
+    }
+    bool above_threshold = true;
+    for (const NearDuplicate& duplicate : duplicates) {
+        above_threshold = above_threshold && duplicate.similarity >= 0.7 && duplicate.original_id < duplicate.document_id;
+    }
+    // Из каждой группы копий должен остаться примерно один документ
+    cout << (above_threshold ? "all above threshold"s : "below threshold"s) << ", "s
+         << (search_server.GetDocumentCount() - duplicates.size() < bases.size() * 11 / 10 ? "groups collapsed"s : "groups left"s)
+         << endl;
+    cerr << "Near duplicates: "s << duplicates.size() << " of "s << search_server.GetDocumentCount() << endl;
+}
@@ -0,0 +1,98 @@
+#include "doc_texts.h"
+
+#include "document_store.h"
+#include "log_duration.h"
+#include "search_server.h"
+#include "workload.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void TestWorkDocTexts();
+void TestTimeWorkDocTexts();
+
+void TestsDocumentTexts() {
+    cout << "TestsDocumentTexts"s << endl;
+    TestWorkDocTexts();
+    TestTimeWorkDocTexts();
+    cout << endl;
+}
+
+void TestWorkDocTexts() {
+    SearchServer search_server("and with"s);
+    {
+        // Текст, переданный через string_view, копируется на сервер
+        string text = "funny pet and nasty rat"s;
+        search_server.AddDocument(1, string_view(text), DocumentStatus::ACTUAL, {1});
+        text.assign(text.size(), '#');
+    }
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, {1});
+
+    const string_view first_text = search_server.GetDocumentText(1);
+    search_server.RemoveDocument(2);
+    // Место удаленного текста занимает новый документ
+    search_server.AddDocument(4, "big dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.CompactDocumentTexts();
+    cout << first_text << " | "s << search_server.GetDocumentText(3) << " | "s
+         << search_server.GetDocumentText(4) << " | "s << search_server.GetDocumentText(2).size() << endl;
+
+    DocumentStore store;
+    const string text(100, 'x');
+    for (int id = 0; id < 20'000; ++id) {
+        store.Add(id, text);
+    }
+    cout << store.Capacity() << " "s << store.UsedSize() << endl;
+    for (int id = 0; id < 20'000; id += 2) {
+        store.Remove(id);
+    }
+    store.Compact();
+    cout << store.Capacity() << " "s << store.UsedSize() << endl;
+    for (int id = 1; id < 15'000; id += 2) {
+        store.Remove(id);
+    }
+    store.Compact();
+    cout << store.Capacity() << " "s << store.UsedSize() << endl;
+}
+
+void TestTimeWorkDocTexts() {
+    WorkloadOptions options;
+    options.document_count = 100'000;
+    options.min_document_words = 1;
+    options.max_document_words = 100;
+    options.query_count = 0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+    vector<string> texts;
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        texts.push_back(document.text);
+    }
+
+    {
+        LOG_DURATION("map<int, string>"sv);
+        map<int, string> originals;
+        for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+            originals[id] = texts[id];
+        }
+        for (int id = 0; id < static_cast<int>(texts.size()); id += 2) {
+            originals.erase(id);
+        }
+        cout << originals.size() << endl;
+    }
+    {
+        LOG_DURATION("DocumentStore"sv);
+        DocumentStore store;
+        for (int id = 0; id < static_cast<int>(texts.size()); ++id) {
+            store.Add(id, texts[id]);
+        }
+        for (int id = 0; id < static_cast<int>(texts.size()); id += 2) {
+            store.Remove(id);
+        }
+        store.Compact();
+        cout << store.UsedSize() * 100 / store.Capacity() << "% used"s << endl;
+    }
+}
@@ -2,10 +2,10 @@
 
 #include "log_duration.h"
 #include "search_server.h"
+#include "workload.h"
 
 #include <execution>
 #include <iostream>
-#include <random>
 #include <string>
 #include <vector>
 
@@ -58,49 +58,16 @@ void TestWorkParFTD() {
     for (const Document& document : search_server.FindTopDocuments(execution::par, "curly nasty cat"s, [](int document_id, DocumentStatus status, int rating) { return document_id % 2 == 0; })) {
         PrintDocument(document);
     }
-}
-
-string GenerateWord(mt19937& generator, int max_length) {
-    const int length = uniform_int_distribution(1, max_length)(generator);
-    string word;
-    word.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        word.push_back(uniform_int_distribution('a', 'z')(generator));
-    }
-    return word;
-}
 
-vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
-    vector<string> words;
-    words.reserve(word_count);
-    for (int i = 0; i < word_count; ++i) {
-        words.push_back(GenerateWord(generator, max_length));
-    }
-    words.erase(unique(words.begin(), words.end()), words.end());
-    return words;
-}
+    cout << "Runs of spaces:"s << endl;
+        // несколько пробелов подряд не образуют пустых слов
+    cout << search_server.FindTopDocuments("  curly   nasty cat "s).size() << " documents"s << endl;
 
-string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob = 0) {
-    string query;
-    for (int i = 0; i < word_count; ++i) {
-        if (!query.empty()) {
-            query.push_back(' ');
-        }
-        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
-            query.push_back('-');
-        }
-        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
-    }
-    return query;
-}
-
-vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
-    vector<string> queries;
-    queries.reserve(query_count);
-    for (int i = 0; i < query_count; ++i) {
-        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    cout << "Top 2:"s << endl;
+        // параллельная версия с ограничением количества документов
+    for (const Document& document : search_server.FindTopDocuments(execution::par, "curly nasty cat"s, DocumentStatus::ACTUAL, 2)) {
+        PrintDocument(document);
     }
-    return queries;
 }
 
 template <typename ExecutionPolicy>
@@ -120,19 +87,31 @@ void TestFTD(string_view mark, const SearchServer& search_server, const vector<s
 
 
 void TestTimeWorkFTD() {
-    mt19937 generator;
-
-    const auto dictionary = GenerateDictionary(generator, 1000, 10);
-    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
-
-    SearchServer search_server(dictionary[0]);
-    for (size_t i = 0; i < documents.size(); ++i) {
-        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    WorkloadOptions options;
+    options.document_count = 10'000;
+    options.vocabulary_size = 1'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 70;
+    options.max_document_words = 70;
+    options.query_count = 100;
+    options.max_query_words = 70;
+    options.minus_word_share = 0.0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+
+    SearchServer search_server(workload.GetStopWords());
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, {1, 2, 3});
     }
 
-    const auto queries = GenerateQueries(generator, dictionary, 100, 70);
+    const vector<string>& queries = workload.GetQueries();
 
     TEST_FTD(seq);
     TEST_FTD(par);
+
+    // отбор с отсечением должен давать ту же суммарную релевантность
+    search_server.SetRetrievalMode(RetrievalMode::PRUNED);
+    TestFTD("pruned seq"sv, search_server, queries, execution::seq);
+    TestFTD("pruned par"sv, search_server, queries, execution::par);
 }
 
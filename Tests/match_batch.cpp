@@ -0,0 +1,114 @@
+#include "match_batch.h"
+
+#include "log_duration.h"
+#include "search_server.h"
+#include "workload.h"
+
+#include <execution>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void TestWorkMatchDocuments();
+void TestTimeWorkMatchDocuments();
+
+void TestsMatchDocuments() {
+    cout << "TestsMatchDocuments"s << endl;
+    TestWorkMatchDocuments();
+    TestTimeWorkMatchDocuments();
+    cout << endl;
+}
+
+// Совпадает ли результат набора с матчингом каждого документа по отдельности
+template <typename ExPol>
+bool SameAsSingleMatch(ExPol&& ex_po, const SearchServer& search_server, const string& query,
+                       const MatchedDocuments& matched) {
+    for (size_t i = 0; i < matched.GetDocumentCount(); ++i) {
+        const auto [words, status] = search_server.MatchDocument(ex_po, query, matched.GetDocumentId(i));
+        const auto range = matched.GetWords(i);
+        if (status != matched.GetStatus(i) || !equal(words.begin(), words.end(), range.begin(), range.end())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestWorkMatchDocuments() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(3, "funny pet and not very nasty rat"s, DocumentStatus::BANNED, {1, 2});
+    search_server.AddDocument(4, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(5, "nasty rat with curly hair"s, DocumentStatus::IRRELEVANT, {1, 2});
+
+    const string query = "curly and funny rat -not"s;
+    const vector<int> ids = {5, 1, 3, 2, 4};
+    const MatchedDocuments matched = search_server.MatchDocuments(query, ids);
+    for (size_t i = 0; i < matched.GetDocumentCount(); ++i) {
+        cout << matched.GetDocumentId(i) << ":"s;
+        for (const string_view word : matched.GetWords(i)) {
+            cout << " "s << word;
+        }
+        cout << endl;
+    }
+    cout << "total "s << matched.size() << endl;
+
+    const PreparedQuery prepared = search_server.PrepareQuery(query);
+    cout << SameAsSingleMatch(execution::seq, search_server, query, matched) << " "s
+         << SameAsSingleMatch(execution::par, search_server, query,
+                              search_server.MatchDocuments(execution::par, query, ids)) << " "s
+         << SameAsSingleMatch(execution::seq, search_server, query,
+                              search_server.MatchDocuments(prepared, ids)) << " "s
+         << search_server.MatchDocuments(execution::par, query, {}).GetDocumentCount() << endl;
+
+    try {
+        search_server.MatchDocuments(execution::par, query, {1, 7});
+        cout << "no exception"s << endl;
+    } catch (const out_of_range& e) {
+        cout << e.what() << endl;
+    }
+}
+
+void TestTimeWorkMatchDocuments() {
+    WorkloadOptions options;
+    options.document_count = 10'000;
+    options.vocabulary_size = 1'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 70;
+    options.max_document_words = 70;
+    options.query_count = 0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+
+    SearchServer search_server(workload.GetStopWords());
+    vector<int> ids;
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, {1, 2, 3});
+        ids.push_back(document.id);
+    }
+    mt19937_64 generator(options.seed);
+    const string query = workload.GenerateText(generator, 300, 0.1);
+
+    size_t single_count = 0;
+    {
+        LOG_DURATION("MatchDocument loop"s);
+        for (const int id : ids) {
+            single_count += get<0>(search_server.MatchDocument(query, id)).size();
+        }
+    }
+    size_t seq_count = 0;
+    {
+        LOG_DURATION("MatchDocuments seq"s);
+        seq_count = search_server.MatchDocuments(query, ids).size();
+    }
+    size_t par_count = 0;
+    {
+        LOG_DURATION("MatchDocuments par"s);
+        par_count = search_server.MatchDocuments(execution::par, query, ids).size();
+    }
+    cout << single_count << " "s << (single_count == seq_count) << " "s << (seq_count == par_count) << endl;
+}
@@ -2,6 +2,7 @@
 
 #include "log_duration.h"
 #include "search_server.h"
+#include "workload.h"
 
 #include <execution>
 #include <random>
@@ -57,50 +58,6 @@ void TestWorkParMatch() {
     }
 }
 
-string GenerateWordMatch(mt19937& generator, int max_length) {
-    const int length = uniform_int_distribution(1, max_length)(generator);
-    string word;
-    word.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        word.push_back(uniform_int_distribution('a', 'z')(generator));
-    }
-    return word;
-}
-
-vector<string> GenerateDictionaryMatch(mt19937& generator, int word_count, int max_length) {
-    vector<string> words;
-    words.reserve(word_count);
-    for (int i = 0; i < word_count; ++i) {
-        words.push_back(GenerateWordMatch(generator, max_length));
-    }
-    sort(words.begin(), words.end());
-    words.erase(unique(words.begin(), words.end()), words.end());
-    return words;
-}
-
-string GenerateQueryMatch(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob = 0) {
-    string query;
-    for (int i = 0; i < word_count; ++i) {
-        if (!query.empty()) {
-            query.push_back(' ');
-        }
-        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
-            query.push_back('-');
-        }
-        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
-    }
-    return query;
-}
-
-vector<string> GenerateQueriesMatch(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
-    vector<string> queries;
-    queries.reserve(query_count);
-    for (int i = 0; i < query_count; ++i) {
-        queries.push_back(GenerateQueryMatch(generator, dictionary, max_word_count));
-    }
-    return queries;
-}
-
 template <typename ExecutionPolicy>
 void TestMatch(string_view mark, SearchServer search_server, const string& query, ExecutionPolicy&& policy) {
     LOG_DURATION(mark);
@@ -116,15 +73,22 @@ void TestMatch(string_view mark, SearchServer search_server, const string& query
 #define TEST_MATCH(policy) TestMatch(#policy, search_server, query, execution::policy)
 
 void TestTimeWorkMatch() {
-    mt19937 generator;
-    const auto dictionary = GenerateDictionaryMatch(generator, 1000, 10);
-    const auto documents = GenerateQueriesMatch(generator, dictionary, 10'000, 70);
-
-    const string query = GenerateQueryMatch(generator, dictionary, 500, 0.1);
-
-    SearchServer search_server(dictionary[0]);
-    for (size_t i = 0; i < documents.size(); ++i) {
-        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    WorkloadOptions options;
+    options.document_count = 10'000;
+    options.vocabulary_size = 1'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 70;
+    options.max_document_words = 70;
+    options.query_count = 0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+
+    mt19937_64 generator(options.seed);
+    const string query = workload.GenerateText(generator, 500, 0.1);
+
+    SearchServer search_server(workload.GetStopWords());
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, {1, 2, 3});
     }
 
     TEST_MATCH(seq);
@@ -0,0 +1,114 @@
+#include "op_metrics.h"
+
+#include "log_duration.h"
+#include "metrics.h"
+#include "process_queries.h"
+#include "request_queue.h"
+#include "search_server.h"
+#include "Lib/latency_histogram.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+void TestWorkLatencyHistogram();
+void TestWorkMetrics();
+void TestTimeWorkMetrics();
+
+void TestsMetrics() {
+    cout << "TestsMetrics"s << endl;
+    TestWorkLatencyHistogram();
+    TestWorkMetrics();
+    TestTimeWorkMetrics();
+    cout << endl;
+}
+
+void TestWorkLatencyHistogram() {
+    // Значение попадает в ячейку, границы которой его содержат
+    bool bounds_ok = true;
+    for (uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull, 123'456'789ull, ~0ull}) {
+        const size_t index = LatencyHistogram::GetBucketIndex(value);
+        const uint64_t lower = LatencyHistogram::GetBucketLowerBound(index);
+        bounds_ok = bounds_ok && index < LatencyHistogram::BUCKET_COUNT && lower <= value
+                    && value - lower < LatencyHistogram::GetBucketWidth(index);
+    }
+    cout << "bucket bounds "s << (bounds_ok ? "ok"s : "wrong"s) << endl;
+
+    // Значения 1..10000 из нескольких потоков, процентили с погрешностью до 1/16
+    LatencyHistogram histogram;
+    vector<thread> threads;
+    for (uint64_t part = 0; part < 4; ++part) {
+        threads.emplace_back([&histogram, part] {
+            for (uint64_t value = part + 1; value <= 10'000; value += 4) {
+                histogram.Record(value);
+            }
+        });
+    }
+    for (thread& thread : threads) {
+        thread.join();
+    }
+    const HistogramSnapshot snapshot = histogram.Snapshot();
+    const auto near = [](uint64_t value, uint64_t expected) {
+        return value * 16 >= expected * 15 && value * 16 <= expected * 17;
+    };
+    cout << "count "s << snapshot.count << ", max "s << snapshot.max << ", mean "s << snapshot.Mean()
+         << ", percentiles "s
+         << (near(snapshot.Percentile(0.5), 5'000) && near(snapshot.Percentile(0.99), 9'900) ? "ok"s : "wrong"s)
+         << endl;
+}
+
+void TestWorkMetrics() {
+    ResetMetrics();
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocuments(vector<tuple<int, string, DocumentStatus, vector<int>>>{
+        {3, "big cat nasty hair"s, DocumentStatus::ACTUAL, {1, 2, 8}},
+        {4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, {1, 3, 2}},
+    });
+    try {
+        search_server.AddDocument(4, "duplicate id"s, DocumentStatus::ACTUAL, {1});
+    } catch (const invalid_argument&) {
+    }
+
+    search_server.FindTopDocuments("curly nasty cat"s);
+    search_server.FindTopDocuments(execution::par, "curly nasty cat"s);
+    search_server.MatchDocument("curly nasty cat"s, 3);
+    ProcessQueries(search_server, {"curly"s, "nasty"s, "big cat"s});
+    RequestQueue request_queue(search_server);
+    request_queue.AddFindRequest("curly dog"s);
+    search_server.RemoveDocument(1);
+
+    // FindTopDocuments вызывается и из ProcessQueries, и из RequestQueue
+    const MetricsSnapshot snapshot = GetMetricsSnapshot();
+    for (const OperationMetrics& metrics : snapshot.operations) {
+        cout << GetOperationName(metrics.operation) << ": count "s << metrics.count << ", errors "s
+             << metrics.errors << ", items "s << metrics.items << endl;
+    }
+
+    ostringstream prometheus;
+    WriteMetricsPrometheus(prometheus, snapshot);
+    ostringstream json;
+    WriteMetricsJson(json, snapshot);
+    cout << "prometheus has find_top_documents count: "s
+         << (prometheus.str().find("search_server_operation_latency_seconds_count{operation=\"find_top_documents\"} 6"s)
+             != string::npos) << endl;
+    cout << "json has request_queue_find: "s
+         << (json.str().find("{\"operation\": \"request_queue_find\", \"count\": 1"s) != string::npos) << endl;
+}
+
+void TestTimeWorkMetrics() {
+    // Стоимость записи одного вызова
+    const int count = 1'000'000;
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        OperationTimer timer(Operation::MATCH_DOCUMENT);
+    }
+    const chrono::duration<double, nano> duration = chrono::steady_clock::now() - start;
+    cerr << "OperationTimer: "s << duration.count() / count << " ns per call"s << endl;
+}
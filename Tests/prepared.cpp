@@ -0,0 +1,212 @@
+#include "prepared.h"
+
+#include "log_duration.h"
+#include "process_queries.h"
+#include "request_queue.h"
+#include "search_server.h"
+#include "workload.h"
+
+#include <algorithm>
+#include <execution>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void TestWorkPreparedQuery();
+void TestTimeWorkPreparedQuery();
+
+void TestsPreparedQuery() {
+    cout << "TestsPreparedQuery"s << endl;
+    TestWorkPreparedQuery();
+    TestTimeWorkPreparedQuery();
+    cout << endl;
+}
+
+void PrintPreparedDocuments(const vector<Document>& documents) {
+    for (const Document& document : documents) {
+        cout << document.id << " "s;
+    }
+    cout << endl;
+}
+
+bool SameDocuments(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& a, const Document& b) {
+        return a.id == b.id && a.relevance == b.relevance && a.rating == b.rating;
+    });
+}
+
+void TestWorkPreparedQuery() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::BANNED, {1, 2, 8});
+    search_server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, {1, 3, 2});
+
+    // Слова без повторов и стоп-слов, неизвестное слово parrot отброшено
+    const PreparedQuery query = search_server.PrepareQuery("curly nasty and cat curly parrot -rat"s);
+    cout << query.GetText() << ": plus "s << query.GetPlusTerms().size() << ", minus "s
+         << query.GetMinusTerms().size() << ", inline "s << query.GetPlusTerms().IsInline() << endl;
+
+    // Результаты совпадают с поиском по тексту
+    const string text = query.GetText();
+    const auto even = [](int id, DocumentStatus, int) {
+        return id % 2 == 0;
+    };
+    cout << SameDocuments(search_server.FindTopDocuments(query), search_server.FindTopDocuments(text)) << " "s
+         << SameDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                          search_server.FindTopDocuments(execution::par, text, DocumentStatus::BANNED)) << " "s
+         << SameDocuments(search_server.FindTopDocuments(query, even), search_server.FindTopDocuments(text, even))
+         << " "s << (search_server.MatchDocument(query, 3) == search_server.MatchDocument(text, 3))
+         << " "s << (search_server.MatchDocument(execution::par, query, 1)
+                     == search_server.MatchDocument(execution::par, text, 1)) << endl;
+
+    // Слов больше, чем помещается во встроенный буфер
+    const string long_text = "funny pet nasty rat curly hair big cat dog Vladislav"s;
+    const PreparedQuery long_query = search_server.PrepareQuery(long_text);
+    cout << "plus "s << long_query.GetPlusTerms().size() << ", inline "s << long_query.GetPlusTerms().IsInline()
+         << ", same "s << SameDocuments(search_server.FindTopDocuments(long_query),
+                                        search_server.FindTopDocuments(long_text)) << endl;
+
+    const vector<PreparedQuery> queries = {query, search_server.PrepareQuery("big"s), PreparedQuery{}};
+    const auto results = ProcessPreparedQueries(search_server, queries);
+    for (const auto& documents : results) {
+        PrintPreparedDocuments(documents);
+    }
+    RequestQueue request_queue(search_server);
+    PrintPreparedDocuments(request_queue.AddFindRequest(queries[1]));
+
+    // Слово parrot появилось в словаре, в нем ищется только это слово
+    search_server.AddDocument(5, "curly parrot"s, DocumentStatus::ACTUAL, {5});
+    PrintPreparedDocuments(search_server.FindTopDocuments(query));
+    // После обновления запрос снова выполняется без поиска слов в словаре
+    PreparedQuery refreshed = query;
+    search_server.RefreshPreparedQuery(refreshed);
+    cout << "plus "s << refreshed.GetPlusTerms().size() << ", same "s
+         << SameDocuments(search_server.FindTopDocuments(refreshed), search_server.FindTopDocuments(text)) << endl;
+    // Копия сервера разбирает запрос по своему словарю
+    SearchServer copy = search_server;
+    copy.AddDocument(6, "nasty parrot"s, DocumentStatus::ACTUAL, {1});
+    PrintPreparedDocuments(copy.FindTopDocuments(query));
+    // Сервер, замененный присваиванием, разбирает запрос по новому словарю,
+    // в котором у тех же слов другие id
+    const PreparedQuery copy_query = copy.PrepareQuery("nasty -funny"s);
+    copy = SearchServer("and with"s);
+    copy.AddDocument(1, "funny nasty"s, DocumentStatus::ACTUAL, {1});
+    copy.AddDocument(2, "nasty cat"s, DocumentStatus::ACTUAL, {2});
+    PrintPreparedDocuments(copy.FindTopDocuments(copy_query));
+
+    try {
+        search_server.PrepareQuery("curly --cat"s);
+        cout << "no exception"s << endl;
+    } catch (const invalid_argument& e) {
+        cout << e.what() << endl;
+    }
+}
+
+void TestTimeWorkPreparedQuery() {
+    WorkloadOptions options;
+    options.document_count = 2'000;
+    options.vocabulary_size = 1'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 1;
+    options.max_document_words = 50;
+    options.query_count = 100;
+    options.max_query_words = 7;
+    options.minus_word_share = 0.0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+
+    SearchServer search_server(workload.GetStopWords());
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    vector<string> texts = workload.GetQueries();
+    vector<PreparedQuery> queries;
+    for (const string& text : texts) {
+        queries.push_back(search_server.PrepareQuery(text));
+    }
+
+    // Один и тот же набор запросов выполняется многократно
+    size_t text_count = 0;
+    size_t prepared_count = 0;
+    {
+        LOG_DURATION("text queries"s);
+        for (int round = 0; round < 100; ++round) {
+            for (const string& text : texts) {
+                text_count += search_server.FindTopDocuments(text).size();
+            }
+        }
+    }
+    {
+        LOG_DURATION("prepared queries"s);
+        for (int round = 0; round < 100; ++round) {
+            for (const PreparedQuery& query : queries) {
+                prepared_count += search_server.FindTopDocuments(query).size();
+            }
+        }
+    }
+    cout << (text_count == prepared_count) << endl;
+
+    // В каждом запросе есть слово, которого нет в словаре. После роста словаря
+    // устаревший запрос ищет в словаре только такие слова, текст не разбирается
+    vector<PreparedQuery> stale_queries;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        texts[i] += " unknown"s + string(1, 'a' + i % 26);
+        stale_queries.push_back(search_server.PrepareQuery(texts[i]));
+    }
+    search_server.AddDocument(2'000, "grown dictionary"s, DocumentStatus::ACTUAL, {1});
+    vector<PreparedQuery> refreshed_queries = stale_queries;
+    for (PreparedQuery& query : refreshed_queries) {
+        search_server.RefreshPreparedQuery(query);
+    }
+    const auto run = [&search_server](const auto& queries) {
+        size_t count = 0;
+        for (int round = 0; round < 100; ++round) {
+            for (const auto& query : queries) {
+                count += search_server.FindTopDocuments(query).size();
+            }
+        }
+        return count;
+    };
+    size_t grown_text_count = 0;
+    size_t stale_count = 0;
+    size_t refreshed_count = 0;
+    {
+        LOG_DURATION("text queries, grown dictionary"s);
+        grown_text_count = run(texts);
+    }
+    {
+        LOG_DURATION("stale prepared queries"s);
+        stale_count = run(stale_queries);
+    }
+    {
+        LOG_DURATION("refreshed prepared queries"s);
+        refreshed_count = run(refreshed_queries);
+    }
+    cout << (grown_text_count == stale_count && stale_count == refreshed_count) << endl;
+
+    // Оценка стоимости почти не ищет, поэтому разница - цена разбора текста
+    const auto estimate = [&search_server](const auto& queries) {
+        size_t cost = 0;
+        for (int round = 0; round < 1'000; ++round) {
+            for (const auto& query : queries) {
+                cost += search_server.EstimateQueryCost(query);
+            }
+        }
+        return cost;
+    };
+    size_t text_cost = 0;
+    size_t stale_cost = 0;
+    {
+        LOG_DURATION("EstimateQueryCost, text queries"s);
+        text_cost = estimate(texts);
+    }
+    {
+        LOG_DURATION("EstimateQueryCost, stale prepared queries"s);
+        stale_cost = estimate(stale_queries);
+    }
+    cout << (text_cost == stale_cost) << endl;
+}
@@ -3,10 +3,12 @@
 #include "log_duration.h"
 #include "process_queries.h"
 #include "search_server.h"
+#include "workload.h"
 
+#include <algorithm>
+#include <chrono>
 #include <execution>
 #include <iostream>
-#include <random>
 #include <string>
 #include <vector>
 
@@ -17,6 +19,7 @@ void TestProcQueries2();
 
 void TestProcQueriesJoined1();
 void TestProcQueriesJoined2();
+void TestProcQueriesStreamed();
 
 void TestsProcessQueries() {
     cout << "TestsProcessQueries"s << endl;
@@ -29,6 +32,7 @@ void TestsProcessJoined() {
     cout << "TestsProcessJoined"s << endl;
     TestProcQueriesJoined1();
     TestProcQueriesJoined2();
+    TestProcQueriesStreamed();
     cout << endl;
 }
 
@@ -61,46 +65,26 @@ void TestProcQueries1() {
     }
 }
 
-string GenerateWordProc(mt19937& generator, int max_length) {
-    const int length = uniform_int_distribution(1, max_length)(generator);
-    string word;
-    word.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        word.push_back(uniform_int_distribution('a', 'z')(generator));
-    }
-    return word;
-}
-
-vector<string> GenerateDictionaryProc(mt19937& generator, int word_count, int max_length) {
-    vector<string> words;
-    words.reserve(word_count);
-    for (int i = 0; i < word_count; ++i) {
-        words.push_back(GenerateWordProc(generator, max_length));
-    }
-    sort(words.begin(), words.end());
-    words.erase(unique(words.begin(), words.end()), words.end());
-    return words;
-}
-
-string GenerateQueryProc(mt19937& generator, const vector<string>& dictionary, int max_word_count) {
-    const int word_count = uniform_int_distribution(1, max_word_count)(generator);
-    string query;
-    for (int i = 0; i < word_count; ++i) {
-        if (!query.empty()) {
-            query.push_back(' ');
-        }
-        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
-    }
-    return query;
+Workload GenerateWorkloadProc() {
+    WorkloadOptions options;
+    options.document_count = 100'000;
+    options.vocabulary_size = 10'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 1;
+    options.max_document_words = 10;
+    options.query_count = 10'000;
+    options.max_query_words = 7;
+    options.minus_word_share = 0.0;
+    options.duplicate_share = 0.0;
+    return Workload(options);
 }
 
-vector<string> GenerateQueriesProc(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
-    vector<string> queries;
-    queries.reserve(query_count);
-    for (int i = 0; i < query_count; ++i) {
-        queries.push_back(GenerateQueryProc(generator, dictionary, max_word_count));
+SearchServer MakeServerProc(const Workload& workload) {
+    SearchServer search_server(workload.GetStopWords());
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, {1, 2, 3});
     }
-    return queries;
+    return search_server;
 }
 
 template <typename QueriesProcessor>
@@ -112,16 +96,9 @@ void TestProc(string_view mark, QueriesProcessor processor, const SearchServer&
 #define TEST_PROC(processor) TestProc(#processor, processor, search_server, queries)
 
 void TestProcQueries2() {
-    mt19937 generator;
-    const auto dictionary = GenerateDictionaryProc(generator, 10000, 25);
-    const auto documents = GenerateQueriesProc(generator, dictionary, 100'000, 10);
-
-    SearchServer search_server(dictionary[0]);
-    for (size_t i = 0; i < documents.size(); ++i) {
-        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
-    }
-
-    const auto queries = GenerateQueriesProc(generator, dictionary, 10'000, 7);
+    const Workload workload = GenerateWorkloadProc();
+    const SearchServer search_server = MakeServerProc(workload);
+    const vector<string>& queries = workload.GetQueries();
     TEST_PROC(ProcessQueries);
 }
 
@@ -163,15 +140,47 @@ void TestProcJoined(string_view mark, QueriesProcessor processor, const SearchSe
 #define TEST_PROC_JOINED(processor) TestProcJoined(#processor, processor, search_server, queries)
 
 void TestProcQueriesJoined2() {
-    mt19937 generator;
-    const auto dictionary = GenerateDictionaryProc(generator, 10000, 25);
-    const auto documents = GenerateQueriesProc(generator, dictionary, 100'000, 10);
+    const Workload workload = GenerateWorkloadProc();
+    const SearchServer search_server = MakeServerProc(workload);
+    const vector<string>& queries = workload.GetQueries();
+    TEST_PROC_JOINED(ProcessQueries);
+}
 
-    SearchServer search_server(dictionary[0]);
-    for (size_t i = 0; i < documents.size(); ++i) {
-        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+void TestProcQueriesStreamed() {
+    const Workload workload = GenerateWorkloadProc();
+    const SearchServer search_server = MakeServerProc(workload);
+    const vector<string>& queries = workload.GetQueries();
+
+    // Участки запросов в общем буфере совпадают с отдельными результатами
+    const auto documents_lists = ProcessQueries(search_server, queries);
+    const JoinedResults joined = ProcessQueriesJoined(search_server, queries);
+    bool same = joined.GetQueryCount() == queries.size();
+    for (size_t i = 0; same && i < queries.size(); ++i) {
+        const auto query_results = joined.GetQueryResults(i);
+        same = equal(query_results.begin(), query_results.end(),
+                     documents_lists[i].begin(), documents_lists[i].end(),
+                     [](const Document& lhs, const Document& rhs) {
+            return lhs.id == rhs.id && lhs.relevance == rhs.relevance;
+        });
     }
-
-    const auto queries = GenerateQueriesProc(generator, dictionary, 10'000, 7);
-    TEST_PROC_JOINED(ProcessQueries);
+    cout << joined.size() << " "s << (same ? "same"s : "differ"s) << endl;
+
+    // Результаты передаются по порядку запросов
+    size_t expected_index = 0;
+    size_t streamed_count = 0;
+    bool ordered = true;
+    const auto start_time = chrono::steady_clock::now();
+    chrono::steady_clock::duration first_result_time{};
+    ProcessQueriesStreamed(search_server, queries,
+                           [&](size_t query_index, const vector<Document>& query_documents) {
+        if (query_index == 0) {
+            first_result_time = chrono::steady_clock::now() - start_time;
+        }
+        ordered = ordered && query_index == expected_index++;
+        streamed_count += query_documents.size();
+    });
+    cout << streamed_count << " "s << (ordered && expected_index == queries.size() ? "ordered"s : "unordered"s)
+         << endl;
+    cerr << "ProcessQueriesStreamed first result: "s
+         << chrono::duration_cast<chrono::microseconds>(first_result_time).count() << " us"s << endl;
 }
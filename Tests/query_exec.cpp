@@ -0,0 +1,115 @@
+#include "query_exec.h"
+
+#include "log_duration.h"
+#include "query_executor.h"
+#include "search_server.h"
+#include "workload.h"
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void TestWorkQueryExecutor();
+void TestTimeWorkQueryExecutor();
+
+void TestsQueryExecutor() {
+    cout << "TestsQueryExecutor"s << endl;
+    TestWorkQueryExecutor();
+    TestTimeWorkQueryExecutor();
+    cout << endl;
+}
+
+// Частоты слов распределены по Ципфу, поэтому стоимость запросов
+// сильно различается
+Workload GenerateWorkloadExec(size_t document_count, size_t query_count) {
+    WorkloadOptions options;
+    options.document_count = document_count;
+    options.vocabulary_size = 10'000;
+    options.min_document_words = 1;
+    options.max_document_words = 10;
+    options.query_count = query_count;
+    options.max_query_words = 10;
+    options.duplicate_share = 0.0;
+    return Workload(options);
+}
+
+SearchServer MakeServerExec(const Workload& workload) {
+    SearchServer search_server(workload.GetStopWords());
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, document.ratings);
+    }
+    return search_server;
+}
+
+bool EqualResults(const vector<vector<Document>>& lhs, const vector<vector<Document>>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                 [](const vector<Document>& lhs_docs, const vector<Document>& rhs_docs) {
+        return equal(lhs_docs.begin(), lhs_docs.end(), rhs_docs.begin(), rhs_docs.end(),
+                     [](const Document& lhs_doc, const Document& rhs_doc) {
+            return lhs_doc.id == rhs_doc.id && abs(lhs_doc.relevance - rhs_doc.relevance) < 1e-9;
+        });
+    });
+}
+
+void TestWorkQueryExecutor() {
+    const Workload workload = GenerateWorkloadExec(20'000, 200);
+    const SearchServer search_server = MakeServerExec(workload);
+    // Самые частые слова после стоп-слов
+    const vector<string>& vocabulary = workload.GetVocabulary();
+
+    vector<string> queries = workload.GetQueries();
+    queries.push_back(vocabulary[3] + " "s + vocabulary[4] + " -"s + vocabulary[5]);
+    vector<vector<Document>> expected;
+    for (const string& query : queries) {
+        expected.push_back(search_server.FindTopDocuments(query));
+    }
+
+    // Результат не зависит от числа исполнителей и порога деления запросов
+    for (size_t worker_count : {1, 2, 4}) {
+        for (size_t split_cost : {size_t{0}, size_t{4096}, size_t{1'000'000}}) {
+            QueryExecutor executor({worker_count, split_cost, 3});
+            QueryBatchStats stats;
+            const auto results = executor.ProcessQueries(search_server, queries, stats);
+            cout << worker_count << " "s << split_cost << " "s << stats.query_count << " "s
+                 << stats.split_query_count << " "s << (EqualResults(results, expected) ? "ok"s : "mismatch"s)
+                 << endl;
+        }
+    }
+
+    // Исключение запроса передается вызывающему
+    QueryExecutor executor({2, 0, 1});
+    try {
+        executor.ProcessQueries(search_server, {vocabulary[3], "--"s + vocabulary[4], vocabulary[5]});
+        cout << "no exception"s << endl;
+    } catch (const invalid_argument&) {
+        cout << "invalid_argument"s << endl;
+    }
+}
+
+void TestTimeWorkQueryExecutor() {
+    const Workload workload = GenerateWorkloadExec(100'000, 300);
+    const SearchServer search_server = MakeServerExec(workload);
+    const vector<string>& queries = workload.GetQueries();
+
+    {
+        LOG_DURATION("transform par"sv);
+        vector<vector<Document>> results(queries.size());
+        transform(execution::par, queries.begin(), queries.end(), results.begin(),
+                  [&search_server](const string& query) {
+            return search_server.FindTopDocuments(query);
+        });
+    }
+    for (size_t worker_count : {1, 2, 4}) {
+        QueryExecutor executor({worker_count});
+        QueryBatchStats stats;
+        executor.ProcessQueries(search_server, queries, stats);
+        cerr << "QueryExecutor "s << worker_count << " workers: "s << static_cast<int>(stats.QueriesPerSecond())
+             << " queries/s, "s << stats.split_query_count << " split"s << endl;
+    }
+}
@@ -0,0 +1,61 @@
+#include "query_trace.h"
+
+#include "query_stats.h"
+#include "search_server.h"
+
+#include <execution>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+void TestWorkQueryStats();
+
+void TestsQueryStats() {
+    cout << "TestsQueryStats"s << endl;
+    TestWorkQueryStats();
+    cout << endl;
+}
+
+void PrintQueryStats(const QueryStats& stats) {
+    cout << "queries "s << stats.query_count << ", lists "s << stats.posting_lists
+         << ", postings "s << stats.postings_scanned << ", candidates "s << stats.candidates
+         << ", excluded "s << stats.excluded << ", results "s << stats.results << endl;
+    // Длительности зависят от машины и выводятся отдельно от результатов
+    for (size_t stage = 0; stage < QUERY_STAGE_COUNT; ++stage) {
+        cerr << GetQueryStageName(static_cast<QueryStage>(stage)) << ": "s
+             << stats.stage_durations[stage].count() << " ns"s << endl;
+    }
+}
+
+void TestWorkQueryStats() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::ACTUAL, {1, 2, 8});
+    search_server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, {1, 3, 2});
+
+    QueryStats stats;
+    {
+        QueryStatsTrace trace(stats);
+        // Кандидаты 1, 2, 3, документ 1 исключен минус-словом
+        search_server.FindTopDocuments("curly nasty hair -rat"s);
+        search_server.FindTopDocuments(execution::par, "curly nasty hair -rat"s);
+        search_server.MatchDocument("curly nasty hair -rat"s, 1);
+        search_server.MatchDocument("curly nasty hair -rat"s, 3);
+        search_server.RemoveDocument(4);
+    }
+    // Вне области QueryStatsTrace статистика не собирается
+    search_server.FindTopDocuments("curly nasty hair"s);
+
+    if constexpr (QUERY_STATS_ENABLED) {
+        PrintQueryStats(stats);
+        stats.Clear();
+        search_server.SetRetrievalMode(RetrievalMode::PRUNED);
+        QueryStatsTrace trace(stats);
+        search_server.FindTopDocuments("curly nasty hair -rat"s);
+        PrintQueryStats(stats);
+    } else {
+        cout << "query stats disabled, queries "s << stats.query_count << endl;
+    }
+}
@@ -0,0 +1,128 @@
+#include "remove_batch.h"
+
+#include "log_duration.h"
+#include "search_server.h"
+#include "workload.h"
+
+#include <execution>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void TestWorkRemoveDocuments();
+void TestTimeWorkRemoveDocuments();
+
+void TestsRemoveDocuments() {
+    cout << "TestsRemoveDocuments"s << endl;
+    TestWorkRemoveDocuments();
+    TestTimeWorkRemoveDocuments();
+    cout << endl;
+}
+
+// Совпадают ли документы, результаты поиска и статистика слов двух серверов
+bool SameIndex(const SearchServer& lhs, const SearchServer& rhs, const vector<string>& queries,
+               const vector<string>& words) {
+    if (!equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end())) {
+        return false;
+    }
+    for (const string& query : queries) {
+        const auto lhs_documents = lhs.FindTopDocuments(query);
+        const auto rhs_documents = rhs.FindTopDocuments(query);
+        if (!equal(lhs_documents.begin(), lhs_documents.end(), rhs_documents.begin(), rhs_documents.end(),
+                   [](const Document& a, const Document& b) {
+            return a.id == b.id && a.relevance == b.relevance && a.rating == b.rating;
+        })) {
+            return false;
+        }
+    }
+    for (const string& word : words) {
+        const TermStatistics lhs_stats = lhs.GetTermStatistics(word);
+        const TermStatistics rhs_stats = rhs.GetTermStatistics(word);
+        if (lhs_stats.document_freq != rhs_stats.document_freq
+            || lhs_stats.inverse_document_freq != rhs_stats.inverse_document_freq
+            || lhs_stats.max_term_freq != rhs_stats.max_term_freq) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestWorkRemoveDocuments() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(3, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(4, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(5, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+
+    const vector<string> queries = {"curly nasty rat"s, "funny pet -not"s, "hair"s};
+    const vector<string> words = {"funny"s, "pet"s, "nasty"s, "rat"s, "curly"s, "hair"s, "not"s, "very"s};
+
+    SearchServer single = search_server;
+    single.RemoveDocument(4);
+    single.RemoveDocument(1);
+    single.RemoveDocument(3);
+
+    // Повторяющиеся и отсутствующие id пропускаются
+    SearchServer batch_seq = search_server;
+    batch_seq.RemoveDocuments({4, 1, 9, 3, 4});
+    SearchServer batch_par = search_server;
+    batch_par.RemoveDocuments(execution::par, {3, 4, 1});
+    cout << batch_seq.GetDocumentCount() << " "s << SameIndex(single, batch_seq, queries, words) << " "s
+         << SameIndex(single, batch_par, queries, words) << " "s
+         << batch_seq.GetTermStatistics("very"s).document_freq << endl;
+
+    for (const Document& document : batch_par.FindTopDocuments("funny rat hair"s)) {
+        cout << document.id << " "s;
+    }
+    cout << endl;
+
+    batch_par.RemoveDocuments(execution::par, {});
+    batch_par.RemoveDocuments(execution::par, {2, 5});
+    cout << batch_par.GetDocumentCount() << " "s << batch_par.FindTopDocuments("funny rat hair"s).size() << endl;
+}
+
+void TestTimeWorkRemoveDocuments() {
+    WorkloadOptions options;
+    options.document_count = 20'000;
+    options.vocabulary_size = 2'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 70;
+    options.max_document_words = 70;
+    options.query_count = 0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+    const vector<string>& dictionary = workload.GetVocabulary();
+
+    SearchServer search_server(workload.GetStopWords());
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    vector<int> removed_ids;
+    for (int id = 0; id < 20'000; id += 2) {
+        removed_ids.push_back(id);
+    }
+
+    SearchServer single = search_server;
+    SearchServer batch_seq = search_server;
+    SearchServer batch_par = search_server;
+    {
+        LOG_DURATION("RemoveDocument loop"s);
+        for (const int id : removed_ids) {
+            single.RemoveDocument(id);
+        }
+    }
+    {
+        LOG_DURATION("RemoveDocuments seq"s);
+        batch_seq.RemoveDocuments(removed_ids);
+    }
+    {
+        LOG_DURATION("RemoveDocuments par"s);
+        batch_par.RemoveDocuments(execution::par, removed_ids);
+    }
+    const vector<string> queries = {dictionary[3] + " "s + dictionary[4], dictionary[5] + " -"s + dictionary[6]};
+    cout << single.GetDocumentCount() << " "s << SameIndex(single, batch_seq, queries, dictionary) << " "s
+         << SameIndex(single, batch_par, queries, dictionary) << endl;
+}
@@ -2,9 +2,9 @@
 
 #include "log_duration.h"
 #include "search_server.h"
+#include "workload.h"
 
 #include <execution>
-#include <random>
 #include <string>
 #include <vector>
 
@@ -56,48 +56,18 @@ void TestWorkParRem() {
         cout << "Paralel Test"s <<  endl;
         search_server.RemoveDocument(execution::par, 2);
         report();
-}
-
-string GenerateWordRem(mt19937& generator, int max_length) {
-    const int length = uniform_int_distribution(1, max_length)(generator);
-    string word;
-    word.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        word.push_back(uniform_int_distribution('a', 'z')(generator));
-    }
-    return word;
-}
 
-vector<string> GenerateDictionaryRem(mt19937& generator, int word_count, int max_length) {
-    vector<string> words;
-    words.reserve(word_count);
-    for (int i = 0; i < word_count; ++i) {
-        words.push_back(GenerateWordRem(generator, max_length));
-    }
-    sort(words.begin(), words.end());
-    words.erase(unique(words.begin(), words.end()), words.end());
-    return words;
-}
-
-string GenerateQueryRem(mt19937& generator, const vector<string>& dictionary, int max_word_count) {
-    const int word_count = uniform_int_distribution(1, max_word_count)(generator);
-    string query;
-    for (int i = 0; i < word_count; ++i) {
-        if (!query.empty()) {
-            query.push_back(' ');
-        }
-        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
-    }
-    return query;
-}
-
-vector<string> GenerateQueriesRem(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
-    vector<string> queries;
-    queries.reserve(query_count);
-    for (int i = 0; i < query_count; ++i) {
-        queries.push_back(GenerateQueryRem(generator, dictionary, max_word_count));
-    }
-    return queries;
+        // Слова удаленных документов убираются из словаря, подготовленный
+        // запрос разбирается заново по новым id слов
+        const PreparedQuery prepared = search_server.PrepareQuery("rat -not"s);
+        const auto before = search_server.FindTopDocuments(prepared);
+        search_server.CompactTerms();
+        const auto after = search_server.FindTopDocuments(prepared);
+        cout << "Compact Test "s << search_server.GetTermStatistics("funny"s).document_freq << " "s
+             << search_server.GetTermStatistics("rat"s).document_freq << " "s
+             << (before.size() == after.size() && before[0].id == after[0].id
+                 && before[0].relevance == after[0].relevance) << endl;
+        report();
 }
 
 template <typename ExecutionPolicy>
@@ -113,14 +83,19 @@ void TestRem(string_view mark, SearchServer search_server, ExecutionPolicy&& pol
 #define TEST_REM(mode) TestRem(#mode, search_server, execution::mode)
 
 void TestTimeWorkRem() {
-    mt19937 generator;
-
-    const auto dictionary = GenerateDictionaryRem(generator, 10000, 25);
-    const auto documents = GenerateQueriesRem(generator, dictionary, 10'000, 100);
-
-    SearchServer search_server(dictionary[0]);
-    for (size_t i = 0; i < documents.size(); ++i) {
-        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    WorkloadOptions options;
+    options.document_count = 10'000;
+    options.vocabulary_size = 10'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 1;
+    options.max_document_words = 100;
+    options.query_count = 0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+
+    SearchServer search_server(workload.GetStopWords());
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, {1, 2, 3});
     }
 
     TEST_REM(seq);
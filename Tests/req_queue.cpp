@@ -0,0 +1,148 @@
+#include "req_queue.h"
+
+#include "log_duration.h"
+#include "request_queue.h"
+#include "search_server.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+void TestWorkRequestQueue();
+void TestTimeWorkRequestQueue();
+
+void TestsRequestQueue() {
+    cout << "TestsRequestQueue"s << endl;
+    TestWorkRequestQueue();
+    TestTimeWorkRequestQueue();
+    cout << endl;
+}
+
+void TestWorkRequestQueue() {
+    SearchServer search_server("and in at"s);
+    RequestQueue request_queue(search_server);
+    search_server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "curly dog and fancy collar"s, DocumentStatus::ACTUAL, {1, 2, 3});
+    search_server.AddDocument(3, "big cat fancy collar "s, DocumentStatus::ACTUAL, {1, 2, 8});
+    search_server.AddDocument(4, "big dog sparrow Eugene"s, DocumentStatus::ACTUAL, {1, 3, 2});
+    search_server.AddDocument(5, "big dog sparrow Vasiliy"s, DocumentStatus::ACTUAL, {1, 1, 1});
+
+    // 1439 запросов с нулевым результатом
+    for (int i = 0; i < 1439; ++i) {
+        request_queue.AddFindRequest("empty request"s);
+    }
+    // все еще 1439 запросов с нулевым результатом
+    request_queue.AddFindRequest("curly dog"s);
+    // новые сутки, первый запрос удален, 1438 запросов с нулевым результатом
+    request_queue.AddFindRequest("big collar"s);
+    // первый запрос удален, 1437 запросов с нулевым результатом
+    request_queue.AddFindRequest("sparrow"s);
+    const RequestStats last_stats = request_queue.GetLastRequestsStats();
+    cout << "Total empty requests: "s << request_queue.GetNoResultRequests() << ", "s
+         << last_stats.request_count << " requests, "s << last_stats.result_count << " documents"s << endl;
+
+    // Окно в одну минуту делится на части по 1/64 минуты
+    RequestQueue window_queue(search_server, 100, chrono::minutes(1));
+    const auto start = RequestQueue::Clock::time_point{} + chrono::hours(1);
+    for (int second = 0; second < 120; ++second) {
+        window_queue.RecordRequest(second % 3, chrono::microseconds(100), start + chrono::seconds(second));
+    }
+    for (int minute : {1, 2, 3}) {
+        const RequestStats stats = window_queue.GetWindowStats(start + chrono::minutes(minute));
+        cout << stats.request_count << " requests, "s << stats.no_result_count << " empty, "s
+             << stats.result_count << " documents, "s << stats.AverageLatencyMs() << " ms"s << endl;
+    }
+
+    // Запросы из нескольких потоков учитываются без потерь, а статистика,
+    // прочитанная во время регистрации, согласована: у каждого запроса
+    // ноль или один документ
+    RequestQueue shared_queue(search_server, 1000);
+    atomic<bool> writing = true;
+    atomic<int> inconsistent_reads = 0;
+    thread reader([&] {
+        while (writing) {
+            const RequestStats stats = shared_queue.GetLastRequestsStats();
+            if (stats.no_result_count + stats.result_count != stats.request_count) {
+                ++inconsistent_reads;
+            }
+        }
+    });
+    vector<thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&shared_queue] {
+            for (int i = 0; i < 10'000; ++i) {
+                shared_queue.RecordRequest(i % 2, chrono::microseconds(10));
+            }
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    writing = false;
+    reader.join();
+    cout << "Inconsistent reads: "s << inconsistent_reads << endl;
+    const RequestStats shared_stats = shared_queue.GetLastRequestsStats();
+    cout << shared_stats.request_count << " "s << shared_stats.no_result_count + shared_stats.result_count
+         << " "s << shared_queue.GetWindowStats().request_count << endl;
+}
+
+void TestTimeWorkRequestQueue() {
+    struct QueryResult {
+        string query;
+        vector<Document> res;
+        bool is_empty;
+    };
+    const vector<Document> result(5, Document(1, 0.5, 1));
+    const string query = "curly dog with fancy collar"s;
+    const int thread_count = 4;
+    const int request_count = 250'000;
+    {
+        // Прежний способ: копия запроса и результатов в очереди под общей блокировкой
+        LOG_DURATION("deque<QueryResult> with mutex"sv);
+        deque<QueryResult> requests;
+        int empty_count = 0;
+        mutex requests_mutex;
+        vector<thread> threads;
+        for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < request_count; ++i) {
+                    lock_guard lock(requests_mutex);
+                    if (requests.size() == RequestQueue::DEFAULT_CAPACITY) {
+                        empty_count -= requests.front().is_empty;
+                        requests.pop_front();
+                    }
+                    requests.push_back({query, result, result.empty()});
+                    empty_count += result.empty();
+                }
+            });
+        }
+        for (thread& worker : threads) {
+            worker.join();
+        }
+        cout << empty_count << endl;
+    }
+    {
+        LOG_DURATION("RequestQueue::RecordRequest"sv);
+        SearchServer search_server("and"s);
+        RequestQueue request_queue(search_server);
+        vector<thread> threads;
+        for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < request_count; ++i) {
+                    request_queue.RecordRequest(result.size(), chrono::microseconds(50));
+                }
+            });
+        }
+        for (thread& worker : threads) {
+            worker.join();
+        }
+        cout << request_queue.GetNoResultRequests() << endl;
+    }
+}
@@ -0,0 +1,102 @@
+#include "result_cache.h"
+
+#include "log_duration.h"
+#include "process_queries.h"
+#include "search_server.h"
+#include "workload.h"
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void TestWorkQueryCache();
+void TestTimeWorkQueryCache();
+
+void TestsQueryCache() {
+    cout << "TestsQueryCache"s << endl;
+    TestWorkQueryCache();
+    TestTimeWorkQueryCache();
+    cout << endl;
+}
+
+void PrintCacheStats(const SearchServer& search_server) {
+    const QueryCacheStats stats = search_server.GetQueryCacheStats();
+    cout << "hits "s << stats.hits << ", misses "s << stats.misses << ", stale "s << stats.stale
+         << ", size "s << stats.size << endl;
+}
+
+void TestWorkQueryCache() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::BANNED, {1, 2, 8});
+    search_server.EnableQueryCache(100);
+
+    // Порядок и повторы слов не влияют на ключ, статус влияет
+    search_server.FindTopDocuments("curly nasty -rat"s);
+    cout << search_server.FindTopDocuments("-rat nasty curly curly"s).size() << endl;
+    cout << search_server.FindTopDocuments("curly nasty -rat"s, DocumentStatus::BANNED).size() << endl;
+    PrintCacheStats(search_server);
+
+    // Копия разделяет кэш, изменение копии не влияет на оригинал
+    SearchServer copy = search_server;
+    copy.AddDocument(4, "nasty dog"s, DocumentStatus::ACTUAL, {1});
+    cout << copy.FindTopDocuments("curly nasty -rat"s).size() << " "s
+         << search_server.FindTopDocuments("curly nasty -rat"s).size() << endl;
+    PrintCacheStats(search_server);
+
+    search_server.RemoveDocument(2);
+    cout << search_server.FindTopDocuments("curly nasty -rat"s).size() << endl;
+    PrintCacheStats(search_server);
+}
+
+void TestTimeWorkQueryCache() {
+    WorkloadOptions options;
+    options.document_count = 50'000;
+    options.vocabulary_size = 2'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 1;
+    options.max_document_words = 10;
+    options.query_count = 500;
+    options.max_query_words = 4;
+    options.minus_word_share = 0.0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+    SearchServer search_server(workload.GetStopWords());
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, {1});
+    }
+
+    // Каждый запрос встречается в наборе многократно
+    const vector<string>& distinct_queries = workload.GetQueries();
+    mt19937 generator;
+    vector<string> queries;
+    for (int i = 0; i < 5'000; ++i) {
+        queries.push_back(distinct_queries[uniform_int_distribution<size_t>(0, distinct_queries.size() - 1)(generator)]);
+    }
+
+    vector<vector<Document>> expected;
+    {
+        LOG_DURATION("ProcessQueries without cache"sv);
+        expected = ProcessQueries(search_server, queries);
+    }
+    search_server.EnableQueryCache(1'000);
+    vector<vector<Document>> cached;
+    {
+        LOG_DURATION("ProcessQueries with cache"sv);
+        cached = ProcessQueries(search_server, queries);
+    }
+    bool same = expected.size() == cached.size();
+    for (size_t i = 0; same && i < expected.size(); ++i) {
+        same = expected[i].size() == cached[i].size();
+        for (size_t j = 0; same && j < expected[i].size(); ++j) {
+            same = expected[i][j].id == cached[i][j].id && expected[i][j].relevance == cached[i][j].relevance;
+        }
+    }
+    const QueryCacheStats stats = search_server.GetQueryCacheStats();
+    cout << (same ? "same"s : "differ"s) << " "s << stats.hits + stats.misses << endl;
+    cerr << "Query cache hit rate: "s << stats.HitRate() << endl;
+}
@@ -0,0 +1,305 @@
+#include "segments.h"
+
+#include "segmented_index.h"
+#include "../Lib/epoch_reclaimer.h"
+#include "../Lib/thread_priority.h"
+
+#include "log_duration.h"
+#include "search_server.h"
+#include "versioned_search_server.h"
+#include "workload.h"
+
+#include <atomic>
+#include <chrono>
+#include <execution>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+void TestWorkSegmented();
+void TestTimeWorkSegmented();
+
+void TestsSegmentedIndex() {
+    cout << "TestsSegmentedIndex"s << endl;
+    TestWorkSegmented();
+    TestTimeWorkSegmented();
+    cout << endl;
+}
+
+void TestWorkSegmented() {
+    SegmentedIndex index("and with"sv, SegmentedIndexOptions{2, 2, 0.75});
+
+    int id = 0;
+    for (
+        const string& text : {
+            "funny pet and nasty rat"s,
+            "funny pet with curly hair"s,
+            "funny pet and not very nasty rat"s,
+            "pet with rat and rat and rat"s,
+            "nasty rat with curly hair"s,
+        }
+    ) {
+        index.AddDocument(++id, text, DocumentStatus::ACTUAL, {1, 2, id});
+    }
+    index.Flush();
+    index.WaitForMerges();
+
+    const string query = "curly and funny -not"s;
+    auto report = [&index, &query] {
+        cout << index.GetDocumentCount() << " documents total, "s
+             << index.FindTopDocuments(query).size() << " documents for query ["s << query << "]"s << endl;
+    };
+    report();
+    for (const Document& document : index.FindTopDocuments(execution::par, query)) {
+        cout << document << endl;
+    }
+
+    // Удаления и добавления видны поиску сразу, без закрытия сегмента
+    index.RemoveDocument(2);
+    index.RemoveDocument(3);
+    report();
+    index.AddDocument(6, "curly dog"s, DocumentStatus::ACTUAL, {1});
+    index.AddDocument(7, "funny not curly"s, DocumentStatus::ACTUAL, {1});
+    report();
+    index.RemoveDocument(6);
+    index.AddDocument(6, "funny cat"s, DocumentStatus::ACTUAL, {1});
+    report();
+    index.Flush();
+    index.WaitForMerges();
+    cout << index.GetSegmentCount() << " segments"s << endl;
+    report();
+
+    // Читатели сверх количества ячеек закрепляются без ожидания и так же
+    // защищают замененные объекты
+    EpochReclaimer epochs;
+    bool reclaimed = false;
+    {
+        vector<EpochReclaimer::Guard> slot_guards;
+        for (size_t i = 0; i < EpochReclaimer::MAX_READERS; ++i) {
+            slot_guards.push_back(epochs.Pin());
+        }
+        vector<EpochReclaimer::Guard> overflow_guards;
+        for (int i = 0; i < 8; ++i) {
+            overflow_guards.push_back(epochs.Pin());
+        }
+        // Читатели с ячейками вышли, остались читатели из общего счетчика
+        slot_guards.clear();
+        epochs.Retire([&reclaimed] {
+            reclaimed = true;
+        });
+        epochs.Reclaim();
+        cout << "Reclaimed while pinned: "s << (reclaimed ? "yes"s : "no"s) << endl;
+    }
+    epochs.Reclaim();
+    cout << "Reclaimed after unpin: "s << (reclaimed ? "yes"s : "no"s) << endl;
+
+    // Чтение VersionedSearchServer видит копию, опубликованную до его начала,
+    // и не мешает писателю опубликовать следующую
+    VersionedSearchServer versioned("and with"sv);
+    versioned.AddDocument(1, "funny pet"s, DocumentStatus::ACTUAL, {1});
+    versioned.Read([&versioned](const SearchServer& server) {
+        versioned.AddDocument(2, "funny rat"s, DocumentStatus::ACTUAL, {1});
+        cout << server.GetDocumentCount() << " documents in pinned copy, "s
+             << versioned.GetDocumentCount() << " documents published"s << endl;
+    });
+    versioned.RemoveDocument(1);
+    versioned.Update([](SearchServer& server) {
+        server.AddDocument(3, "funny cat"s, DocumentStatus::ACTUAL, {1});
+        server.AddDocument(4, "nasty cat"s, DocumentStatus::ACTUAL, {1});
+    });
+    for (const Document& document : versioned.FindTopDocuments("funny cat"sv)) {
+        cout << document << endl;
+    }
+}
+
+// Медиана и 99-й перцентиль задержки запросов
+void ReportLatency(string_view mark, vector<int64_t> latencies) {
+    sort(latencies.begin(), latencies.end());
+    cerr << mark << ": p50 "s << latencies[latencies.size() / 2] << " us, p99 "s
+         << latencies[latencies.size() * 99 / 100] << " us"s << endl;
+}
+
+// Задержка поиска без записи и во время замены документов. Запросы
+// выполняются по расписанию с интервалом QUERY_INTERVAL, окнами по
+// LATENCY_WINDOW запросов. Писатель заменяет документы с интервалом
+// INGEST_INTERVAL в каждом втором окне, поэтому обе выборки застают
+// одинаковое состояние индекса и машины. Замена удаляет документ
+// и добавляет документ с тем же текстом, размер индекса не меняется.
+// Писатель работает с наименьшим приоритетом, как фоновый поток
+// SegmentedIndex: запись занимает процессор между запросами, а не во время них
+constexpr auto QUERY_INTERVAL = chrono::microseconds(4000);
+constexpr auto INGEST_INTERVAL = chrono::microseconds(500);
+constexpr size_t LATENCY_WINDOW = 100;
+
+template <typename Search, typename Replace>
+void ReportIngestLatency(const string& mark, const vector<string>& queries, Search search, Replace replace) {
+    using namespace chrono;
+    atomic<bool> done = false;
+    atomic<bool> ingesting = false;
+    int replaced = 0;
+    thread writer([&] {
+        SetIdleThreadPriority();
+        auto next_replace = steady_clock::now();
+        while (!done) {
+            if (!ingesting) {
+                this_thread::sleep_for(INGEST_INTERVAL);
+                next_replace = steady_clock::now();
+                continue;
+            }
+            replace(replaced++);
+            next_replace += INGEST_INTERVAL;
+            this_thread::sleep_until(next_replace);
+        }
+    });
+
+    vector<int64_t> idle_latencies;
+    vector<int64_t> ingest_latencies;
+    auto next_query = steady_clock::now();
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const bool ingest_window = i / LATENCY_WINDOW % 2 == 1;
+        ingesting = ingest_window;
+        this_thread::sleep_until(next_query);
+        next_query += QUERY_INTERVAL;
+        const auto start = steady_clock::now();
+        search(queries[i]);
+        (ingest_window ? ingest_latencies : idle_latencies)
+            .push_back(duration_cast<microseconds>(steady_clock::now() - start).count());
+    }
+    done = true;
+    writer.join();
+    ReportLatency(mark + " idle"s, move(idle_latencies));
+    ReportLatency(mark + " ingest"s, move(ingest_latencies));
+    cerr << mark << " ingest: "s << replaced << " documents replaced"s << endl;
+}
+
+bool EqualResults(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                 [](const Document& lhs, const Document& rhs) {
+        return lhs.id == rhs.id && lhs.relevance == rhs.relevance && lhs.rating == rhs.rating;
+    });
+}
+
+void TestTimeWorkSegmented() {
+    WorkloadOptions options;
+    options.document_count = 100'000;
+    options.vocabulary_size = 10'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 1;
+    options.max_document_words = 100;
+    options.query_count = 2'000;
+    options.max_query_words = 10;
+    options.minus_word_share = 0.0;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+    vector<string> documents;
+    for (const GeneratedDocument& document : workload.GetDocuments()) {
+        documents.push_back(document.text);
+    }
+    const vector<string>& queries = workload.GetQueries();
+
+    SearchServer search_server(workload.GetStopWords());
+    {
+        LOG_DURATION("SearchServer AddDocument"sv);
+        for (int id = 0; id < static_cast<int>(documents.size()); ++id) {
+            search_server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+    }
+    SegmentedIndex index(workload.GetStopWords());
+    {
+        LOG_DURATION("SegmentedIndex AddDocument"sv);
+        for (int id = 0; id < static_cast<int>(documents.size()); ++id) {
+            index.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        index.Flush();
+        index.WaitForMerges();
+    }
+    for (int id = 0; id < static_cast<int>(documents.size()); id += 7) {
+        search_server.RemoveDocument(id);
+        index.RemoveDocument(id);
+    }
+    index.Flush();
+    index.WaitForMerges();
+
+    int mismatches = 0;
+    {
+        LOG_DURATION("SearchServer FindTopDocuments"sv);
+        for (const string& query : queries) {
+            mismatches += search_server.FindTopDocuments(query).size() > 5;
+        }
+    }
+    {
+        LOG_DURATION("SegmentedIndex FindTopDocuments"sv);
+        for (const string& query : queries) {
+            mismatches += index.FindTopDocuments(query).size() > 5;
+        }
+    }
+    {
+        LOG_DURATION("SegmentedIndex FindTopDocuments par"sv);
+        for (const string& query : queries) {
+            mismatches += index.FindTopDocuments(execution::par, query).size() > 5;
+        }
+    }
+    for (const string& query : queries) {
+        mismatches += !EqualResults(search_server.FindTopDocuments(query), index.FindTopDocuments(query));
+    }
+    VersionedSearchServer versioned(search_server);
+
+    // Документы изменяемого сегмента, в том числе удаленные, учитываются
+    // так же, как в SearchServer
+    const int first_memtable_id = static_cast<int>(documents.size());
+    for (int id = first_memtable_id; id < first_memtable_id + 1000; ++id) {
+        search_server.AddDocument(id, documents[id % documents.size()], DocumentStatus::ACTUAL, {1});
+        index.AddDocument(id, documents[id % documents.size()], DocumentStatus::ACTUAL, {1});
+        versioned.AddDocument(id, documents[id % documents.size()], DocumentStatus::ACTUAL, {1});
+    }
+    for (int id = first_memtable_id; id < first_memtable_id + 1000; id += 3) {
+        search_server.RemoveDocument(id);
+        index.RemoveDocument(id);
+        versioned.RemoveDocument(id);
+    }
+    for (const string& query : queries) {
+        mismatches += !EqualResults(search_server.FindTopDocuments(query), index.FindTopDocuments(query));
+        mismatches += !EqualResults(search_server.FindTopDocuments(query), versioned.FindTopDocuments(query));
+    }
+    cout << mismatches << " mismatched queries"s << endl;
+
+    // SearchServer требует внешней блокировки, VersionedSearchServer
+    // и сегментированный индекс - нет. Заменяются неудаленные документы
+    // исходного набора, id которых не кратны 7
+    const int first_extra_id = first_memtable_id + 1000;
+    auto replaced_id = [](int replaced) {
+        return replaced / 6 * 7 + replaced % 6 + 1;
+    };
+    {
+        mutex server_mutex;
+        ReportIngestLatency("SearchServer"s, queries, [&](const string& query) {
+            lock_guard lock(server_mutex);
+            search_server.FindTopDocuments(query);
+        }, [&](int replaced) {
+            const int id = replaced_id(replaced);
+            lock_guard lock(server_mutex);
+            search_server.RemoveDocument(id);
+            search_server.AddDocument(first_extra_id + replaced, documents[id], DocumentStatus::ACTUAL, {1});
+        });
+    }
+    ReportIngestLatency("VersionedSearchServer"s, queries, [&](const string& query) {
+        versioned.FindTopDocuments(query);
+    }, [&](int replaced) {
+        const int id = replaced_id(replaced);
+        versioned.Update([&documents, id, new_id = first_extra_id + replaced](SearchServer& server) {
+            server.RemoveDocument(id);
+            server.AddDocument(new_id, documents[id], DocumentStatus::ACTUAL, {1});
+        });
+    });
+    ReportIngestLatency("SegmentedIndex"s, queries, [&](const string& query) {
+        index.FindTopDocuments(query);
+    }, [&](int replaced) {
+        const int id = replaced_id(replaced);
+        index.RemoveDocument(id);
+        index.AddDocument(first_extra_id + replaced, documents[id], DocumentStatus::ACTUAL, {1});
+    });
+}
@@ -0,0 +1,180 @@
+#include "snapshot.h"
+
+#include "log_duration.h"
+#include "search_server.h"
+#include "snapshot_file.h"
+#include "workload.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void TestWorkSnapshot();
+void TestTimeWorkSnapshot();
+
+void TestsSnapshot() {
+    cout << "TestsSnapshot"s << endl;
+    TestWorkSnapshot();
+    TestTimeWorkSnapshot();
+    cout << endl;
+}
+
+void TestWorkSnapshot() {
+    const string path = (filesystem::temp_directory_path() / "search_server_test.snapshot"s).string();
+    {
+        SearchServer search_server("and with"s);
+        int id = 0;
+        for (
+            const string& text : {
+                "funny pet and nasty rat"s,
+                "funny pet with curly hair"s,
+                "funny pet and not very nasty rat"s,
+                "pet with rat and rat and rat"s,
+                "nasty rat with curly hair"s,
+            }
+        ) {
+            search_server.AddDocument(++id, text, DocumentStatus::ACTUAL, {1, 2, id});
+        }
+        search_server.RemoveDocument(3);
+        search_server.SaveSnapshot(path);
+    }
+
+    SearchServer search_server = SearchServer::LoadSnapshot(path);
+    const string query = "curly and funny -not"s;
+    cout << search_server.GetDocumentCount() << " documents total, "s
+         << search_server.FindTopDocuments(query).size() << " documents for query ["s << query << "]"s << endl;
+    for (const Document& document : search_server.FindTopDocuments(query)) {
+        cout << document << endl;
+    }
+    const auto [words, status] = search_server.MatchDocument("curly rat"s, 5);
+    cout << words.size() << " words matched in document 5"s << endl;
+
+    // Добавление после загрузки продолжает словарь снимка
+    search_server.AddDocument(6, "curly dog"s, DocumentStatus::ACTUAL, {1});
+    cout << search_server.FindTopDocuments("curly"s).size() << " documents for query [curly]"s << endl;
+
+    // Поврежденный байт данных обнаруживается контрольной суммой
+    {
+        fstream file(path, ios::in | ios::out | ios::binary);
+        file.seekp(-3, ios::end);
+        file.put('\x7f');
+    }
+    try {
+        SearchServer::LoadSnapshot(path);
+    } catch (const runtime_error& e) {
+        cout << "Corrupt snapshot rejected: "s << e.what() << endl;
+    }
+
+    // Снимок с верной контрольной суммой, но недопустимыми вхождениями
+    // слова cat: два документа содержат его с частотой 1
+    const auto write_snapshot = [&path](const vector<int>& posting_ids,
+                                        const vector<string_view>& words = {"cat"sv}) {
+        SnapshotWriter writer;
+        writer.WriteStrings({});
+        writer.WriteStrings(words);
+        writer.WriteValue<uint64_t>(1);
+        writer.WriteArray(vector<uint64_t>{0, posting_ids.size()});
+        writer.WriteArray(posting_ids);
+        writer.WriteArray(vector<double>(posting_ids.size(), 1.0));
+        writer.WriteArray(vector<double>{1.0});
+        writer.WriteValue<uint64_t>(2);
+        writer.WriteArray(vector<int>{1, 2});
+        writer.WriteArray(vector<int>{5, 5});
+        writer.WriteArray(vector<int>{DocumentStatus::ACTUAL, DocumentStatus::ACTUAL});
+        writer.WriteArray(vector<uint64_t>{0, 1, 2});
+        vector<TermFrequency> document_terms(2);
+        document_terms[0].term = document_terms[1].term = 0;
+        document_terms[0].freq = document_terms[1].freq = 1.0;
+        writer.WriteArray(document_terms);
+        writer.Save(path);
+    };
+    // Такие ошибки не меняют контрольную сумму и обнаруживаются только
+    // полной проверкой
+    for (const vector<int>& posting_ids : {vector{1, 2}, vector{2, 1}, vector{1, 1}, vector{1, 7}, vector{1}}) {
+        write_snapshot(posting_ids);
+        try {
+            cout << SearchServer::LoadSnapshot(path, true).FindTopDocuments("cat"s).size()
+                 << " documents for query [cat]"s << endl;
+        } catch (const runtime_error& e) {
+            cout << "Corrupt postings rejected: "s << e.what() << endl;
+        }
+    }
+    // Пустое или повторное слово словаря: вхождения второго id недостижимы
+    for (const vector<string_view>& words : {vector{"cat"sv, "cat"sv}, vector{"cat"sv, ""sv}}) {
+        write_snapshot({1, 2}, words);
+        try {
+            SearchServer::LoadSnapshot(path);
+        } catch (const runtime_error& e) {
+            cout << "Corrupt dictionary rejected: "s << e.what() << endl;
+        }
+    }
+    filesystem::remove(path);
+}
+
+void TestTimeWorkSnapshot() {
+    WorkloadOptions options;
+    options.document_count = 100'000;
+    options.vocabulary_size = 10'000;
+    options.zipf_exponent = 0.0;
+    options.min_document_words = 1;
+    options.max_document_words = 100;
+    options.query_count = 1'000;
+    options.max_query_words = 10;
+    options.duplicate_share = 0.0;
+    const Workload workload(options);
+    const string path = (filesystem::temp_directory_path() / "search_server_time.snapshot"s).string();
+
+    SearchServer search_server(workload.GetStopWords());
+    {
+        LOG_DURATION("AddDocument"sv);
+        for (const GeneratedDocument& document : workload.GetDocuments()) {
+            search_server.AddDocument(document.id, document.text, DocumentStatus::ACTUAL, document.ratings);
+        }
+    }
+    {
+        LOG_DURATION("SaveSnapshot"sv);
+        search_server.SaveSnapshot(path);
+    }
+    {
+        LOG_DURATION("LoadSnapshot"sv);
+        const SearchServer loaded = SearchServer::LoadSnapshot(path);
+        cout << loaded.GetDocumentCount() << endl;
+    }
+    {
+        LOG_DURATION("LoadSnapshot verify"sv);
+        const SearchServer loaded = SearchServer::LoadSnapshot(path, true);
+        cout << loaded.GetDocumentCount() << endl;
+    }
+
+    // Загруженный сервер находит те же документы, в том числе после
+    // изменений, которые копируют затронутые списки из снимка
+    SearchServer loaded = SearchServer::LoadSnapshot(path);
+    const auto count_mismatches = [&search_server, &loaded, &workload] {
+        int mismatches = 0;
+        for (const string& query : workload.GetQueries()) {
+            const auto expected = search_server.FindTopDocuments(query);
+            const auto actual = loaded.FindTopDocuments(query);
+            mismatches += !equal(expected.begin(), expected.end(), actual.begin(), actual.end(),
+                                 [](const Document& lhs, const Document& rhs) {
+                return lhs.id == rhs.id && lhs.relevance == rhs.relevance && lhs.rating == rhs.rating;
+            });
+        }
+        return mismatches;
+    };
+    int mismatches = count_mismatches();
+    for (int id = 0; id < 1'000; id += 3) {
+        search_server.RemoveDocument(id);
+        loaded.RemoveDocument(id);
+    }
+    const GeneratedDocument& document = workload.GetDocuments().back();
+    search_server.AddDocument(document.id + 1, document.text, DocumentStatus::ACTUAL, {1});
+    loaded.AddDocument(document.id + 1, document.text, DocumentStatus::ACTUAL, {1});
+    mismatches += count_mismatches();
+    cout << mismatches << " mismatched queries"s << endl;
+    filesystem::remove(path);
+}
@@ -0,0 +1,115 @@
+#include "workload.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+ZipfDistribution::ZipfDistribution(size_t size, double exponent) : cumulative_(max<size_t>(size, 1)) {
+    double sum = 0.0;
+    for (size_t rank = 0; rank < cumulative_.size(); ++rank) {
+        sum += 1.0 / pow(rank + 1.0, exponent);
+        cumulative_[rank] = sum;
+    }
+    for (double& value : cumulative_) {
+        value /= sum;
+    }
+}
+
+size_t ZipfDistribution::operator()(mt19937_64& generator) const {
+    const double value = uniform_real_distribution<double>(0.0, 1.0)(generator);
+    const auto it = lower_bound(cumulative_.begin(), cumulative_.end(), value);
+    return min<size_t>(it - cumulative_.begin(), cumulative_.size() - 1);
+}
+
+namespace {
+
+string GenerateWord(mt19937_64& generator, size_t index) {
+    // Номер слова в начале гарантирует отсутствие повторов в словаре
+    string word;
+    for (size_t rest = index; ; rest /= 26) {
+        word.push_back(static_cast<char>('a' + rest % 26));
+        if (rest < 26) {
+            break;
+        }
+    }
+    const int tail_length = uniform_int_distribution(0, 6)(generator);
+    word.push_back('q');
+    for (int i = 0; i < tail_length; ++i) {
+        word.push_back(uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+} // namespace
+
+Workload::Workload(const WorkloadOptions& options)
+    : options_(options)
+    , zipf_(options.vocabulary_size, options.zipf_exponent) {
+    mt19937_64 generator(options_.seed);
+    vocabulary_.reserve(options_.vocabulary_size);
+    for (size_t i = 0; i < options_.vocabulary_size; ++i) {
+        vocabulary_.push_back(GenerateWord(generator, i));
+    }
+    // Самые частые слова - стоп-слова, как в настоящих текстах
+    for (size_t i = 0; i < min<size_t>(3, vocabulary_.size()); ++i) {
+        stop_words_ += vocabulary_[i] + " "s;
+    }
+
+    documents_.reserve(options_.document_count);
+    for (size_t id = 0; id < options_.document_count; ++id) {
+        GeneratedDocument document{static_cast<int>(id), {}, {}};
+        if (!documents_.empty() && uniform_real_distribution(0.0, 1.0)(generator) < options_.duplicate_share) {
+            document.text = documents_[uniform_int_distribution<size_t>(0, documents_.size() - 1)(generator)].text;
+        } else {
+            const size_t word_count = uniform_int_distribution(options_.min_document_words,
+                                                               options_.max_document_words)(generator);
+            document.text = GenerateText(generator, word_count);
+        }
+        const int rating_count = uniform_int_distribution(1, 5)(generator);
+        for (int i = 0; i < rating_count; ++i) {
+            document.ratings.push_back(uniform_int_distribution(-10, 10)(generator));
+        }
+        documents_.push_back(move(document));
+    }
+
+    queries_.reserve(options_.query_count);
+    for (size_t i = 0; i < options_.query_count; ++i) {
+        const size_t word_count = uniform_int_distribution<size_t>(1, max<size_t>(options_.max_query_words, 1))(generator);
+        queries_.push_back(GenerateText(generator, word_count, options_.minus_word_share));
+    }
+}
+
+string Workload::GenerateText(mt19937_64& generator, size_t word_count, double minus_word_share) const {
+    string text;
+    for (size_t i = 0; i < word_count; ++i) {
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+        if (minus_word_share > 0.0 && uniform_real_distribution(0.0, 1.0)(generator) < minus_word_share) {
+            text.push_back('-');
+        }
+        text += vocabulary_[zipf_(generator)];
+    }
+    return text;
+}
+
+const WorkloadOptions& Workload::GetOptions() const noexcept {
+    return options_;
+}
+
+const vector<string>& Workload::GetVocabulary() const noexcept {
+    return vocabulary_;
+}
+
+const vector<GeneratedDocument>& Workload::GetDocuments() const noexcept {
+    return documents_;
+}
+
+const vector<string>& Workload::GetQueries() const noexcept {
+    return queries_;
+}
+
+const string& Workload::GetStopWords() const noexcept {
+    return stop_words_;
+}
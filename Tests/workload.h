@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Параметры синтетической нагрузки. При одинаковых параметрах
+// генерируются одинаковые документы и запросы
+struct WorkloadOptions {
+    uint64_t seed = 42;
+    size_t document_count = 50'000;
+    size_t vocabulary_size = 50'000;
+    // Показатель распределения Ципфа частот слов, 0 - равномерное
+    double zipf_exponent = 1.0;
+    size_t min_document_words = 5;
+    size_t max_document_words = 30;
+    size_t query_count = 5'000;
+    size_t max_query_words = 5;
+    // Доля минус-слов в запросах
+    double minus_word_share = 0.1;
+    // Доля документов, повторяющих набор слов одного из предыдущих
+    double duplicate_share = 0.1;
+};
+
+// Выбор номера слова по распределению Ципфа по заранее посчитанным
+// накопленным вероятностям
+class ZipfDistribution {
+public:
+    ZipfDistribution(size_t size, double exponent);
+
+    size_t operator()(std::mt19937_64& generator) const;
+
+private:
+    std::vector<double> cumulative_;
+};
+
+struct GeneratedDocument {
+    int id;
+    std::string text;
+    std::vector<int> ratings;
+};
+
+class Workload {
+public:
+    explicit Workload(const WorkloadOptions& options);
+
+    const WorkloadOptions& GetOptions() const noexcept;
+    const std::vector<std::string>& GetVocabulary() const noexcept;
+    const std::vector<GeneratedDocument>& GetDocuments() const noexcept;
+    const std::vector<std::string>& GetQueries() const noexcept;
+    const std::string& GetStopWords() const noexcept;
+
+    // Текст из word_count слов словаря с тем же распределением Ципфа.
+    // Каждое слово с вероятностью minus_word_share становится минус-словом
+    std::string GenerateText(std::mt19937_64& generator, size_t word_count, double minus_word_share = 0.0) const;
+
+private:
+    WorkloadOptions options_;
+    std::string stop_words_;
+    std::vector<std::string> vocabulary_;
+    ZipfDistribution zipf_;
+    std::vector<GeneratedDocument> documents_;
+    std::vector<std::string> queries_;
+};
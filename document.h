@@ -1,4 +1,5 @@
 #pragma once
+#include <cmath>
 #include <iostream>
 
 enum DocumentStatus {
@@ -18,3 +19,20 @@ struct Document {
 };
 
 std::ostream& operator<<(std::ostream& out, const Document& doc);
+
+// Сравнение документов при выборе наиболее релевантных:
+// при практически равной релевантности выше документ с большим рейтингом,
+// при равном рейтинге - документ с меньшим id
+struct MoreRelevant {
+    bool operator()(const Document& lhs, const Document& rhs) const {
+        const double about_zero = 1e-6;
+        if (std::abs(lhs.relevance - rhs.relevance) < about_zero) {
+            if (lhs.rating != rhs.rating) {
+                return lhs.rating > rhs.rating;
+            }
+            return lhs.id < rhs.id;
+        } else {
+            return lhs.relevance > rhs.relevance;
+        }
+    }
+};
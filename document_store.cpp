@@ -0,0 +1,172 @@
+#include "document_store.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+DocumentStore::DocumentStore(const DocumentStore& other)
+    : current_chunk_(other.current_chunk_)
+    , locations_(other.locations_)
+    , holes_(other.holes_)
+    , capacity_(other.capacity_)
+    , used_(other.used_) {
+    chunks_.resize(other.chunks_.size());
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        const Chunk& source = other.chunks_[i];
+        Chunk& chunk = chunks_[i];
+        chunk.size = source.size;
+        chunk.end = source.end;
+        chunk.used = source.used;
+        if (source.data) {
+            chunk.data.reset(new char[source.size]);
+            memcpy(chunk.data.get(), source.data.get(), source.end);
+        }
+    }
+}
+
+DocumentStore& DocumentStore::operator=(const DocumentStore& other) {
+    if (this != &other) {
+        *this = DocumentStore(other);
+    }
+    return *this;
+}
+
+string_view DocumentStore::Add(int document_id, string_view text) {
+    Location location{NO_CHUNK, 0, text.size()};
+    if (!text.empty()) {
+        location = Allocate(text.size());
+        memcpy(chunks_[location.chunk].data.get() + location.offset, text.data(), text.size());
+        chunks_[location.chunk].used += text.size();
+        used_ += text.size();
+    }
+    locations_[document_id] = location;
+    return View(location);
+}
+
+string_view DocumentStore::Get(int document_id) const {
+    const auto it = locations_.find(document_id);
+    return it == locations_.end() ? string_view{} : View(it->second);
+}
+
+void DocumentStore::Remove(int document_id) {
+    const auto it = locations_.find(document_id);
+    if (it == locations_.end()) {
+        return;
+    }
+    const Location location = it->second;
+    locations_.erase(it);
+    if (location.size == 0) {
+        return;
+    }
+
+    Chunk& chunk = chunks_[location.chunk];
+    chunk.used -= location.size;
+    used_ -= location.size;
+    // Последний текст блока просто отрезается от заполненной части
+    if (location.offset + location.size == chunk.end) {
+        chunk.end = location.offset;
+    } else {
+        holes_.emplace(location.size, location);
+    }
+}
+
+void DocumentStore::Compact() {
+    vector<Location> holes;
+    holes.reserve(holes_.size());
+    for (const auto& [size, hole] : holes_) {
+        holes.push_back(hole);
+    }
+    sort(holes.begin(), holes.end(), [](const Location& lhs, const Location& rhs) {
+        return lhs.chunk < rhs.chunk || (lhs.chunk == rhs.chunk && lhs.offset < rhs.offset);
+    });
+
+    // Объединение соседних свободных участков одного блока
+    vector<Location> merged_holes;
+    for (const Location& hole : holes) {
+        if (!merged_holes.empty() && merged_holes.back().chunk == hole.chunk
+            && merged_holes.back().offset + merged_holes.back().size == hole.offset) {
+            merged_holes.back().size += hole.size;
+        } else {
+            merged_holes.push_back(hole);
+        }
+    }
+
+    holes_.clear();
+    // Участки обходятся от конца, чтобы отрезать от заполненной части
+    // каждый участок, примыкающий к ее границе
+    for (auto it = merged_holes.rbegin(); it != merged_holes.rend(); ++it) {
+        Chunk& chunk = chunks_[it->chunk];
+        if (chunk.used == 0) {
+            continue;
+        }
+        if (it->offset + it->size == chunk.end) {
+            chunk.end = it->offset;
+        } else {
+            holes_.emplace(it->size, *it);
+        }
+    }
+
+    // Блоки без текстов освобождаются
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        Chunk& chunk = chunks_[i];
+        if (chunk.data && chunk.used == 0) {
+            capacity_ -= chunk.size;
+            chunk = Chunk{};
+            if (current_chunk_ == i) {
+                current_chunk_ = NO_CHUNK;
+            }
+        }
+    }
+}
+
+size_t DocumentStore::Capacity() const noexcept {
+    return capacity_;
+}
+
+size_t DocumentStore::UsedSize() const noexcept {
+    return used_;
+}
+
+// Выбор места для текста: наименьший подходящий свободный участок,
+// затем конец текущего блока, затем новый блок
+DocumentStore::Location DocumentStore::Allocate(size_t size) {
+    const auto hole_it = holes_.lower_bound(size);
+    if (hole_it != holes_.end()) {
+        const Location hole = hole_it->second;
+        holes_.erase(hole_it);
+        if (hole.size > size) {
+            holes_.emplace(hole.size - size, Location{hole.chunk, hole.offset + size, hole.size - size});
+        }
+        return {hole.chunk, hole.offset, size};
+    }
+
+    if (current_chunk_ == NO_CHUNK || chunks_[current_chunk_].size - chunks_[current_chunk_].end < size) {
+        current_chunk_ = AllocateChunk(max(CHUNK_SIZE, size));
+    }
+    Chunk& chunk = chunks_[current_chunk_];
+    const Location location{current_chunk_, chunk.end, size};
+    chunk.end += size;
+    return location;
+}
+
+size_t DocumentStore::AllocateChunk(size_t size) {
+    const auto it = find_if(chunks_.begin(), chunks_.end(), [](const Chunk& chunk) {
+        return !chunk.data;
+    });
+    const size_t index = it != chunks_.end() ? static_cast<size_t>(it - chunks_.begin()) : chunks_.size();
+    if (index == chunks_.size()) {
+        chunks_.emplace_back();
+    }
+    chunks_[index].data.reset(new char[size]);
+    chunks_[index].size = size;
+    capacity_ += size;
+    return index;
+}
+
+string_view DocumentStore::View(const Location& location) const {
+    if (location.size == 0) {
+        return {};
+    }
+    return {chunks_[location.chunk].data.get() + location.offset, location.size};
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Хранилище текстов документов. Тексты копируются в крупные блоки памяти,
+// одно выделение приходится на много документов. Текст не перемещается,
+// пока документ не удален, поэтому string_view, полученный из хранилища,
+// действителен все время жизни документа.
+// Место удаленного текста помечается свободным и отдается новым текстам,
+// Compact объединяет соседние свободные участки и освобождает блоки,
+// в которых не осталось текстов
+class DocumentStore {
+public:
+    DocumentStore() = default;
+    // Копия хранилища владеет собственными копиями текстов
+    DocumentStore(const DocumentStore& other);
+    DocumentStore& operator=(const DocumentStore& other);
+    DocumentStore(DocumentStore&&) noexcept = default;
+    DocumentStore& operator=(DocumentStore&&) noexcept = default;
+
+    // Копирование текста документа, которого еще нет в хранилище
+    std::string_view Add(int document_id, std::string_view text);
+    // Текст документа, пустая строка если документа нет
+    std::string_view Get(int document_id) const;
+    // Освобождение места текста
+    void Remove(int document_id);
+    void Compact();
+
+    // Объем выделенных блоков и объем, занятый текстами
+    size_t Capacity() const noexcept;
+    size_t UsedSize() const noexcept;
+
+private:
+    static constexpr size_t CHUNK_SIZE = 1024 * 1024;
+    static constexpr size_t NO_CHUNK = static_cast<size_t>(-1);
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+        // Граница заполненной части блока
+        size_t end = 0;
+        // Объем текстов в блоке
+        size_t used = 0;
+    };
+    struct Location {
+        size_t chunk;
+        size_t offset;
+        size_t size;
+    };
+
+    // Освобожденные блоки остаются в векторе пустыми, чтобы не менять номера остальных
+    std::vector<Chunk> chunks_;
+    size_t current_chunk_ = NO_CHUNK;
+    std::unordered_map<int, Location> locations_;
+    // Свободные участки по размеру, выбирается наименьший подходящий
+    std::multimap<size_t, Location> holes_;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+
+    Location Allocate(size_t size);
+    size_t AllocateChunk(size_t size);
+    std::string_view View(const Location& location) const;
+};
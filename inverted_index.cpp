@@ -0,0 +1,275 @@
+#include "inverted_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+using namespace std;
+
+PostingList::PostingList(const int* document_ids, const double* term_freqs, size_t count, double max_term_freq)
+    : external_ids_(document_ids)
+    , external_freqs_(term_freqs)
+    , external_size_(count)
+    , max_term_freq_(max_term_freq) {
+    UpdateLogDocumentFreq();
+}
+
+void PostingList::Add(int document_id, double term_freq) {
+    Own();
+    // Документы как правило добавляются с возрастающими id
+    if (document_ids_.empty() || document_ids_.back() < document_id) {
+        document_ids_.push_back(document_id);
+        term_freqs_.push_back(term_freq);
+        max_term_freq_ = max(max_term_freq_, term_freq);
+        UpdateLogDocumentFreq();
+        return;
+    }
+
+    const size_t pos = LowerBound(document_id);
+    if (document_ids_[pos] == document_id) {
+        term_freqs_[pos] += term_freq;
+        max_term_freq_ = max(max_term_freq_, term_freqs_[pos]);
+        return;
+    }
+    document_ids_.insert(next(document_ids_.begin(), pos), document_id);
+    term_freqs_.insert(next(term_freqs_.begin(), pos), term_freq);
+    max_term_freq_ = max(max_term_freq_, term_freq);
+    UpdateLogDocumentFreq();
+}
+
+void PostingList::Merge(const int* document_ids, const double* term_freqs, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    Own();
+    max_term_freq_ = max(max_term_freq_, *max_element(term_freqs, term_freqs + count));
+
+    if (document_ids_.empty() || document_ids_.back() < document_ids[0]) {
+        document_ids_.insert(document_ids_.end(), document_ids, document_ids + count);
+        term_freqs_.insert(term_freqs_.end(), term_freqs, term_freqs + count);
+        UpdateLogDocumentFreq();
+        return;
+    }
+
+    vector<int> merged_ids;
+    vector<double> merged_freqs;
+    merged_ids.reserve(document_ids_.size() + count);
+    merged_freqs.reserve(document_ids_.size() + count);
+    size_t old_pos = 0;
+    size_t new_pos = 0;
+    while (old_pos < document_ids_.size() || new_pos < count) {
+        if (new_pos == count
+            || (old_pos < document_ids_.size() && document_ids_[old_pos] < document_ids[new_pos])) {
+            merged_ids.push_back(document_ids_[old_pos]);
+            merged_freqs.push_back(term_freqs_[old_pos]);
+            ++old_pos;
+        } else {
+            merged_ids.push_back(document_ids[new_pos]);
+            merged_freqs.push_back(term_freqs[new_pos]);
+            ++new_pos;
+        }
+    }
+    document_ids_ = move(merged_ids);
+    term_freqs_ = move(merged_freqs);
+    UpdateLogDocumentFreq();
+}
+
+bool PostingList::Remove(int document_id) {
+    const size_t pos = LowerBound(document_id);
+    if (pos == size() || DocumentIds()[pos] != document_id) {
+        return false;
+    }
+    Own();
+    const double term_freq = term_freqs_[pos];
+    document_ids_.erase(next(document_ids_.begin(), pos));
+    term_freqs_.erase(next(term_freqs_.begin(), pos));
+    if (term_freq == max_term_freq_) {
+        max_term_freq_ = term_freqs_.empty() ? 0.0 : *max_element(term_freqs_.begin(), term_freqs_.end());
+    }
+    UpdateLogDocumentFreq();
+    return true;
+}
+
+size_t PostingList::Remove(const int* document_ids, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    Own();
+    // Элементы до первого удаляемого документа остаются на месте
+    size_t write_pos = LowerBound(document_ids[0]);
+    size_t remove_pos = 0;
+    bool max_removed = false;
+    for (size_t read_pos = write_pos; read_pos < document_ids_.size(); ++read_pos) {
+        const int document_id = document_ids_[read_pos];
+        while (remove_pos < count && document_ids[remove_pos] < document_id) {
+            ++remove_pos;
+        }
+        if (remove_pos < count && document_ids[remove_pos] == document_id) {
+            max_removed = max_removed || term_freqs_[read_pos] == max_term_freq_;
+            continue;
+        }
+        document_ids_[write_pos] = document_id;
+        term_freqs_[write_pos] = term_freqs_[read_pos];
+        ++write_pos;
+    }
+
+    const size_t removed = document_ids_.size() - write_pos;
+    document_ids_.resize(write_pos);
+    term_freqs_.resize(write_pos);
+    if (max_removed) {
+        max_term_freq_ = term_freqs_.empty() ? 0.0 : *max_element(term_freqs_.begin(), term_freqs_.end());
+    }
+    if (removed != 0) {
+        UpdateLogDocumentFreq();
+    }
+    return removed;
+}
+
+size_t PostingList::LowerBound(int document_id) const {
+    const int* ids = DocumentIds();
+    return lower_bound(ids, ids + size(), document_id) - ids;
+}
+
+size_t PostingList::UpperBound(int document_id) const {
+    const int* ids = DocumentIds();
+    return upper_bound(ids, ids + size(), document_id) - ids;
+}
+
+const int* PostingList::DocumentIds() const noexcept {
+    return external_ids_ != nullptr ? external_ids_ : document_ids_.data();
+}
+
+const double* PostingList::TermFreqs() const noexcept {
+    return external_freqs_ != nullptr ? external_freqs_ : term_freqs_.data();
+}
+
+double PostingList::MaxTermFreq() const noexcept {
+    return max_term_freq_;
+}
+
+double PostingList::LogDocumentFreq() const noexcept {
+    return log_document_freq_;
+}
+
+void PostingList::Own() {
+    if (external_ids_ == nullptr) {
+        return;
+    }
+    document_ids_.assign(external_ids_, external_ids_ + external_size_);
+    term_freqs_.assign(external_freqs_, external_freqs_ + external_size_);
+    external_ids_ = nullptr;
+    external_freqs_ = nullptr;
+    external_size_ = 0;
+}
+
+void PostingList::UpdateLogDocumentFreq() {
+    log_document_freq_ = empty() ? 0.0 : log(static_cast<double>(size()));
+}
+
+size_t PostingList::size() const noexcept {
+    return external_ids_ != nullptr ? external_size_ : document_ids_.size();
+}
+
+bool PostingList::empty() const noexcept {
+    return size() == 0;
+}
+
+DocumentTerms::DocumentTerms(vector<TermFrequency> terms) noexcept
+    : terms_(move(terms)) {
+}
+
+DocumentTerms::DocumentTerms(const TermFrequency* terms, size_t count) noexcept
+    : external_(terms)
+    , external_size_(count) {
+}
+
+const TermFrequency* DocumentTerms::begin() const noexcept {
+    return data();
+}
+
+const TermFrequency* DocumentTerms::end() const noexcept {
+    return data() + size();
+}
+
+const TermFrequency* DocumentTerms::data() const noexcept {
+    return external_ != nullptr ? external_ : terms_.data();
+}
+
+const TermFrequency& DocumentTerms::operator[](size_t index) const noexcept {
+    return data()[index];
+}
+
+size_t DocumentTerms::size() const noexcept {
+    return external_ != nullptr ? external_size_ : terms_.size();
+}
+
+bool DocumentTerms::empty() const noexcept {
+    return size() == 0;
+}
+
+vector<TermFrequency>& DocumentTerms::Mutable() {
+    if (external_ != nullptr) {
+        terms_.assign(external_, external_ + external_size_);
+        external_ = nullptr;
+        external_size_ = 0;
+    }
+    return terms_;
+}
+
+const TermFrequency* FindTerm(const DocumentTerms& document_terms, TermId term) {
+    const auto it = lower_bound(document_terms.begin(), document_terms.end(), term,
+                                [](const TermFrequency& lhs, TermId rhs) {
+        return lhs.term < rhs;
+    });
+    return it != document_terms.end() && it->term == term ? &*it : nullptr;
+}
+
+PostingList& InvertedIndex::operator[](TermId term) {
+    if (term >= postings_.size()) {
+        postings_.resize(static_cast<size_t>(term) + 1);
+    }
+    return postings_[term];
+}
+
+void InvertedIndex::Resize(size_t term_count) {
+    if (term_count > postings_.size()) {
+        postings_.resize(term_count);
+    }
+}
+
+void InvertedIndex::Renumber(const vector<TermId>& new_ids, size_t term_count) {
+    vector<PostingList> postings(term_count);
+    for (TermId term = 0; term < postings_.size() && term < new_ids.size(); ++term) {
+        if (new_ids[term] != TermDictionary::NO_TERM) {
+            postings[new_ids[term]] = move(postings_[term]);
+        }
+    }
+    postings_ = move(postings);
+}
+
+const PostingList* InvertedIndex::Find(TermId term) const {
+    if (term >= postings_.size() || postings_[term].empty()) {
+        return nullptr;
+    }
+    return &postings_[term];
+}
+
+void InvertedIndex::SetDocumentCount(size_t document_count) {
+    log_document_count_ = document_count == 0 ? 0.0 : log(static_cast<double>(document_count));
+}
+
+double InvertedIndex::InverseDocumentFreq(const PostingList& postings) const noexcept {
+    return log_document_count_ - postings.LogDocumentFreq();
+}
+
+TermStatistics InvertedIndex::GetStatistics(TermId term) const {
+    const PostingList* postings = Find(term);
+    if (postings == nullptr) {
+        return {};
+    }
+    return {postings->size(), InverseDocumentFreq(*postings), postings->MaxTermFreq()};
+}
+
+size_t InvertedIndex::size() const noexcept {
+    return postings_.size();
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "term_dictionary.h"
+
+#include <cstddef>
+#include <vector>
+
+// Список вхождений слова: id документов, отсортированные по возрастанию,
+// и частоты слова в этих документах. Данные хранятся в двух непрерывных
+// массивах, чтобы обход списка не требовал переходов по указателям.
+// Массивы могут принадлежать списку или находиться вне его, например
+// в отображенном в память снимке. Внешние массивы копируются в список
+// при первом изменении
+class PostingList {
+public:
+    PostingList() = default;
+    // Список, ссылающийся на внешние массивы. Массивы должны оставаться
+    // действительными, пока список их не скопировал
+    PostingList(const int* document_ids, const double* term_freqs, size_t count, double max_term_freq);
+
+    // Добавление вхождения (при возрастающих id - добавление в конец)
+    void Add(int document_id, double term_freq);
+    // Объединение с упорядоченными по id вхождениями документов,
+    // которых еще нет в списке
+    void Merge(const int* document_ids, const double* term_freqs, size_t count);
+    // Удаление вхождения, возвращает false если документа нет в списке
+    bool Remove(int document_id);
+    // Удаление вхождений документов, упорядоченных по id, за один проход
+    // по списку. Возвращает количество удаленных вхождений
+    size_t Remove(const int* document_ids, size_t count);
+
+    // Позиция первого документа с id не меньше заданного
+    size_t LowerBound(int document_id) const;
+    // Позиция первого документа с id больше заданного
+    size_t UpperBound(int document_id) const;
+
+    const int* DocumentIds() const noexcept;
+    const double* TermFreqs() const noexcept;
+    // Наибольшая частота слова среди документов списка
+    double MaxTermFreq() const noexcept;
+    // Натуральный логарифм количества документов в списке
+    double LogDocumentFreq() const noexcept;
+
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+
+private:
+    std::vector<int> document_ids_;
+    std::vector<double> term_freqs_;
+    const int* external_ids_ = nullptr;
+    const double* external_freqs_ = nullptr;
+    size_t external_size_ = 0;
+    double max_term_freq_ = 0.0;
+    double log_document_freq_ = 0.0;
+
+    // Копирование внешних массивов перед изменением списка
+    void Own();
+    void UpdateLogDocumentFreq();
+};
+
+// Статистика слова по всем документам индекса
+struct TermStatistics {
+    // Количество документов, содержащих слово
+    size_t document_freq = 0;
+    // Обратная документная частота: log(количество документов / document_freq)
+    double inverse_document_freq = 0.0;
+    // Наибольшая частота слова в одном документе
+    double max_term_freq = 0.0;
+};
+
+// Частота слова в документе, элемент прямого индекса
+struct TermFrequency {
+    TermId term;
+    double freq;
+};
+
+// Слова документа, отсортированные по id. Как и у списка вхождений,
+// массив может находиться вне объекта и копируется при первом изменении
+class DocumentTerms {
+public:
+    DocumentTerms() = default;
+    explicit DocumentTerms(std::vector<TermFrequency> terms) noexcept;
+    // Слова во внешнем массиве, который должен оставаться действительным,
+    // пока объект его не скопировал
+    DocumentTerms(const TermFrequency* terms, size_t count) noexcept;
+
+    const TermFrequency* begin() const noexcept;
+    const TermFrequency* end() const noexcept;
+    const TermFrequency* data() const noexcept;
+    const TermFrequency& operator[](size_t index) const noexcept;
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+
+    // Собственный массив слов для изменения
+    std::vector<TermFrequency>& Mutable();
+
+private:
+    std::vector<TermFrequency> terms_;
+    const TermFrequency* external_ = nullptr;
+    size_t external_size_ = 0;
+};
+
+// Поиск частоты слова в документе, nullptr если слова в документе нет
+const TermFrequency* FindTerm(const DocumentTerms& document_terms, TermId term);
+
+// Инвертированный индекс: списки вхождений, адресуемые id слова. Список,
+// из которого удалены все документы, остается пустым до перенумерации слов
+class InvertedIndex {
+public:
+    // Список вхождений слова, создается при первом обращении
+    PostingList& operator[](TermId term);
+
+    // Поиск списка вхождений, nullptr если слово не встречается
+    const PostingList* Find(TermId term) const;
+    // Создание пустых списков для слов с id меньше term_count
+    void Resize(size_t term_count);
+    // Перенумерация слов: список слова term переходит к слову new_ids[term].
+    // Списки слов с new_ids[term] == TermDictionary::NO_TERM удаляются
+    void Renumber(const std::vector<TermId>& new_ids, size_t term_count);
+
+    // Общее количество документов, от которого зависит обратная частота слов
+    void SetDocumentCount(size_t document_count);
+    // IDF вычисляется вычитанием логарифмов, которые обновляются при изменении
+    // количества документов и списков вхождений, поэтому поиск не вызывает log
+    double InverseDocumentFreq(const PostingList& postings) const noexcept;
+    TermStatistics GetStatistics(TermId term) const;
+
+    size_t size() const noexcept;
+
+private:
+    std::vector<PostingList> postings_;
+    double log_document_count_ = 0.0;
+};
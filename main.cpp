@@ -1,10 +1,24 @@
 #include "process_queries.h"
 #include "search_server.h"
 
+#include "Tests/add_documents_par.h"
+#include "Tests/conc_map.h"
+#include "Tests/dedup.h"
+#include "Tests/doc_texts.h"
 #include "Tests/finde_top_docs_par.h"
+#include "Tests/match_batch.h"
 #include "Tests/match_doc_par.h"
+#include "Tests/op_metrics.h"
+#include "Tests/prepared.h"
 #include "Tests/proc_queries.h"
+#include "Tests/query_exec.h"
+#include "Tests/query_trace.h"
+#include "Tests/remove_batch.h"
 #include "Tests/removed_doc_par.h"
+#include "Tests/req_queue.h"
+#include "Tests/result_cache.h"
+#include "Tests/segments.h"
+#include "Tests/snapshot.h"
 
 #include <execution>
 #include <iostream>
@@ -20,6 +34,20 @@ int main() {
     TestsRemovedDocPar();
     TestsMatchDocPar();
     TestFTDPar();
+    TestsAddDocumentsPar();
+    TestsSnapshot();
+    TestsSegmentedIndex();
+    TestsDocumentTexts();
+    TestsConcurrentMap();
+    TestsQueryExecutor();
+    TestsQueryCache();
+    TestsRequestQueue();
+    TestsRemoveDuplicates();
+    TestsQueryStats();
+    TestsMetrics();
+    TestsPreparedQuery();
+    TestsMatchDocuments();
+    TestsRemoveDocuments();
 
     return 0;
 }
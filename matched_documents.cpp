@@ -0,0 +1,32 @@
+#include "matched_documents.h"
+
+using namespace std;
+
+size_t MatchedDocuments::GetDocumentCount() const noexcept {
+    return document_ids_.size();
+}
+
+int MatchedDocuments::GetDocumentId(size_t index) const {
+    return document_ids_.at(index);
+}
+
+DocumentStatus MatchedDocuments::GetStatus(size_t index) const {
+    return statuses_.at(index);
+}
+
+IteratorRange<MatchedDocuments::Iterator> MatchedDocuments::GetWords(size_t index) const {
+    return IteratorRange(words_.begin() + offsets_.at(index),
+                         words_.begin() + offsets_.at(index + 1));
+}
+
+MatchedDocuments::Iterator MatchedDocuments::begin() const noexcept {
+    return words_.begin();
+}
+
+MatchedDocuments::Iterator MatchedDocuments::end() const noexcept {
+    return words_.end();
+}
+
+size_t MatchedDocuments::size() const noexcept {
+    return words_.size();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "document.h"
+#include "paginator.h"
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+class SearchServer;
+
+// Результат SearchServer::MatchDocuments: слова запроса, найденные в каждом
+// документе набора, в одном непрерывном буфере. Слова документа i занимают
+// участок [offsets[i], offsets[i + 1]) и упорядочены лексикографически
+class MatchedDocuments {
+public:
+    using Iterator = std::vector<std::string_view>::const_iterator;
+
+    size_t GetDocumentCount() const noexcept;
+    int GetDocumentId(size_t index) const;
+    DocumentStatus GetStatus(size_t index) const;
+    IteratorRange<Iterator> GetWords(size_t index) const;
+
+    // Все найденные слова подряд
+    Iterator begin() const noexcept;
+    Iterator end() const noexcept;
+    size_t size() const noexcept;
+
+private:
+    friend class SearchServer;
+
+    std::vector<int> document_ids_;
+    std::vector<DocumentStatus> statuses_;
+    std::vector<std::string_view> words_;
+    std::vector<size_t> offsets_{0};
+};
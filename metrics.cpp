@@ -0,0 +1,167 @@
+#include "metrics.h"
+
+#include "Lib/latency_histogram.h"
+
+#include <array>
+#include <atomic>
+
+using namespace std;
+
+namespace {
+
+struct OperationData {
+    LatencyHistogram latency;
+    ShardedCounter items;
+    // Ошибки редки, общий счетчик не мешает записи
+    atomic<uint64_t> errors{0};
+};
+
+array<OperationData, OPERATION_COUNT>& GetOperationData() {
+    static array<OperationData, OPERATION_COUNT> data;
+    return data;
+}
+
+atomic<chrono::steady_clock::rep>& GetStartTime() {
+    static atomic<chrono::steady_clock::rep> start_time{chrono::steady_clock::now().time_since_epoch().count()};
+    return start_time;
+}
+
+// Первое обращение к данным до начала работы программы
+const bool METRICS_INITIALIZED = (GetOperationData(), GetStartTime(), true);
+
+} // namespace
+
+string_view GetOperationName(Operation operation) {
+    switch (operation) {
+    case Operation::ADD_DOCUMENT:
+        return "add_document"sv;
+    case Operation::ADD_DOCUMENTS:
+        return "add_documents"sv;
+    case Operation::FIND_TOP_DOCUMENTS:
+        return "find_top_documents"sv;
+    case Operation::MATCH_DOCUMENT:
+        return "match_document"sv;
+    case Operation::MATCH_DOCUMENTS:
+        return "match_documents"sv;
+    case Operation::REMOVE_DOCUMENT:
+        return "remove_document"sv;
+    case Operation::REMOVE_DOCUMENTS:
+        return "remove_documents"sv;
+    case Operation::PROCESS_QUERIES:
+        return "process_queries"sv;
+    case Operation::PROCESS_QUERIES_JOINED:
+        return "process_queries_joined"sv;
+    case Operation::PROCESS_QUERIES_STREAMED:
+        return "process_queries_streamed"sv;
+    case Operation::REQUEST_QUEUE_FIND:
+        return "request_queue_find"sv;
+    case Operation::COUNT:
+        break;
+    }
+    return "unknown"sv;
+}
+
+void RecordOperation(Operation operation, chrono::nanoseconds duration, uint64_t items, bool failed) noexcept {
+    OperationData& data = GetOperationData()[static_cast<size_t>(operation)];
+    data.latency.Record(static_cast<uint64_t>(max<chrono::nanoseconds::rep>(duration.count(), 0)));
+    data.items.Add(items);
+    if (failed) {
+        data.errors.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+MetricsSnapshot GetMetricsSnapshot() {
+    MetricsSnapshot snapshot;
+    const chrono::steady_clock::duration uptime = chrono::steady_clock::now().time_since_epoch()
+        - chrono::steady_clock::duration(GetStartTime().load(memory_order_relaxed));
+    snapshot.uptime_seconds = chrono::duration<double>(uptime).count();
+
+    snapshot.operations.reserve(OPERATION_COUNT);
+    for (size_t i = 0; i < OPERATION_COUNT; ++i) {
+        const OperationData& data = GetOperationData()[i];
+        const HistogramSnapshot histogram = data.latency.Snapshot();
+        OperationMetrics metrics;
+        metrics.operation = static_cast<Operation>(i);
+        metrics.count = histogram.count;
+        metrics.errors = data.errors.load(memory_order_relaxed);
+        metrics.items = data.items.Get();
+        metrics.total_ns = histogram.sum;
+        metrics.mean_ns = histogram.Mean();
+        metrics.p50_ns = histogram.Percentile(0.5);
+        metrics.p90_ns = histogram.Percentile(0.9);
+        metrics.p99_ns = histogram.Percentile(0.99);
+        metrics.p999_ns = histogram.Percentile(0.999);
+        metrics.max_ns = histogram.max;
+        if (snapshot.uptime_seconds > 0.0) {
+            metrics.rate_per_s = histogram.count / snapshot.uptime_seconds;
+        }
+        snapshot.operations.push_back(metrics);
+    }
+    return snapshot;
+}
+
+void ResetMetrics() {
+    for (OperationData& data : GetOperationData()) {
+        data.latency.Reset();
+        data.items.Reset();
+        data.errors.store(0, memory_order_relaxed);
+    }
+    GetStartTime().store(chrono::steady_clock::now().time_since_epoch().count(), memory_order_relaxed);
+}
+
+void WriteMetricsPrometheus(ostream& out, const MetricsSnapshot& snapshot) {
+    const auto seconds = [](uint64_t nanoseconds) {
+        return nanoseconds / 1e9;
+    };
+    const auto label = [](const OperationMetrics& metrics) {
+        return "{operation=\""s + string(GetOperationName(metrics.operation)) + "\""s;
+    };
+
+    out << "# HELP search_server_operation_latency_seconds Operation latency.\n"
+           "# TYPE search_server_operation_latency_seconds summary\n";
+    for (const OperationMetrics& metrics : snapshot.operations) {
+        const pair<const char*, uint64_t> quantiles[] = {
+            {"0.5", metrics.p50_ns}, {"0.9", metrics.p90_ns}, {"0.99", metrics.p99_ns}, {"0.999", metrics.p999_ns}
+        };
+        for (const auto& [quantile, value] : quantiles) {
+            out << "search_server_operation_latency_seconds"s << label(metrics) << ",quantile=\""s << quantile
+                << "\"} "s << seconds(value) << '\n';
+        }
+        out << "search_server_operation_latency_seconds_sum"s << label(metrics) << "} "s
+            << seconds(metrics.total_ns) << '\n';
+        out << "search_server_operation_latency_seconds_count"s << label(metrics) << "} "s
+            << metrics.count << '\n';
+    }
+
+    out << "# HELP search_server_operation_errors_total Operations finished with an exception.\n"
+           "# TYPE search_server_operation_errors_total counter\n";
+    for (const OperationMetrics& metrics : snapshot.operations) {
+        out << "search_server_operation_errors_total"s << label(metrics) << "} "s << metrics.errors << '\n';
+    }
+    out << "# HELP search_server_operation_items_total Documents or queries processed by operations.\n"
+           "# TYPE search_server_operation_items_total counter\n";
+    for (const OperationMetrics& metrics : snapshot.operations) {
+        out << "search_server_operation_items_total"s << label(metrics) << "} "s << metrics.items << '\n';
+    }
+}
+
+void WriteMetricsJson(ostream& out, const MetricsSnapshot& snapshot) {
+    out << "{\"uptime_seconds\": "s << snapshot.uptime_seconds << ", \"operations\": ["s;
+    bool first = true;
+    for (const OperationMetrics& metrics : snapshot.operations) {
+        out << (first ? "\n"s : ",\n"s);
+        first = false;
+        out << "  {\"operation\": \""s << GetOperationName(metrics.operation) << "\""s
+            << ", \"count\": "s << metrics.count
+            << ", \"errors\": "s << metrics.errors
+            << ", \"items\": "s << metrics.items
+            << ", \"mean_ns\": "s << metrics.mean_ns
+            << ", \"p50_ns\": "s << metrics.p50_ns
+            << ", \"p90_ns\": "s << metrics.p90_ns
+            << ", \"p99_ns\": "s << metrics.p99_ns
+            << ", \"p999_ns\": "s << metrics.p999_ns
+            << ", \"max_ns\": "s << metrics.max_ns
+            << ", \"rate_per_s\": "s << metrics.rate_per_s << "}"s;
+    }
+    out << "\n]}\n"s;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// Операции, длительность которых записывается в гистограммы
+enum class Operation {
+    ADD_DOCUMENT,
+    ADD_DOCUMENTS,
+    FIND_TOP_DOCUMENTS,
+    MATCH_DOCUMENT,
+    MATCH_DOCUMENTS,
+    REMOVE_DOCUMENT,
+    REMOVE_DOCUMENTS,
+    PROCESS_QUERIES,
+    PROCESS_QUERIES_JOINED,
+    PROCESS_QUERIES_STREAMED,
+    REQUEST_QUEUE_FIND,
+    COUNT
+};
+
+inline constexpr size_t OPERATION_COUNT = static_cast<size_t>(Operation::COUNT);
+
+std::string_view GetOperationName(Operation operation);
+
+// Запись одного вызова операции: длительность, количество обработанных
+// элементов (документов, запросов) и признак завершения исключением.
+// Без блокировок, несколько десятков наносекунд
+void RecordOperation(Operation operation, std::chrono::nanoseconds duration, uint64_t items, bool failed) noexcept;
+
+// Замер вызова от создания объекта до его уничтожения. Вызов, прерванный
+// исключением, учитывается как ошибка
+class OperationTimer {
+public:
+    explicit OperationTimer(Operation operation, uint64_t items = 1) noexcept
+        : operation_(operation)
+        , items_(items)
+        , exception_count_(std::uncaught_exceptions()) {
+    }
+    OperationTimer(const OperationTimer&) = delete;
+    OperationTimer& operator=(const OperationTimer&) = delete;
+    // Количество элементов, если оно известно только после начала замера
+    void SetItems(uint64_t items) noexcept {
+        items_ = items;
+    }
+    ~OperationTimer() {
+        RecordOperation(operation_, std::chrono::steady_clock::now() - start_, items_,
+                        std::uncaught_exceptions() > exception_count_);
+    }
+
+private:
+    Operation operation_;
+    uint64_t items_;
+    int exception_count_;
+    std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+};
+
+// Показатели операции с начала работы программы или последнего ResetMetrics
+struct OperationMetrics {
+    Operation operation;
+    uint64_t count = 0;
+    uint64_t errors = 0;
+    uint64_t items = 0;
+    uint64_t total_ns = 0;
+    double mean_ns = 0.0;
+    uint64_t p50_ns = 0;
+    uint64_t p90_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+    uint64_t max_ns = 0;
+    // Вызовов в секунду за время сбора
+    double rate_per_s = 0.0;
+};
+
+struct MetricsSnapshot {
+    double uptime_seconds = 0.0;
+    std::vector<OperationMetrics> operations;
+};
+
+MetricsSnapshot GetMetricsSnapshot();
+// Обнуление показателей. Вызовы, выполняемые одновременно со сбросом,
+// могут учитываться частично
+void ResetMetrics();
+
+// Текстовый формат Prometheus: сводки задержек в секундах и счетчики
+void WriteMetricsPrometheus(std::ostream& out, const MetricsSnapshot& snapshot);
+void WriteMetricsJson(std::ostream& out, const MetricsSnapshot& snapshot);
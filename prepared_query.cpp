@@ -0,0 +1,15 @@
+#include "prepared_query.h"
+
+using namespace std;
+
+const string& PreparedQuery::GetText() const noexcept {
+    return text_;
+}
+
+const PreparedQuery::Terms& PreparedQuery::GetPlusTerms() const noexcept {
+    return plus_terms_;
+}
+
+const PreparedQuery::Terms& PreparedQuery::GetMinusTerms() const noexcept {
+    return minus_terms_;
+}
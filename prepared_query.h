@@ -0,0 +1,51 @@
+#pragma once
+
+#include "term_dictionary.h"
+#include "Lib/small_vector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class SearchServer;
+
+// Запрос, разобранный сервером заранее (SearchServer::PrepareQuery). Хранит
+// отсортированные id плюс- и минус-слов без повторов во встроенных буферах,
+// поэтому повторное выполнение не разбирает текст и не выделяет память
+// под слова запроса. Запрос выполняется по словарю, для которого он подготовлен.
+// Слова, отсутствовавшие в словаре при подготовке, хранятся отдельно: после
+// роста словаря сервер ищет в нем только их, не разбирая текст
+// (SearchServer::RefreshPreparedQuery делает это один раз). Другой сервер
+// (в том числе копия или сервер, замененный присваиванием) разбирает текст заново
+class PreparedQuery {
+public:
+    // Количество слов каждого вида, хранимых без выделения памяти
+    static constexpr size_t INLINE_TERM_COUNT = 8;
+    using Terms = SmallVector<TermId, INLINE_TERM_COUNT>;
+
+    // Пустой запрос, не находящий документов
+    PreparedQuery() = default;
+
+    const std::string& GetText() const noexcept;
+    const Terms& GetPlusTerms() const noexcept;
+    const Terms& GetMinusTerms() const noexcept;
+
+private:
+    friend class SearchServer;
+
+    // Слово запроса, отсутствовавшее в словаре
+    struct UnknownWord {
+        std::string word;
+        bool is_minus;
+    };
+
+    Terms plus_terms_;
+    Terms minus_terms_;
+    std::vector<UnknownWord> unknown_words_;
+    std::string text_;
+    // Идентификатор словаря сервера, подготовившего запрос, и размер
+    // словаря в момент подготовки. Идентификатор 0 сервером не выдается
+    uint64_t dictionary_token_ = 0;
+    size_t term_count_ = 0;
+};
@@ -1,34 +1,52 @@
 #include "process_queries.h"
-
-#include <algorithm>
-#include <execution>
-#include <numeric>
-#include <utility>
+#include "metrics.h"
 
 using namespace std;
 
+namespace {
+
+// Общий исполнитель создается при первом вызове и работает до завершения программы
+QueryExecutor& GetDefaultExecutor() {
+    static QueryExecutor executor;
+    return executor;
+}
+
+} // namespace
+
 vector<vector<Document>> ProcessQueries(const SearchServer& search_server,
                                         const vector<string>& queries) {
-    
-    vector<vector<Document>> res_search(queries.size());
-    transform(execution::par,
-              queries.begin(),
-              queries.end(),
-              res_search.begin(),
-              [&search_server](const string& query) {
-                  return search_server.FindTopDocuments(query);
-              });
-
-    return res_search;
+    OperationTimer timer(Operation::PROCESS_QUERIES, queries.size());
+    return GetDefaultExecutor().ProcessQueries(search_server, queries);
 }
 
-vector<Document> ProcessQueriesJoined(const SearchServer& search_server,
-                                      const vector<string>& queries) {
+JoinedResults ProcessQueriesJoined(const SearchServer& search_server,
+                                   const vector<string>& queries) {
+    OperationTimer timer(Operation::PROCESS_QUERIES_JOINED, queries.size());
+    return GetDefaultExecutor().ProcessQueriesJoined(search_server, queries);
+}
 
-    vector<Document> documents;
-    for (const auto& local_documents : ProcessQueries(search_server, queries)) {
-        documents.insert(documents.end(), local_documents.begin(), local_documents.end());
-    }
+void ProcessQueriesStreamed(const SearchServer& search_server,
+                            const vector<string>& queries,
+                            const QueryResultCallback& callback) {
+    OperationTimer timer(Operation::PROCESS_QUERIES_STREAMED, queries.size());
+    GetDefaultExecutor().ProcessQueriesStreamed(search_server, queries, callback);
+}
+
+vector<vector<Document>> ProcessPreparedQueries(const SearchServer& search_server,
+                                                const vector<PreparedQuery>& queries) {
+    OperationTimer timer(Operation::PROCESS_QUERIES, queries.size());
+    return GetDefaultExecutor().ProcessQueries(search_server, queries);
+}
+
+JoinedResults ProcessPreparedQueriesJoined(const SearchServer& search_server,
+                                           const vector<PreparedQuery>& queries) {
+    OperationTimer timer(Operation::PROCESS_QUERIES_JOINED, queries.size());
+    return GetDefaultExecutor().ProcessQueriesJoined(search_server, queries);
+}
 
-    return documents;
+void ProcessPreparedQueriesStreamed(const SearchServer& search_server,
+                                    const vector<PreparedQuery>& queries,
+                                    const QueryResultCallback& callback) {
+    OperationTimer timer(Operation::PROCESS_QUERIES_STREAMED, queries.size());
+    GetDefaultExecutor().ProcessQueriesStreamed(search_server, queries, callback);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "document.h"
+#include "query_executor.h"
 #include "search_server.h"
 
 #include <string>
@@ -10,6 +11,26 @@ std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
-std::vector<Document> ProcessQueriesJoined(
+// Результаты всех запросов подряд в одном буфере
+JoinedResults ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
+
+// Передача результатов получателю по мере готовности, в порядке запросов
+void ProcessQueriesStreamed(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    const QueryResultCallback& callback);
+
+// Варианты для запросов, подготовленных search_server.PrepareQuery. Имена
+// отличаются, чтобы функции для текстовых запросов можно было передавать по имени
+std::vector<std::vector<Document>> ProcessPreparedQueries(
+    const SearchServer& search_server,
+    const std::vector<PreparedQuery>& queries);
+JoinedResults ProcessPreparedQueriesJoined(
+    const SearchServer& search_server,
+    const std::vector<PreparedQuery>& queries);
+void ProcessPreparedQueriesStreamed(
+    const SearchServer& search_server,
+    const std::vector<PreparedQuery>& queries,
+    const QueryResultCallback& callback);
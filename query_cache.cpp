@@ -0,0 +1,106 @@
+#include "query_cache.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+bool QueryCacheKey::operator==(const QueryCacheKey& other) const {
+    return status == other.status && top_k == other.top_k
+           && plus_terms == other.plus_terms && minus_terms == other.minus_terms;
+}
+
+size_t QueryCacheKeyHash::operator()(const QueryCacheKey& key) const noexcept {
+    uint64_t hash = static_cast<uint64_t>(key.status) * 0x9E3779B97F4A7C15ULL + key.top_k;
+    const auto mix = [&hash](uint64_t value) {
+        hash = (hash ^ value) * 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 31;
+    };
+    for (const TermId term : key.plus_terms) {
+        mix(term);
+    }
+    // Разделитель, чтобы слово не давало одинаковый хеш в плюс- и минус-словах
+    mix(~uint64_t{0});
+    for (const TermId term : key.minus_terms) {
+        mix(term);
+    }
+    return static_cast<size_t>(hash);
+}
+
+double QueryCacheStats::HitRate() const noexcept {
+    const uint64_t requests = hits + misses;
+    return requests == 0 ? 0.0 : static_cast<double>(hits) / requests;
+}
+
+QueryCache::QueryCache(size_t capacity)
+    : shard_capacity_(max<size_t>(1, (capacity + SHARD_COUNT - 1) / SHARD_COUNT))
+    , shards_(SHARD_COUNT) {
+}
+
+optional<vector<Document>> QueryCache::Find(const QueryCacheKey& key, uint64_t generation) {
+    Shard& shard = GetShard(key);
+    lock_guard lock(shard.mutex);
+    const auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        shard.misses.fetch_add(1, memory_order_relaxed);
+        return nullopt;
+    }
+    const auto entry = it->second;
+    if (entry->generation != generation) {
+        shard.entries.erase(entry);
+        shard.index.erase(it);
+        shard.misses.fetch_add(1, memory_order_relaxed);
+        shard.stale.fetch_add(1, memory_order_relaxed);
+        return nullopt;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+    shard.hits.fetch_add(1, memory_order_relaxed);
+    return entry->documents;
+}
+
+void QueryCache::Insert(QueryCacheKey key, uint64_t generation, const vector<Document>& documents) {
+    Shard& shard = GetShard(key);
+    lock_guard lock(shard.mutex);
+    const auto [it, inserted] = shard.index.try_emplace(move(key));
+    if (!inserted) {
+        // Запрос уже добавлен другим потоком, запись обновляется
+        it->second->generation = generation;
+        it->second->documents = documents;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+    shard.entries.push_front(Entry{&it->first, generation, documents});
+    it->second = shard.entries.begin();
+
+    if (shard.entries.size() > shard_capacity_) {
+        shard.index.erase(shard.index.find(*shard.entries.back().key));
+        shard.entries.pop_back();
+        shard.evictions.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+void QueryCache::Clear() {
+    for (Shard& shard : shards_) {
+        lock_guard lock(shard.mutex);
+        shard.entries.clear();
+        shard.index.clear();
+    }
+}
+
+QueryCacheStats QueryCache::GetStats() const {
+    QueryCacheStats stats;
+    for (const Shard& shard : shards_) {
+        stats.hits += shard.hits.load(memory_order_relaxed);
+        stats.misses += shard.misses.load(memory_order_relaxed);
+        stats.stale += shard.stale.load(memory_order_relaxed);
+        stats.evictions += shard.evictions.load(memory_order_relaxed);
+        lock_guard lock(shard.mutex);
+        stats.size += shard.entries.size();
+    }
+    return stats;
+}
+
+QueryCache::Shard& QueryCache::GetShard(const QueryCacheKey& key) {
+    // Старшие биты хеша, младшие использует индекс сегмента
+    return shards_[(QueryCacheKeyHash{}(key) >> 60) % SHARD_COUNT];
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "document.h"
+#include "term_dictionary.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Нормализованный запрос: отсортированные id плюс- и минус-слов без повторов,
+// поэтому порядок и повторы слов в тексте запроса не важны
+struct QueryCacheKey {
+    std::vector<TermId> plus_terms;
+    std::vector<TermId> minus_terms;
+    DocumentStatus status;
+    size_t top_k;
+
+    bool operator==(const QueryCacheKey& other) const;
+};
+
+struct QueryCacheKeyHash {
+    size_t operator()(const QueryCacheKey& key) const noexcept;
+};
+
+// Статистика обращений к кэшу
+struct QueryCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Промахи из-за записи, сделанной до изменения индекса
+    uint64_t stale = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;
+
+    double HitRate() const noexcept;
+};
+
+// Кэш результатов поиска, разбитый на сегменты с собственной блокировкой
+// и вытеснением давно не использованных записей. Запись действительна только
+// для того поколения индекса, в котором она создана: после изменения индекса
+// прежние записи считаются промахами и удаляются при обращении
+class QueryCache {
+public:
+    explicit QueryCache(size_t capacity);
+
+    std::optional<std::vector<Document>> Find(const QueryCacheKey& key, uint64_t generation);
+    void Insert(QueryCacheKey key, uint64_t generation, const std::vector<Document>& documents);
+    void Clear();
+
+    QueryCacheStats GetStats() const;
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct Entry {
+        // Ключ хранится в узле индекса, узлы не перемещаются
+        const QueryCacheKey* key;
+        uint64_t generation;
+        std::vector<Document> documents;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        // Записи от недавно использованных к давно не использованным
+        std::list<Entry> entries;
+        std::unordered_map<QueryCacheKey, std::list<Entry>::iterator, QueryCacheKeyHash> index;
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> stale{0};
+        std::atomic<uint64_t> evictions{0};
+    };
+
+    size_t shard_capacity_;
+    std::vector<Shard> shards_;
+
+    Shard& GetShard(const QueryCacheKey& key);
+};
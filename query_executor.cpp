@@ -0,0 +1,224 @@
+#include "query_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+namespace {
+
+// Запрос, по которому оцениваются стоимость и выполняется поиск. Текстовый
+// запрос разбирается один раз в prepared, подготовленный используется как есть
+const PreparedQuery& ResolveQuery(const SearchServer& search_server, const string& raw_query,
+                                  PreparedQuery& prepared) {
+    prepared = search_server.PrepareQuery(raw_query);
+    return prepared;
+}
+
+const PreparedQuery& ResolveQuery([[maybe_unused]] const SearchServer& search_server,
+                                  const PreparedQuery& query, [[maybe_unused]] PreparedQuery& prepared) {
+    return query;
+}
+
+} // namespace
+
+JoinedResults::Iterator JoinedResults::begin() const noexcept {
+    return documents_.begin();
+}
+
+JoinedResults::Iterator JoinedResults::end() const noexcept {
+    return documents_.end();
+}
+
+size_t JoinedResults::size() const noexcept {
+    return documents_.size();
+}
+
+size_t JoinedResults::GetQueryCount() const noexcept {
+    return offsets_.size() - 1;
+}
+
+IteratorRange<JoinedResults::Iterator> JoinedResults::GetQueryResults(size_t query_index) const {
+    return IteratorRange(documents_.begin() + offsets_.at(query_index),
+                         documents_.begin() + offsets_.at(query_index + 1));
+}
+
+double QueryBatchStats::QueriesPerSecond() const noexcept {
+    return seconds > 0.0 ? query_count / seconds : 0.0;
+}
+
+QueryExecutor::QueryExecutor(QueryExecutorOptions options)
+    : options_(options)
+    , pool_(options.worker_count) {
+    options_.batch_size = max<size_t>(options_.batch_size, 1);
+}
+
+// Выполнение запросов пачками в пуле, consume(i, documents) получает
+// результат запроса i в потоке, выполнившем запрос
+template <typename QueryType, typename Consumer>
+void QueryExecutor::Run(const SearchServer& search_server, const vector<QueryType>& queries,
+                        QueryBatchStats& stats, Consumer consume) {
+    const auto start_time = chrono::steady_clock::now();
+    atomic<size_t> split_query_count{0};
+
+    const size_t batch_count = (queries.size() + options_.batch_size - 1) / options_.batch_size;
+    pool_.ParallelFor(batch_count, [&](size_t batch) {
+        const size_t first = batch * options_.batch_size;
+        const size_t last = min(first + options_.batch_size, queries.size());
+        PreparedQuery prepared;
+        for (size_t i = first; i < last; ++i) {
+            const PreparedQuery& query = ResolveQuery(search_server, queries[i], prepared);
+            if (search_server.EstimateQueryCost(query) < options_.split_cost) {
+                consume(i, search_server.FindTopDocuments(query));
+            } else {
+                // Части запроса попадают в очередь текущего исполнителя,
+                // свободные исполнители забирают их себе
+                consume(i, search_server.FindTopDocuments(pool_.GetPolicy(), query));
+                split_query_count.fetch_add(1, memory_order_relaxed);
+            }
+        }
+    });
+
+    stats.query_count = queries.size();
+    stats.split_query_count = split_query_count.load(memory_order_relaxed);
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+}
+
+vector<vector<Document>> QueryExecutor::ProcessQueries(const SearchServer& search_server,
+                                                       const vector<string>& queries) {
+    QueryBatchStats stats;
+    return ProcessQueries(search_server, queries, stats);
+}
+
+vector<vector<Document>> QueryExecutor::ProcessQueries(const SearchServer& search_server,
+                                                       const vector<string>& queries,
+                                                       QueryBatchStats& stats) {
+    return ProcessQueriesImpl(search_server, queries, stats);
+}
+
+vector<vector<Document>> QueryExecutor::ProcessQueries(const SearchServer& search_server,
+                                                       const vector<PreparedQuery>& queries) {
+    QueryBatchStats stats;
+    return ProcessQueries(search_server, queries, stats);
+}
+
+vector<vector<Document>> QueryExecutor::ProcessQueries(const SearchServer& search_server,
+                                                       const vector<PreparedQuery>& queries,
+                                                       QueryBatchStats& stats) {
+    return ProcessQueriesImpl(search_server, queries, stats);
+}
+
+template <typename QueryType>
+vector<vector<Document>> QueryExecutor::ProcessQueriesImpl(const SearchServer& search_server,
+                                                           const vector<QueryType>& queries,
+                                                           QueryBatchStats& stats) {
+    vector<vector<Document>> results(queries.size());
+    Run(search_server, queries, stats, [&results](size_t query_index, vector<Document>&& documents) {
+        results[query_index] = move(documents);
+    });
+    return results;
+}
+
+JoinedResults QueryExecutor::ProcessQueriesJoined(const SearchServer& search_server,
+                                                  const vector<string>& queries) {
+    return ProcessQueriesJoinedImpl(search_server, queries);
+}
+
+JoinedResults QueryExecutor::ProcessQueriesJoined(const SearchServer& search_server,
+                                                  const vector<PreparedQuery>& queries) {
+    return ProcessQueriesJoinedImpl(search_server, queries);
+}
+
+template <typename QueryType>
+JoinedResults QueryExecutor::ProcessQueriesJoinedImpl(const SearchServer& search_server,
+                                                      const vector<QueryType>& queries) {
+    // Каждому запросу отводится участок на top_k документов,
+    // после выполнения участки сдвигаются вплотную друг к другу
+    const size_t top_k = SearchServer::MAX_RESULT_DOCUMENT_COUNT;
+    JoinedResults results;
+    results.documents_.resize(queries.size() * top_k);
+    vector<size_t> counts(queries.size());
+
+    QueryBatchStats stats;
+    Run(search_server, queries, stats, [&results, &counts, top_k](size_t query_index, vector<Document>&& documents) {
+        copy(documents.begin(), documents.end(), results.documents_.begin() + query_index * top_k);
+        counts[query_index] = documents.size();
+    });
+
+    results.offsets_.resize(queries.size() + 1);
+    size_t offset = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto first = results.documents_.begin() + i * top_k;
+        move(first, first + counts[i], results.documents_.begin() + offset);
+        offset += counts[i];
+        results.offsets_[i + 1] = offset;
+    }
+    results.documents_.resize(offset);
+    return results;
+}
+
+void QueryExecutor::ProcessQueriesStreamed(const SearchServer& search_server,
+                                           const vector<string>& queries,
+                                           const QueryResultCallback& callback) {
+    ProcessQueriesStreamedImpl(search_server, queries, callback);
+}
+
+void QueryExecutor::ProcessQueriesStreamed(const SearchServer& search_server,
+                                           const vector<PreparedQuery>& queries,
+                                           const QueryResultCallback& callback) {
+    ProcessQueriesStreamedImpl(search_server, queries, callback);
+}
+
+template <typename QueryType>
+void QueryExecutor::ProcessQueriesStreamedImpl(const SearchServer& search_server,
+                                               const vector<QueryType>& queries,
+                                               const QueryResultCallback& callback) {
+    vector<vector<Document>> pending(queries.size());
+    const unique_ptr<atomic<bool>[]> ready(new atomic<bool>[queries.size()]());
+    atomic<size_t> next{0};
+    mutex delivery_mutex;
+
+    // Передача готового начала последовательности запросов. Если передачу уже
+    // ведет другой поток, он заберет и новый результат: освободив блокировку,
+    // поток передачи проверяет, не стал ли готов следующий запрос, и повторяет
+    // передачу. Барьеры упорядочивают отметку готовности и попытку захвата
+    // с освобождением и повторной проверкой, поэтому готовый результат не
+    // ждет завершения следующего запроса
+    const auto deliver = [&] {
+        while (true) {
+            {
+                unique_lock lock(delivery_mutex, try_to_lock);
+                if (!lock.owns_lock()) {
+                    return;
+                }
+                size_t query_index = next.load(memory_order_relaxed);
+                while (query_index < queries.size() && ready[query_index].load(memory_order_acquire)) {
+                    callback(query_index, pending[query_index]);
+                    vector<Document>().swap(pending[query_index]);
+                    next.store(++query_index, memory_order_relaxed);
+                }
+            }
+            atomic_thread_fence(memory_order_seq_cst);
+            const size_t query_index = next.load(memory_order_relaxed);
+            if (query_index >= queries.size() || !ready[query_index].load(memory_order_acquire)) {
+                return;
+            }
+        }
+    };
+
+    QueryBatchStats stats;
+    Run(search_server, queries, stats, [&](size_t query_index, vector<Document>&& documents) {
+        pending[query_index] = move(documents);
+        ready[query_index].store(true, memory_order_release);
+        atomic_thread_fence(memory_order_seq_cst);
+        deliver();
+    });
+    deliver();
+}
+
+size_t QueryExecutor::GetWorkerCount() const noexcept {
+    return pool_.WorkerCount();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "document.h"
+#include "paginator.h"
+#include "search_server.h"
+#include "Lib/work_stealing_pool.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Параметры исполнителя запросов
+struct QueryExecutorOptions {
+    // Число потоков вместе с вызывающим, 0 - по числу ядер
+    size_t worker_count = 0;
+    // Оценка стоимости (длина списков вхождений), начиная с которой
+    // запрос делится на части между исполнителями
+    size_t split_cost = 65'536;
+    // Количество запросов одной задачи пула
+    size_t batch_size = 8;
+};
+
+// Статистика обработки набора запросов
+struct QueryBatchStats {
+    size_t query_count = 0;
+    // Запросы, разделенные на части между исполнителями
+    size_t split_query_count = 0;
+    double seconds = 0.0;
+
+    double QueriesPerSecond() const noexcept;
+};
+
+// Результаты набора запросов в одном непрерывном буфере. Обход диапазона
+// дает документы всех запросов подряд, документы запроса i занимают
+// участок [offsets[i], offsets[i + 1])
+class JoinedResults {
+public:
+    using Iterator = std::vector<Document>::const_iterator;
+
+    Iterator begin() const noexcept;
+    Iterator end() const noexcept;
+    size_t size() const noexcept;
+
+    size_t GetQueryCount() const noexcept;
+    IteratorRange<Iterator> GetQueryResults(size_t query_index) const;
+
+private:
+    friend class QueryExecutor;
+
+    std::vector<Document> documents_;
+    std::vector<size_t> offsets_{0};
+};
+
+// Получатель результатов отдельных запросов
+using QueryResultCallback = std::function<void(size_t query_index, const std::vector<Document>& documents)>;
+
+// Исполнитель наборов запросов на собственном пуле потоков с перехватом задач.
+// Запросы распределяются по задачам пачками; дешевые запросы выполняются
+// целиком внутри задачи, дорогие делятся по диапазонам id документов,
+// части которых забирают свободные исполнители. Все вычисления идут
+// в потоках пула, поэтому число работающих потоков не превышает worker_count
+class QueryExecutor {
+public:
+    explicit QueryExecutor(QueryExecutorOptions options = QueryExecutorOptions{});
+
+    std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+                                                      const std::vector<std::string>& queries);
+    std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+                                                      const std::vector<std::string>& queries,
+                                                      QueryBatchStats& stats);
+    // Запросы, подготовленные search_server.PrepareQuery, выполняются без разбора текста
+    std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+                                                      const std::vector<PreparedQuery>& queries);
+    std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+                                                      const std::vector<PreparedQuery>& queries,
+                                                      QueryBatchStats& stats);
+
+    // Результаты всех запросов в одном буфере. Исполнители записывают
+    // документы запроса сразу на его место в буфере
+    JoinedResults ProcessQueriesJoined(const SearchServer& search_server,
+                                       const std::vector<std::string>& queries);
+    JoinedResults ProcessQueriesJoined(const SearchServer& search_server,
+                                       const std::vector<PreparedQuery>& queries);
+    // Передача результатов получателю по мере готовности, в порядке запросов.
+    // Получатель вызывается последовательно, но из разных потоков пула;
+    // результат запроса освобождается сразу после передачи
+    void ProcessQueriesStreamed(const SearchServer& search_server,
+                                const std::vector<std::string>& queries,
+                                const QueryResultCallback& callback);
+    void ProcessQueriesStreamed(const SearchServer& search_server,
+                                const std::vector<PreparedQuery>& queries,
+                                const QueryResultCallback& callback);
+
+    size_t GetWorkerCount() const noexcept;
+
+private:
+    QueryExecutorOptions options_;
+    WorkStealingPool pool_;
+
+    // Реализации для текстовых и подготовленных запросов
+    template <typename QueryType>
+    std::vector<std::vector<Document>> ProcessQueriesImpl(const SearchServer& search_server,
+                                                          const std::vector<QueryType>& queries,
+                                                          QueryBatchStats& stats);
+    template <typename QueryType>
+    JoinedResults ProcessQueriesJoinedImpl(const SearchServer& search_server,
+                                           const std::vector<QueryType>& queries);
+    template <typename QueryType>
+    void ProcessQueriesStreamedImpl(const SearchServer& search_server,
+                                    const std::vector<QueryType>& queries,
+                                    const QueryResultCallback& callback);
+
+    template <typename QueryType, typename Consumer>
+    void Run(const SearchServer& search_server, const std::vector<QueryType>& queries,
+             QueryBatchStats& stats, Consumer consume);
+};
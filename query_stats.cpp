@@ -0,0 +1,53 @@
+#include "query_stats.h"
+
+using namespace std;
+
+string_view GetQueryStageName(QueryStage stage) {
+    switch (stage) {
+    case QueryStage::PARSE:
+        return "parse"sv;
+    case QueryStage::POSTINGS:
+        return "postings"sv;
+    case QueryStage::EXCLUSION:
+        return "exclusion"sv;
+    case QueryStage::COLLECT:
+        return "collect"sv;
+    case QueryStage::SELECTION:
+        return "selection"sv;
+    case QueryStage::MATCH:
+        return "match"sv;
+    case QueryStage::REMOVE:
+        return "remove"sv;
+    case QueryStage::COUNT:
+        break;
+    }
+    return "unknown"sv;
+}
+
+chrono::nanoseconds QueryStats::GetDuration(QueryStage stage) const {
+    return stage_durations[static_cast<size_t>(stage)];
+}
+
+chrono::nanoseconds QueryStats::GetTotalDuration() const {
+    chrono::nanoseconds total{0};
+    for (const chrono::nanoseconds duration : stage_durations) {
+        total += duration;
+    }
+    return total;
+}
+
+void QueryStats::Merge(const QueryStats& other) {
+    for (size_t stage = 0; stage < QUERY_STAGE_COUNT; ++stage) {
+        stage_durations[stage] += other.stage_durations[stage];
+    }
+    query_count += other.query_count;
+    posting_lists += other.posting_lists;
+    postings_scanned += other.postings_scanned;
+    candidates += other.candidates;
+    excluded += other.excluded;
+    results += other.results;
+}
+
+void QueryStats::Clear() {
+    *this = QueryStats{};
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Сбор статистики выполнения запросов включается при сборке макросом
+// SEARCH_SERVER_QUERY_STATS. Без него QueryStatsTrace::Active() всегда
+// возвращает nullptr, и код замеров удаляется компилятором
+#ifdef SEARCH_SERVER_QUERY_STATS
+inline constexpr bool QUERY_STATS_ENABLED = true;
+#else
+inline constexpr bool QUERY_STATS_ENABLED = false;
+#endif
+
+// Этапы выполнения запроса
+enum class QueryStage {
+    PARSE,      // разбор текста запроса
+    POSTINGS,   // обход списков вхождений плюс-слов и накопление релевантности
+    EXCLUSION,  // исключение документов с минус-словами
+    COLLECT,    // сбор найденных документов и склейка частей
+    SELECTION,  // отбор и сортировка top_k документов
+    MATCH,      // поиск слов запроса в документе
+    REMOVE,     // удаление документа из списков вхождений
+    COUNT
+};
+
+inline constexpr size_t QUERY_STAGE_COUNT = static_cast<size_t>(QueryStage::COUNT);
+
+std::string_view GetQueryStageName(QueryStage stage);
+
+// Статистика запросов. Значения накапливаются по всем запросам,
+// выполненным под QueryStatsTrace. Время этапов, выполняемых частями
+// в нескольких потоках, суммируется по частям
+struct QueryStats {
+    std::array<std::chrono::nanoseconds, QUERY_STAGE_COUNT> stage_durations{};
+    // Вызовы FindTopDocuments, MatchDocument и RemoveDocument
+    size_t query_count = 0;
+    // Просмотренные или измененные списки вхождений и их элементы
+    size_t posting_lists = 0;
+    size_t postings_scanned = 0;
+    // Документы, содержащие плюс-слова, и исключенные из них минус-словами
+    size_t candidates = 0;
+    size_t excluded = 0;
+    // Возвращенные документы или слова
+    size_t results = 0;
+
+    std::chrono::nanoseconds GetDuration(QueryStage stage) const;
+    std::chrono::nanoseconds GetTotalDuration() const;
+    void Merge(const QueryStats& other);
+    void Clear();
+};
+
+// Статистика запросов текущего потока собирается в stats, пока объект
+// существует. Части запроса, выполняемые в других потоках, учитываются
+// в статистике потока, вызвавшего метод сервера
+class QueryStatsTrace {
+public:
+    explicit QueryStatsTrace(QueryStats& stats) noexcept
+        : previous_(active_) {
+        active_ = &stats;
+    }
+    QueryStatsTrace(const QueryStatsTrace&) = delete;
+    QueryStatsTrace& operator=(const QueryStatsTrace&) = delete;
+    ~QueryStatsTrace() {
+        active_ = previous_;
+    }
+
+    static QueryStats* Active() noexcept {
+        if constexpr (QUERY_STATS_ENABLED) {
+            return active_;
+        } else {
+            return nullptr;
+        }
+    }
+
+private:
+    static inline thread_local QueryStats* active_ = nullptr;
+    QueryStats* previous_;
+};
+
+// Прибавление к счетчику статистики, если она собирается
+inline void AddQueryStat(QueryStats* stats, size_t QueryStats::*counter, size_t value) noexcept {
+    if constexpr (QUERY_STATS_ENABLED) {
+        if (stats != nullptr) {
+            stats->*counter += value;
+        }
+    }
+}
+
+// Замер длительности этапа от создания объекта до его уничтожения
+class QueryStageTimer {
+public:
+    QueryStageTimer(QueryStats* stats, QueryStage stage) noexcept {
+        if constexpr (QUERY_STATS_ENABLED) {
+            if (stats != nullptr) {
+                stats_ = stats;
+                stage_ = stage;
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+    }
+    QueryStageTimer(const QueryStageTimer&) = delete;
+    QueryStageTimer& operator=(const QueryStageTimer&) = delete;
+    ~QueryStageTimer() {
+        Stop();
+    }
+
+    // Завершение замера до конца области видимости
+    void Stop() noexcept {
+        if constexpr (QUERY_STATS_ENABLED) {
+            if (stats_ != nullptr) {
+                stats_->stage_durations[static_cast<size_t>(stage_)] += std::chrono::steady_clock::now() - start_;
+                stats_ = nullptr;
+            }
+        }
+    }
+
+private:
+    QueryStats* stats_ = nullptr;
+    QueryStage stage_ = QueryStage::PARSE;
+    std::chrono::steady_clock::time_point start_;
+};
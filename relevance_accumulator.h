@@ -0,0 +1,133 @@
+#pragma once
+
+#include "query_stats.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Участок списка вхождений слова: id документов по возрастанию,
+// частоты слова в них и обратная документная частота слова
+struct PostingRun {
+    const int* document_ids;
+    const double* term_freqs;
+    size_t size;
+    double inverse_document_freq;
+    // Наибольший вклад слова в релевантность документа
+    double max_relevance;
+};
+
+// Доля документов диапазона, при которой релевантность
+// накапливается в плотном массиве, а не в разреженном списке
+inline constexpr size_t DENSE_SPAN_PER_POSTING = 4;
+
+// Накопление релевантности документов диапазона id [first_id, last_id] по
+// участкам списков вхождений плюс-слов. Документы из minus_runs исключаются,
+// частоты слов minus_runs не используются. Для остальных документов по
+// возрастанию id вызывается add_document(document_id, relevance).
+// Вклады слов суммируются в порядке plus_runs, поэтому релевантность
+// не зависит от выбранного накопителя. Все id участков лежат в диапазоне
+template <typename AddDocument>
+void AccumulateRelevance(const std::vector<PostingRun>& plus_runs, const std::vector<PostingRun>& minus_runs,
+                         int first_id, int last_id, AddDocument add_document, QueryStats* stats) {
+    size_t posting_count = 0;
+    for (const PostingRun& run : plus_runs) {
+        posting_count += run.size;
+    }
+    if (posting_count == 0) {
+        return;
+    }
+    // Счетчики ниже не используются и удаляются компилятором, если статистика не собирается
+    size_t candidate_count = 0;
+    size_t excluded_count = 0;
+
+    const size_t span = static_cast<size_t>(int64_t{last_id} - first_id + 1);
+    if (span <= posting_count * DENSE_SPAN_PER_POSTING) {
+        /// Плотный накопитель: релевантность и состояние каждого id диапазона
+        enum : uint8_t { NOT_FOUND, FOUND, EXCLUDED };
+        thread_local std::vector<double> relevances;
+        thread_local std::vector<uint8_t> states;
+        QueryStageTimer postings_timer(stats, QueryStage::POSTINGS);
+        relevances.assign(span, 0.0);
+        states.assign(span, NOT_FOUND);
+
+        /// Поиск документов содержащих плюс слова
+        for (const PostingRun& run : plus_runs) {
+            for (size_t i = 0; i < run.size; ++i) {
+                const size_t offset = run.document_ids[i] - first_id;
+                relevances[offset] += run.term_freqs[i] * run.inverse_document_freq;
+                states[offset] = FOUND;
+            }
+        }
+        postings_timer.Stop();
+        /// Исключение документов содержащих минус слова
+        QueryStageTimer exclusion_timer(stats, QueryStage::EXCLUSION);
+        for (const PostingRun& run : minus_runs) {
+            for (size_t i = 0; i < run.size; ++i) {
+                uint8_t& state = states[run.document_ids[i] - first_id];
+                excluded_count += state == FOUND;
+                state = EXCLUDED;
+            }
+        }
+        exclusion_timer.Stop();
+
+        QueryStageTimer collect_timer(stats, QueryStage::COLLECT);
+        for (size_t offset = 0; offset < span; ++offset) {
+            if (states[offset] == FOUND) {
+                ++candidate_count;
+                add_document(static_cast<int>(first_id + offset), relevances[offset]);
+            }
+        }
+        candidate_count += excluded_count;
+    } else {
+        /// Разреженный накопитель: вклады слов, упорядоченные по id документа
+        thread_local std::vector<std::pair<int, double>> contributions;
+        thread_local std::vector<int> excluded_ids;
+        QueryStageTimer postings_timer(stats, QueryStage::POSTINGS);
+        contributions.clear();
+        excluded_ids.clear();
+
+        /// Поиск документов содержащих плюс слова
+        for (const PostingRun& run : plus_runs) {
+            for (size_t i = 0; i < run.size; ++i) {
+                contributions.emplace_back(run.document_ids[i],
+                                           run.term_freqs[i] * run.inverse_document_freq);
+            }
+        }
+        // Устойчивая сортировка сохраняет порядок сложения вкладов слов
+        std::stable_sort(contributions.begin(), contributions.end(),
+                         [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        postings_timer.Stop();
+
+        /// Исключение документов содержащих минус слова
+        QueryStageTimer exclusion_timer(stats, QueryStage::EXCLUSION);
+        for (const PostingRun& run : minus_runs) {
+            excluded_ids.insert(excluded_ids.end(), run.document_ids, run.document_ids + run.size);
+        }
+        std::sort(excluded_ids.begin(), excluded_ids.end());
+        exclusion_timer.Stop();
+
+        QueryStageTimer collect_timer(stats, QueryStage::COLLECT);
+        auto it_excluded = excluded_ids.begin();
+        for (size_t i = 0; i < contributions.size();) {
+            const int document_id = contributions[i].first;
+            double relevance = 0.0;
+            for (; i < contributions.size() && contributions[i].first == document_id; ++i) {
+                relevance += contributions[i].second;
+            }
+            ++candidate_count;
+            it_excluded = std::lower_bound(it_excluded, excluded_ids.end(), document_id);
+            if (it_excluded == excluded_ids.end() || *it_excluded != document_id) {
+                add_document(document_id, relevance);
+            } else {
+                ++excluded_count;
+            }
+        }
+    }
+    AddQueryStat(stats, &QueryStats::candidates, candidate_count);
+    AddQueryStat(stats, &QueryStats::excluded, excluded_count);
+}
@@ -1,30 +1,258 @@
 #include <iostream>
 #include "remove_duplicates.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
 using namespace std;
 
-// Функция поиска и удаления повторяющихся элементов (откорректирована)
+namespace {
+
+// Количество предыдущих документов корзины LSH, с которыми сравнивается
+// документ. Документы корзины не больше этого размера сравниваются попарно
+constexpr size_t BUCKET_PAIR_WINDOW = 32;
+
+// 128-битный отпечаток набора слов документа
+struct DocumentFingerprint {
+    uint64_t high;
+    uint64_t low;
+    int document_id;
+};
+
+uint64_t MixTerm(uint64_t term, uint64_t seed) {
+    uint64_t hash = term + seed;
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+// Отпечаток - суммы двух независимых хешей слов, поэтому он не зависит
+// от порядка слов, а у документов с одинаковыми наборами слов совпадает
+DocumentFingerprint ComputeFingerprint(const DocumentTerms& terms, int document_id) {
+    constexpr uint64_t SEED_HIGH = 0x9E3779B97F4A7C15ULL;
+    constexpr uint64_t SEED_LOW = 0xC2B2AE3D27D4EB4FULL;
+    uint64_t high = MixTerm(terms.size(), SEED_LOW);
+    uint64_t low = MixTerm(terms.size(), SEED_HIGH);
+    for (const auto& [term, freq] : terms) {
+        high += MixTerm(term, SEED_HIGH);
+        low += MixTerm(term, SEED_LOW);
+    }
+    return {high, low, document_id};
+}
+
+bool HaveSameTerms(const DocumentTerms& lhs, const DocumentTerms& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                 [](const TermFrequency& lhs_term, const TermFrequency& rhs_term) {
+        return lhs_term.term == rhs_term.term;
+    });
+}
+
+// Мера Жаккара наборов слов, слова документа упорядочены по id
+double ComputeJaccard(const DocumentTerms& lhs, const DocumentTerms& rhs) {
+    if (lhs.empty() && rhs.empty()) {
+        return 1.0;
+    }
+    size_t common = 0;
+    auto lhs_it = lhs.begin();
+    auto rhs_it = rhs.begin();
+    while (lhs_it != lhs.end() && rhs_it != rhs.end()) {
+        if (lhs_it->term < rhs_it->term) {
+            ++lhs_it;
+        } else if (rhs_it->term < lhs_it->term) {
+            ++rhs_it;
+        } else {
+            ++common;
+            ++lhs_it;
+            ++rhs_it;
+        }
+    }
+    return static_cast<double>(common) / (lhs.size() + rhs.size() - common);
+}
+
+// Ключи полос сигнатуры MinHash документа. i-я функция сигнатуры -
+// старшие биты a_i * h(term) + b_i, минимум берется по словам документа
+void ComputeBandKeys(const DocumentTerms& terms, const vector<uint64_t>& multipliers,
+                     const vector<uint64_t>& offsets, size_t band_count, uint64_t* band_keys) {
+    const size_t hash_count = multipliers.size();
+    thread_local vector<uint32_t> signature;
+    signature.assign(hash_count, numeric_limits<uint32_t>::max());
+    for (const auto& [term, freq] : terms) {
+        const uint64_t term_hash = MixTerm(term, offsets.front());
+        for (size_t i = 0; i < hash_count; ++i) {
+            signature[i] = min(signature[i], static_cast<uint32_t>((multipliers[i] * term_hash + offsets[i]) >> 32));
+        }
+    }
+
+    const size_t rows = hash_count / band_count;
+    for (size_t band = 0; band < band_count; ++band) {
+        uint64_t key = MixTerm(band, 0);
+        for (size_t row = 0; row < rows; ++row) {
+            key = MixTerm(key ^ signature[band * rows + row], band);
+        }
+        band_keys[band] = key;
+    }
+}
+
+} // namespace
+
+// Функция поиска и удаления повторяющихся элементов.
+// Документы группируются по отпечаткам наборов слов, внутри группы наборы
+// сравниваются точно. Из документов с одинаковыми словами остается документ
+// с наименьшим id, остальные удаляются после поиска всех повторов
 void RemoveDuplicates(SearchServer& search_server) {
-    map<set<string_view>, set<int>> words_in_documents;
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    vector<DocumentFingerprint> fingerprints(document_ids.size());
+    transform(execution::par, document_ids.begin(), document_ids.end(), fingerprints.begin(),
+              [&search_server](int document_id) {
+        return ComputeFingerprint(search_server.GetDocumentTerms(document_id), document_id);
+    });
+    sort(execution::par, fingerprints.begin(), fingerprints.end(),
+         [](const DocumentFingerprint& lhs, const DocumentFingerprint& rhs) {
+        return tie(lhs.high, lhs.low, lhs.document_id) < tie(rhs.high, rhs.low, rhs.document_id);
+    });
 
-    for (auto it = search_server.begin(); it != search_server.end(); ++it) {
-        set<string_view> words_in_document;
-        for (const auto& [word, freq] : search_server.GetWordFrequencies(*it)) {
-            words_in_document.insert(word);
+    // Начала групп документов с одинаковыми отпечатками
+    vector<size_t> group_starts;
+    for (size_t i = 0; i < fingerprints.size(); ++i) {
+        if (i == 0 || fingerprints[i].high != fingerprints[i - 1].high
+            || fingerprints[i].low != fingerprints[i - 1].low) {
+            group_starts.push_back(i);
         }
-        words_in_documents[words_in_document].insert(*it);
     }
+    group_starts.push_back(fingerprints.size());
 
-    for (const auto& [wrds, ids] : words_in_documents) {
-        if (ids.size() == 1) {
-            continue;
+    // Документ группы повторяет первый документ с тем же набором слов,
+    // документы внутри группы упорядочены по id
+    vector<char> is_duplicate(fingerprints.size(), 0);
+    vector<size_t> groups(group_starts.size() - 1);
+    iota(groups.begin(), groups.end(), 0);
+    for_each(execution::par, groups.begin(), groups.end(),
+             [&search_server, &fingerprints, &group_starts, &is_duplicate](size_t group) {
+        const size_t first = group_starts[group];
+        const size_t last = group_starts[group + 1];
+        for (size_t i = first + 1; i < last; ++i) {
+            const DocumentTerms& terms = search_server.GetDocumentTerms(fingerprints[i].document_id);
+            for (size_t j = first; j < i; ++j) {
+                if (!is_duplicate[j]
+                    && HaveSameTerms(terms, search_server.GetDocumentTerms(fingerprints[j].document_id))) {
+                    is_duplicate[i] = 1;
+                    break;
+                }
+            }
+        }
+    });
+
+    vector<int> duplicates;
+    for (size_t i = 0; i < fingerprints.size(); ++i) {
+        if (is_duplicate[i]) {
+            duplicates.push_back(fingerprints[i].document_id);
         }
+    }
+    // Каждый список вхождений переписывается один раз для всех повторов
+    search_server.RemoveDocuments(execution::par, duplicates);
+}
 
-        auto it = ids.begin();
-        ++it;
-        for (; it != ids.end(); ++it) {
-            //cout << "Found duplicate document id "s << *it << endl;
-            search_server.RemoveDocument(*it);
+vector<NearDuplicate> FindNearDuplicates(const SearchServer& search_server, const NearDuplicateOptions& options) {
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    const size_t document_count = document_ids.size();
+    const size_t band_count = max<size_t>(1, min(options.band_count, options.hash_count));
+    const size_t hash_count = max(options.hash_count / band_count, size_t{1}) * band_count;
+
+    // Нечетные множители и сдвиги функций сигнатуры
+    vector<uint64_t> multipliers(hash_count);
+    vector<uint64_t> offsets(hash_count);
+    for (size_t i = 0; i < hash_count; ++i) {
+        multipliers[i] = MixTerm(i, options.seed) | 1;
+        offsets[i] = MixTerm(i, ~options.seed);
+    }
+
+    vector<uint64_t> band_keys(document_count * band_count);
+    vector<size_t> document_indexes(document_count);
+    iota(document_indexes.begin(), document_indexes.end(), 0);
+    for_each(execution::par, document_indexes.begin(), document_indexes.end(), [&](size_t index) {
+        ComputeBandKeys(search_server.GetDocumentTerms(document_ids[index]), multipliers, offsets,
+                        band_count, band_keys.data() + index * band_count);
+    });
+
+    // Кандидаты из каждой полосы: документ корзины сравнивается с несколькими
+    // предыдущими документами корзины, а не только с первым, ведь первый сам
+    // может оказаться повтором документа из другой корзины. Окно ограничивает
+    // число пар в больших корзинах
+    vector<vector<uint64_t>> band_pairs(band_count);
+    vector<size_t> bands(band_count);
+    iota(bands.begin(), bands.end(), 0);
+    for_each(execution::par, bands.begin(), bands.end(), [&](size_t band) {
+        vector<pair<uint64_t, uint32_t>> buckets(document_count);
+        for (size_t index = 0; index < document_count; ++index) {
+            buckets[index] = {band_keys[index * band_count + band], static_cast<uint32_t>(index)};
+        }
+        sort(buckets.begin(), buckets.end());
+        size_t first = 0;
+        for (size_t i = 1; i < buckets.size(); ++i) {
+            if (buckets[i].first != buckets[first].first) {
+                first = i;
+                continue;
+            }
+            for (size_t j = max(first, i > BUCKET_PAIR_WINDOW ? i - BUCKET_PAIR_WINDOW : 0); j < i; ++j) {
+                band_pairs[band].push_back((uint64_t{buckets[j].second} << 32) | buckets[i].second);
+            }
         }
+    });
+
+    vector<uint64_t> candidates;
+    for (vector<uint64_t>& pairs : band_pairs) {
+        candidates.insert(candidates.end(), pairs.begin(), pairs.end());
+        vector<uint64_t>().swap(pairs);
+    }
+    sort(execution::par, candidates.begin(), candidates.end());
+    candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+    vector<double> similarities(candidates.size());
+    transform(execution::par, candidates.begin(), candidates.end(), similarities.begin(),
+              [&search_server, &document_ids](uint64_t candidate) {
+        return ComputeJaccard(search_server.GetDocumentTerms(document_ids[candidate >> 32]),
+                              search_server.GetDocumentTerms(document_ids[candidate & 0xFFFFFFFF]));
+    });
+
+    // Похожие пары, упорядоченные по большему номеру документа
+    struct SimilarPair {
+        uint32_t later;
+        uint32_t earlier;
+        double similarity;
+    };
+    vector<SimilarPair> similar_pairs;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (similarities[i] >= options.jaccard_threshold) {
+            similar_pairs.push_back({static_cast<uint32_t>(candidates[i] & 0xFFFFFFFF),
+                                     static_cast<uint32_t>(candidates[i] >> 32), similarities[i]});
+        }
+    }
+    sort(similar_pairs.begin(), similar_pairs.end(), [](const SimilarPair& lhs, const SimilarPair& rhs) {
+        return tie(lhs.later, lhs.earlier) < tie(rhs.later, rhs.earlier);
+    });
+
+    vector<char> is_duplicate(document_count, 0);
+    vector<NearDuplicate> duplicates;
+    for (size_t i = 0; i < similar_pairs.size(); ++i) {
+        const SimilarPair& similar = similar_pairs[i];
+        if (is_duplicate[similar.later] || is_duplicate[similar.earlier]) {
+            continue;
+        }
+        is_duplicate[similar.later] = 1;
+        duplicates.push_back({document_ids[similar.later], document_ids[similar.earlier], similar.similarity});
+    }
+    return duplicates;
+}
+
+void RemoveNearDuplicates(SearchServer& search_server, const NearDuplicateOptions& options) {
+    vector<int> duplicates;
+    for (const NearDuplicate& duplicate : FindNearDuplicates(search_server, options)) {
+        duplicates.push_back(duplicate.document_id);
     }
+    search_server.RemoveDocuments(execution::par, duplicates);
 }
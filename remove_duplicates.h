@@ -1,4 +1,36 @@
 #pragma once
 #include "search_server.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 void RemoveDuplicates(SearchServer& search_server);
+
+// Параметры поиска почти повторяющихся документов
+struct NearDuplicateOptions {
+    // Наименьшая мера Жаккара наборов слов, при которой документ считается повтором
+    double jaccard_threshold = 0.8;
+    // Длина сигнатуры MinHash и количество полос LSH, на которые она делится.
+    // Больше полос - больше кандидатов и меньше пропущенных повторов
+    size_t hash_count = 128;
+    size_t band_count = 32;
+    uint64_t seed = 1;
+};
+
+// Документ, повторяющий документ с меньшим id
+struct NearDuplicate {
+    int document_id;
+    int original_id;
+    double similarity;
+};
+
+// Почти повторяющиеся документы, упорядоченные по id. Кандидаты отбираются
+// по совпадению полос сигнатур MinHash, мера Жаккара кандидатов вычисляется
+// точно. Документы просматриваются по возрастанию id, документ считается
+// повтором, если он похож на один из оставляемых документов
+std::vector<NearDuplicate> FindNearDuplicates(const SearchServer& search_server,
+                                              const NearDuplicateOptions& options = NearDuplicateOptions{});
+// Удаление найденных почти повторяющихся документов
+void RemoveNearDuplicates(SearchServer& search_server,
+                          const NearDuplicateOptions& options = NearDuplicateOptions{});
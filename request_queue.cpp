@@ -1,40 +1,168 @@
 #include "request_queue.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <tuple>
 
 using namespace std;
 
-RequestQueue::RequestQueue(const SearchServer &search_server) : server_(search_server) {
+double RequestStats::AverageLatencyMs() const noexcept {
+    return request_count == 0 ? 0.0 : total_latency.count() / 1000.0 / request_count;
+}
+
+RequestQueue::RequestQueue(const SearchServer& search_server, size_t capacity, Clock::duration window)
+    : server_(search_server)
+    , capacity_(max<size_t>(capacity, 1))
+    , bucket_width_(max<Clock::duration>(window / BUCKET_COUNT, Clock::duration{1}))
+    , records_(new atomic<uint64_t>[capacity_]()) {
 }
 
 vector<Document> RequestQueue::AddFindRequest(const string& raw_query, DocumentStatus status) {
-    // Удаление старого запроса
-    DelElement();
-    // Добавление нового запроса
-    vector<Document> result = server_.FindTopDocuments(raw_query, status);
-    AddElement(raw_query, result);
-    // Возвращение результатов поиска
-    return result;
+    return FindAndRecord(raw_query, status);
+}
+
+vector<Document> RequestQueue::AddFindRequest(const PreparedQuery& query, DocumentStatus status) {
+    return FindAndRecord(query, status);
+}
+
+void RequestQueue::RecordRequest(size_t result_count, chrono::microseconds latency, Clock::time_point time) {
+    // Новая запись вытесняет самую старую, суммы буфера меняются на разность.
+    // Барьер не дает изменениям сумм опередить отметку о начале регистрации
+    started_writes_.fetch_add(1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    const uint64_t record = PackRecord(result_count, latency);
+    const uint64_t slot = next_record_.fetch_add(1, memory_order_relaxed) % capacity_;
+    const uint64_t old_record = records_[slot].exchange(record, memory_order_relaxed);
+
+    const uint64_t latency_mask = (uint64_t{1} << LATENCY_BITS) - 1;
+    const auto unpack = [latency_mask](uint64_t packed) {
+        return tuple{
+            uint64_t{(packed & VALID_RECORD) != 0},
+            (packed >> LATENCY_BITS) & ((uint64_t{1} << RESULT_BITS) - 1),
+            packed & latency_mask
+        };
+    };
+    const auto [new_valid, new_results, new_latency] = unpack(record);
+    const auto [old_valid, old_results, old_latency] = unpack(old_record);
+    // Нулевые изменения пропускаются, чтобы не занимать строку кэша
+    const auto add = [](atomic<uint64_t>& counter, uint64_t delta) {
+        if (delta != 0) {
+            counter.fetch_add(delta, memory_order_relaxed);
+        }
+    };
+    add(no_result_count_, uint64_t{new_valid != 0 && new_results == 0} - uint64_t{old_valid != 0 && old_results == 0});
+    add(result_count_, new_results - old_results);
+    add(latency_us_, new_latency - old_latency);
+    finished_writes_.fetch_add(1, memory_order_release);
+
+    const uint64_t tick = GetTick(time);
+    Bucket& bucket = buckets_[tick % BUCKET_COUNT];
+    AddToCounter(bucket.request_count, tick, 1);
+    if (result_count == 0) {
+        AddToCounter(bucket.no_result_count, tick, 1);
+    }
+    AddToCounter(bucket.result_count, tick, result_count);
+    AddToCounter(bucket.latency_us, tick, latency.count());
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    return count_empty_query_;
+    return static_cast<int>(GetLastRequestsStats().no_result_count);
 }
 
-// Удаление устаревшего запроса
-void RequestQueue::DelElement() {
-    if (count_query_ == sec_in_day_) {
-        if (requests_.front().is_empty) {
-            --count_empty_query_;
+RequestStats RequestQueue::GetLastRequestsStats() const {
+    RequestStats stats;
+    uint64_t writes = 0;
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+        if (TryReadLastRequestsStats(stats, writes)) {
+            // Занятый кэш не ждется: его обновит другой читатель.
+            // Более старая статистика не заменяет более новую
+            if (unique_lock lock(last_stats_mutex_, try_to_lock); lock && writes >= last_stats_writes_) {
+                last_stats_ = stats;
+                last_stats_writes_ = writes;
+            }
+            return stats;
+        }
+    }
+    // При непрерывной регистрации из многих потоков чтение не повторяется
+    // бесконечно, а возвращает последнюю согласованную статистику
+    lock_guard lock(last_stats_mutex_);
+    return last_stats_;
+}
+
+bool RequestQueue::TryReadLastRequestsStats(RequestStats& stats, uint64_t& writes) const {
+    // Суммы согласованы, если до их чтения все начатые регистрации
+    // завершились, а после чтения не началось ни одной новой
+    writes = started_writes_.load(memory_order_acquire);
+    if (finished_writes_.load(memory_order_acquire) != writes) {
+        return false;
+    }
+    stats.request_count = min<uint64_t>(next_record_.load(memory_order_relaxed), capacity_);
+    stats.no_result_count = no_result_count_.load(memory_order_relaxed);
+    stats.result_count = result_count_.load(memory_order_relaxed);
+    stats.total_latency = chrono::microseconds(latency_us_.load(memory_order_relaxed));
+    atomic_thread_fence(memory_order_acquire);
+    return started_writes_.load(memory_order_relaxed) == writes;
+}
+
+RequestStats RequestQueue::GetWindowStats(Clock::time_point time) const {
+    const uint64_t last_tick = GetTick(time);
+    const uint64_t first_tick = last_tick >= BUCKET_COUNT - 1 ? last_tick - (BUCKET_COUNT - 1) : 0;
+    RequestStats stats;
+    uint64_t latency_us = 0;
+    for (const Bucket& bucket : buckets_) {
+        stats.request_count += ReadCounter(bucket.request_count, first_tick, last_tick);
+        stats.no_result_count += ReadCounter(bucket.no_result_count, first_tick, last_tick);
+        stats.result_count += ReadCounter(bucket.result_count, first_tick, last_tick);
+        latency_us += ReadCounter(bucket.latency_us, first_tick, last_tick);
+    }
+    stats.total_latency = chrono::microseconds(latency_us);
+    return stats;
+}
+
+uint64_t RequestQueue::PackRecord(size_t result_count, chrono::microseconds latency) {
+    const uint64_t results = min<uint64_t>(result_count, (uint64_t{1} << RESULT_BITS) - 1);
+    const uint64_t latency_us = min<uint64_t>(max<int64_t>(latency.count(), 0), (uint64_t{1} << LATENCY_BITS) - 1);
+    return VALID_RECORD | (results << LATENCY_BITS) | latency_us;
+}
+
+uint64_t RequestQueue::GetTick(Clock::time_point time) const {
+    return static_cast<uint64_t>(time.time_since_epoch() / bucket_width_);
+}
+
+void RequestQueue::AddToCounter(atomic<uint64_t>& counter, uint64_t tick, uint64_t value) {
+    // Устаревший счетчик и так не попадает в статистику, сбрасывать его не нужно
+    if (value == 0) {
+        return;
+    }
+    // Номер интервала хранится по модулю 2^TICK_BITS
+    const uint64_t tick_mask = (uint64_t{1} << TICK_BITS) - 1;
+    const uint64_t value_mask = (uint64_t{1} << VALUE_BITS) - 1;
+    uint64_t current = counter.load(memory_order_relaxed);
+    while (true) {
+        const uint64_t age = (tick - (current >> VALUE_BITS)) & tick_mask;
+        uint64_t updated;
+        if (current != 0 && age == 0) {
+            updated = current + value;
+        } else if (current == 0 || age < (tick_mask >> 1)) {
+            updated = ((tick & tick_mask) << VALUE_BITS) | (value & value_mask);
+        } else {
+            // Счетчик более нового интервала не трогается: запись опоздала
+            // больше чем на окно и в статистику не попадает
+            return;
+        }
+        if (counter.compare_exchange_weak(current, updated, memory_order_relaxed)) {
+            return;
         }
-        requests_.pop_front();
-    } else {
-        ++count_query_;
     }
 }
 
-// Добавление нового запроса
-void RequestQueue::AddElement(const std::string& raw_query, std::vector<Document>& result_search) {
-    requests_.push_back({raw_query, result_search, result_search.empty()});
-    if (result_search.empty()) {
-        ++count_empty_query_;
+uint64_t RequestQueue::ReadCounter(const atomic<uint64_t>& counter, uint64_t first_tick, uint64_t last_tick) {
+    const uint64_t current = counter.load(memory_order_relaxed);
+    if (current == 0) {
+        return 0;
     }
+    const uint64_t value_mask = (uint64_t{1} << VALUE_BITS) - 1;
+    const uint64_t tick_mask = (uint64_t{1} << TICK_BITS) - 1;
+    const uint64_t age = (last_tick - (current >> VALUE_BITS)) & tick_mask;
+    return age <= last_tick - first_tick ? current & value_mask : 0;
 }
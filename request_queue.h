@@ -1,46 +1,137 @@
 #pragma once
-#include <queue>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include "document.h"
 #include "search_server.h"
 
+// Статистика набора запросов
+struct RequestStats {
+    uint64_t request_count = 0;
+    uint64_t no_result_count = 0;
+    // Суммарное количество найденных документов
+    uint64_t result_count = 0;
+    std::chrono::microseconds total_latency{0};
+
+    double AverageLatencyMs() const noexcept;
+};
+
+// Учет поисковых запросов. Хранит компактные записи о последних capacity
+// запросах в кольцевом буфере и счетчики запросов за скользящее окно времени.
+// Запросы регистрируются из многих потоков без блокировок, статистика
+// за последние запросы и за окно времени вычисляется за постоянное время
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer &search_server);
+    using Clock = std::chrono::steady_clock;
+
+    // Количество учитываемых последних запросов по умолчанию: по запросу в минуту за сутки
+    static constexpr size_t DEFAULT_CAPACITY = 1440;
+
+    explicit RequestQueue(const SearchServer& search_server,
+                          size_t capacity = DEFAULT_CAPACITY,
+                          Clock::duration window = std::chrono::hours(24));
 
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status = DocumentStatus::ACTUAL);
+    // Запрос, подготовленный search_server.PrepareQuery
+    template <typename DocumentPredicate>
+    std::vector<Document> AddFindRequest(const PreparedQuery& query, DocumentPredicate document_predicate);
+    std::vector<Document> AddFindRequest(const PreparedQuery& query, DocumentStatus status = DocumentStatus::ACTUAL);
+
+    // Регистрация запроса, выполненного в другом месте
+    void RecordRequest(size_t result_count, std::chrono::microseconds latency, Clock::time_point time = Clock::now());
 
+    // Количество запросов без результатов среди последних capacity запросов.
+    // Суммы читаются согласованно: чтение, совпавшее с регистрацией запроса,
+    // повторяется не более MAX_READ_ATTEMPTS раз, после чего возвращается
+    // последняя согласованная статистика
     int GetNoResultRequests() const;
+    RequestStats GetLastRequestsStats() const;
+    // Статистика запросов за окно времени, заканчивающееся в момент time.
+    // Окно учитывается частями по 1/BUCKET_COUNT его длины
+    RequestStats GetWindowStats(Clock::time_point time = Clock::now()) const;
 
 private:
-    struct QueryResult {
-        std::string query;
-        std::vector<Document> res;
-        bool is_empty;
+    static constexpr size_t BUCKET_COUNT = 64;
+    static constexpr int MAX_READ_ATTEMPTS = 64;
+
+    // Выполнение запроса на сервере и его регистрация
+    template <typename QueryType, typename Filter>
+    std::vector<Document> FindAndRecord(const QueryType& query, Filter filter);
+
+    // Запись о запросе в одном 64-битном слове: признак записи,
+    // количество найденных документов и время выполнения в микросекундах
+    static constexpr int RESULT_BITS = 16;
+    static constexpr int LATENCY_BITS = 32;
+    static constexpr uint64_t VALID_RECORD = uint64_t{1} << (RESULT_BITS + LATENCY_BITS);
+
+    // Счетчик части окна: номер интервала времени в старших битах и значение
+    // в младших. Счетчик устаревшего интервала сбрасывается первой записью
+    // нового интервала, поэтому для сброса не нужна блокировка
+    static constexpr int TICK_BITS = 24;
+    static constexpr int VALUE_BITS = 64 - TICK_BITS;
+
+    struct alignas(64) Bucket {
+        std::atomic<uint64_t> request_count{0};
+        std::atomic<uint64_t> no_result_count{0};
+        std::atomic<uint64_t> result_count{0};
+        std::atomic<uint64_t> latency_us{0};
     };
 
-    // Приватные параметры класса
-    std::deque<QueryResult> requests_;
-    const static int sec_in_day_ = 1440;
-    const SearchServer &server_;
-    int count_query_ = 0;
-    int count_empty_query_ = 0;
-
-    // Удаление устаревшего запроса
-    void DelElement();
-    // Добавление нового запроса
-    void AddElement(const std::string& raw_query, std::vector<Document>& result_search);
+    const SearchServer& server_;
+    const size_t capacity_;
+    const Clock::duration bucket_width_;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> records_;
+    // Счетчики начатых и завершенных регистраций. Регистрации не ждут друг
+    // друга, а чтение сумм повторяется, пока между ними шла регистрация
+    alignas(64) std::atomic<uint64_t> started_writes_{0};
+    alignas(64) std::atomic<uint64_t> finished_writes_{0};
+    alignas(64) std::atomic<uint64_t> next_record_{0};
+    // Суммы по записям кольцевого буфера. Запись буфера и суммы меняются
+    // отдельными операциями, поэтому суммы читаются только между регистрациями
+    std::atomic<uint64_t> no_result_count_{0};
+    std::atomic<uint64_t> result_count_{0};
+    std::atomic<uint64_t> latency_us_{0};
+
+    // Последняя согласованная статистика и количество регистраций до нее
+    mutable std::mutex last_stats_mutex_;
+    mutable RequestStats last_stats_;
+    mutable uint64_t last_stats_writes_ = 0;
+
+    std::array<Bucket, BUCKET_COUNT> buckets_;
+
+    static uint64_t PackRecord(size_t result_count, std::chrono::microseconds latency);
+    // Чтение сумм буфера, false если во время чтения шла регистрация
+    bool TryReadLastRequestsStats(RequestStats& stats, uint64_t& writes) const;
+    uint64_t GetTick(Clock::time_point time) const;
+    static void AddToCounter(std::atomic<uint64_t>& counter, uint64_t tick, uint64_t value);
+    static uint64_t ReadCounter(const std::atomic<uint64_t>& counter, uint64_t first_tick, uint64_t last_tick);
 };
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-    // Удаление старого запроса
-    DelElement();
-    // Добавление нового запроса
-    std::vector<Document> result = server_.FindTopDocuments(raw_query, document_predicate);
-    AddElement(raw_query, result);
+    return FindAndRecord(raw_query, document_predicate);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> RequestQueue::AddFindRequest(const PreparedQuery& query, DocumentPredicate document_predicate) {
+    return FindAndRecord(query, document_predicate);
+}
+
+template <typename QueryType, typename Filter>
+std::vector<Document> RequestQueue::FindAndRecord(const QueryType& query, Filter filter) {
+    OperationTimer timer(Operation::REQUEST_QUEUE_FIND);
+    const auto start_time = Clock::now();
+    std::vector<Document> result = server_.FindTopDocuments(query, filter);
+    const auto end_time = Clock::now();
+    RecordRequest(result.size(), std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time),
+                  end_time);
     // Возвращение результатов поиска
     return result;
 }
@@ -1,6 +1,8 @@
 #include "search_server.h"
+#include "snapshot_file.h"
 #include "string_processing.h"
 
+#include <atomic>
 #include <cmath>
 #include <execution>
 
@@ -18,6 +20,7 @@ void SearchServer::AddDocument(const int document_id,
                                string_view document,
                                const DocumentStatus status,
                                const vector<int>& ratings) {
+    OperationTimer timer(Operation::ADD_DOCUMENT);
     CheckId(document_id);
     AddDocumentWithoutCheckId(document_id,
                               document,
@@ -29,21 +32,135 @@ void SearchServer::AddDocumentWithoutCheckId(const int document_id,
                                              const std::string_view document,
                                              const DocumentStatus status,
                                              const std::vector<int>& ratings) {
-    auto words = SplitIntoWordsNoStop(document);
+    const auto word_freqs = ParseDocument(document);
 
-    const double inv_word_count = 1.0 / words.size();
-    for (std::string_view word : words) {
-        WordCheckOnValid(word);
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        word_to_document_freqs_id_key_[document_id][word] += inv_word_count;
+    auto& document_terms = word_to_document_freqs_id_key_[document_id].Mutable();
+    document_terms.reserve(word_freqs.size());
+    for (const auto& [word, term_freq] : word_freqs) {
+        document_terms.push_back({terms_.Intern(word), term_freq});
+    }
+    SortDocumentTerms(document_terms);
+
+    for (const auto& [term, term_freq] : document_terms) {
+        word_to_document_freqs_[term].Add(document_id, term_freq);
     }
     document_ratings_[document_id] = {ComputeAverageRating(ratings), status};
+    word_to_document_freqs_.SetDocumentCount(document_ratings_.size());
     document_ids_.insert(document_id);
+    document_texts_.Add(document_id, document);
+    generation_ = NextGeneration();
+}
+
+// Разбор текста документа: проверка слов и подсчет их частот.
+// Не изменяет сервер, поэтому может выполняться параллельно
+vector<pair<string_view, double>> SearchServer::ParseDocument(const string_view document) const {
+    return ComputeWordFrequencies(document, [this](string_view word) {
+        return IsStopWord(word);
+    });
+}
+
+void SearchServer::SortDocumentTerms(vector<TermFrequency>& document_terms) {
+    sort(document_terms.begin(), document_terms.end(),
+         [](const TermFrequency& lhs, const TermFrequency& rhs) {
+        return lhs.term < rhs.term;
+    });
 }
 
 vector<Document> SearchServer::FindTopDocuments(const string_view raw_query,
-                                                const DocumentStatus document_status) const {
-    return FindTopDocuments(execution::seq, raw_query, document_status);
+                                                const DocumentStatus document_status,
+                                                size_t top_k) const {
+    return FindTopDocuments(execution::seq, raw_query, document_status, top_k);
+}
+
+vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query,
+                                                const DocumentStatus document_status,
+                                                size_t top_k) const {
+    return FindTopDocuments(execution::seq, query, document_status, top_k);
+}
+
+PreparedQuery SearchServer::PrepareQuery(string_view raw_query) const {
+    PreparedQuery query = ParseQuery(raw_query, true);
+    query.text_ = raw_query;
+    query.dictionary_token_ = dictionary_token_.value;
+    query.term_count_ = terms_.size();
+    return query;
+}
+
+void SearchServer::RefreshPreparedQuery(PreparedQuery& query) const {
+    if (query.dictionary_token_ != dictionary_token_.value) {
+        query = PrepareQuery(query.text_);
+        return;
+    }
+    if (query.term_count_ == terms_.size()) {
+        return;
+    }
+    AddFoundUnknownWords(query, query);
+    auto& unknown_words = query.unknown_words_;
+    unknown_words.erase(remove_if(unknown_words.begin(), unknown_words.end(),
+                                  [this](const PreparedQuery::UnknownWord& unknown) {
+        return terms_.Find(unknown.word) != TermDictionary::NO_TERM;
+    }), unknown_words.end());
+    query.term_count_ = terms_.size();
+}
+
+size_t SearchServer::EstimateQueryCost(string_view raw_query) const {
+    return CountPlusPostings(ParseQuery(raw_query));
+}
+
+size_t SearchServer::EstimateQueryCost(const PreparedQuery& query) const {
+    Query reparsed;
+    return CountPlusPostings(ResolvePreparedQuery(query, reparsed));
+}
+
+void SearchServer::EnableQueryCache(size_t capacity) {
+    query_cache_ = make_shared<QueryCache>(capacity);
+}
+
+void SearchServer::DisableQueryCache() {
+    query_cache_.reset();
+}
+
+QueryCacheStats SearchServer::GetQueryCacheStats() const {
+    return query_cache_ ? query_cache_->GetStats() : QueryCacheStats{};
+}
+
+void SearchServer::SetRetrievalMode(RetrievalMode mode) noexcept {
+    retrieval_mode_ = mode;
+}
+
+RetrievalMode SearchServer::GetRetrievalMode() const noexcept {
+    return retrieval_mode_;
+}
+
+PostingRun SearchServer::MakePostingRun(TermId term, DocumentIdRange range) const {
+    const PostingList* postings = word_to_document_freqs_.Find(term);
+    if (postings == nullptr) {
+        return PostingRun{nullptr, nullptr, 0, 0.0, 0.0};
+    }
+    const size_t first = postings->LowerBound(range.first);
+    const size_t last = postings->UpperBound(range.last);
+    const double inverse_document_freq = word_to_document_freqs_.InverseDocumentFreq(*postings);
+    return PostingRun{postings->DocumentIds() + first,
+                      postings->TermFreqs() + first,
+                      last - first,
+                      inverse_document_freq,
+                      postings->MaxTermFreq() * inverse_document_freq};
+}
+
+size_t SearchServer::CountPlusPostings(const Query& query) const {
+    size_t posting_count = 0;
+    for (const TermId term : query.plus_terms_) {
+        if (const PostingList* postings = word_to_document_freqs_.Find(term)) {
+            posting_count += postings->size();
+        }
+    }
+    return posting_count;
+}
+
+uint64_t SearchServer::NextGeneration() noexcept {
+    // Нулевой номер не выдается: им помечен запрос, не подготовленный сервером
+    static atomic<uint64_t> next_generation{1};
+    return next_generation.fetch_add(1, memory_order_relaxed);
 }
 
 int SearchServer::GetDocumentCount() const {
@@ -51,11 +168,11 @@ int SearchServer::GetDocumentCount() const {
 }
 
 void SearchServer::StringViewConstructor(std::string_view text) {
-    const vector<string_view> words = SplitIntoWords(text);
-    for (string_view word : words) {
-        WordCheckOnValid(word);
-        stop_words_.insert(word);
+    vector<string_view> words;
+    if (!SplitIntoWords(text, words)) {
+        throw std::invalid_argument("Invalid symbol!");
     }
+    stop_words_.insert(words.begin(), words.end());
 }
 
 void SearchServer::CollectionParse(const std::string& in_str) {
@@ -82,42 +199,266 @@ std::set<int>::iterator SearchServer::end() noexcept {
     return document_ids_.end();
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    static const std::map<std::string_view, double> default_empty_map;
-    return word_to_document_freqs_id_key_.count(document_id) > 0 ? word_to_document_freqs_id_key_.at(document_id) : default_empty_map;
+std::set<int>::const_iterator SearchServer::begin() const noexcept {
+    return document_ids_.begin();
+}
+
+std::set<int>::const_iterator SearchServer::end() const noexcept {
+    return document_ids_.end();
+}
+
+std::string_view SearchServer::GetDocumentText(int document_id) const {
+    return document_texts_.Get(document_id);
+}
+
+void SearchServer::CompactDocumentTexts() {
+    document_texts_.Compact();
+}
+
+void SearchServer::CompactTerms() {
+    // Оставшиеся слова получают id в прежнем порядке, поэтому слова
+    // документов остаются упорядоченными по id без сортировки
+    vector<TermId> new_ids(terms_.size(), TermDictionary::NO_TERM);
+    TermDictionary terms;
+    for (TermId term = 0; term < terms_.size(); ++term) {
+        if (word_to_document_freqs_.Find(term) != nullptr) {
+            new_ids[term] = terms.Intern(terms_.GetWord(term));
+        }
+    }
+    if (terms.size() == terms_.size()) {
+        return;
+    }
+
+    word_to_document_freqs_.Renumber(new_ids, terms.size());
+    for (auto& [document_id, document_terms] : word_to_document_freqs_id_key_) {
+        for (TermFrequency& term_freq : document_terms.Mutable()) {
+            term_freq.term = new_ids[term_freq.term];
+        }
+    }
+    terms_ = move(terms);
+    // Новый идентификатор словаря и поколение: подготовленные запросы
+    // и записи кэша содержат прежние id слов
+    dictionary_token_ = DictionaryToken{};
+    generation_ = NextGeneration();
+}
+
+std::map<std::string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
+    std::map<std::string_view, double> word_freqs;
+    for (const auto& [term, freq] : GetDocumentTerms(document_id)) {
+        word_freqs.emplace(terms_.GetWord(term), freq);
+    }
+    return word_freqs;
+}
+
+TermStatistics SearchServer::GetTermStatistics(std::string_view word) const {
+    return word_to_document_freqs_.GetStatistics(terms_.Find(word));
+}
+
+const DocumentTerms& SearchServer::GetDocumentTerms(int document_id) const {
+    static const DocumentTerms default_empty_terms;
+    const auto it = word_to_document_freqs_id_key_.find(document_id);
+    return it != word_to_document_freqs_id_key_.end() ? it->second : default_empty_terms;
 }
 
 void SearchServer::RemoveDocument(int document_id) {
     RemoveDocument(execution::seq, document_id);
 }
 
+void SearchServer::RemoveDocuments(const vector<int>& document_ids) {
+    RemoveDocuments(execution::seq, document_ids);
+}
+
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const string_view raw_query,
                                                                   int document_id) const {
     return MatchDocument(execution::seq, raw_query, document_id);
 }
 
-bool SearchServer::IsStopWord(string_view word) const {
-    return stop_words_.count(word);
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const PreparedQuery& query,
+                                                                  int document_id) const {
+    return MatchDocument(execution::seq, query, document_id);
 }
 
-void SearchServer::WordCheckOnValid(const std::string_view word) {
-    if(!std::none_of(word.begin(), word.end(), [](char c) {
-        return c >= '\0' && c < ' ';
-    })) {
-        throw std::invalid_argument("Invalid symbol!");
+MatchedDocuments SearchServer::MatchDocuments(string_view raw_query, const vector<int>& document_ids) const {
+    return MatchDocuments(execution::seq, raw_query, document_ids);
+}
+
+MatchedDocuments SearchServer::MatchDocuments(const PreparedQuery& query, const vector<int>& document_ids) const {
+    return MatchDocuments(execution::seq, query, document_ids);
+}
+
+void SearchServer::SaveSnapshot(const std::string& path) const {
+    SnapshotWriter writer;
+    writer.WriteStrings(vector<string_view>(stop_words_.begin(), stop_words_.end()));
+
+    vector<string_view> words;
+    words.reserve(terms_.size());
+    for (TermId term = 0; term < terms_.size(); ++term) {
+        words.push_back(terms_.GetWord(term));
+    }
+    writer.WriteStrings(words);
+
+    // Списки вхождений: границы списков, общие массивы id и частот
+    // и наибольшая частота каждого слова
+    vector<uint64_t> posting_offsets{0};
+    vector<int> posting_ids;
+    vector<double> posting_freqs;
+    vector<double> posting_max_freqs;
+    for (TermId term = 0; term < word_to_document_freqs_.size(); ++term) {
+        if (const PostingList* postings = word_to_document_freqs_.Find(term)) {
+            posting_ids.insert(posting_ids.end(), postings->DocumentIds(), postings->DocumentIds() + postings->size());
+            posting_freqs.insert(posting_freqs.end(), postings->TermFreqs(), postings->TermFreqs() + postings->size());
+            posting_max_freqs.push_back(postings->MaxTermFreq());
+        } else {
+            posting_max_freqs.push_back(0.0);
+        }
+        posting_offsets.push_back(posting_ids.size());
+    }
+    writer.WriteValue<uint64_t>(word_to_document_freqs_.size());
+    writer.WriteArray(posting_offsets);
+    writer.WriteArray(posting_ids);
+    writer.WriteArray(posting_freqs);
+    writer.WriteArray(posting_max_freqs);
+
+    // Документы в порядке возрастания id и их слова в том виде, в каком
+    // их хранит прямой индекс
+    vector<int> ids, ratings, statuses;
+    vector<uint64_t> term_offsets{0};
+    vector<TermFrequency> document_terms;
+    for (const auto& [document_id, data] : document_ratings_) {
+        ids.push_back(document_id);
+        ratings.push_back(data.rating);
+        statuses.push_back(static_cast<int>(data.status));
+        for (const auto& [term, freq] : GetDocumentTerms(document_id)) {
+            // Поля заполняются по отдельности, байты выравнивания остаются нулевыми
+            TermFrequency& term_freq = document_terms.emplace_back();
+            term_freq.term = term;
+            term_freq.freq = freq;
+        }
+        term_offsets.push_back(document_terms.size());
     }
+    writer.WriteValue<uint64_t>(ids.size());
+    writer.WriteArray(ids);
+    writer.WriteArray(ratings);
+    writer.WriteArray(statuses);
+    writer.WriteArray(term_offsets);
+    writer.WriteArray(document_terms);
+
+    writer.Save(path);
 }
 
-vector<string_view> SearchServer::SplitIntoWordsNoStop(const string_view text) const {
-    vector<string_view> words_no_stop;
-    auto words = SplitIntoWords(text);
-    words_no_stop.reserve(words.size());
-    for (string_view word : words) {
-        if (!IsStopWord(word)) {
-            words_no_stop.push_back(word);
+SearchServer SearchServer::LoadSnapshot(const std::string& path, bool verify) {
+    SnapshotReader reader(path);
+    SearchServer server;
+    for (string_view word : reader.ReadStrings()) {
+        server.CollectionParse(string(word));
+    }
+
+    const auto words = reader.ReadStrings();
+    if (!server.terms_.Assign(reader.Storage(), words)) {
+        throw runtime_error("corrupt snapshot"s);
+    }
+
+    // Границы массивов и порядок id документов проверяются всегда: от них
+    // зависит, что сервер не обратится за пределы снимка. Остальное
+    // содержимое защищено контрольной суммой и проверяется только с verify
+    const auto check_offsets = [](const uint64_t* offsets, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (offsets[i] > offsets[i + 1]) {
+                throw runtime_error("corrupt snapshot"s);
+            }
+        }
+    };
+
+    const auto term_count = reader.ReadValue<uint64_t>();
+    if (term_count > words.size()) {
+        throw runtime_error("corrupt snapshot"s);
+    }
+    const uint64_t* posting_offsets = reader.ReadArray<uint64_t>(term_count + 1);
+    check_offsets(posting_offsets, term_count);
+    const int* posting_ids = reader.ReadArray<int>(posting_offsets[term_count]);
+    const double* posting_freqs = reader.ReadArray<double>(posting_offsets[term_count]);
+    const double* posting_max_freqs = reader.ReadArray<double>(term_count);
+
+    const auto document_count = reader.ReadValue<uint64_t>();
+    const int* ids = reader.ReadArray<int>(document_count);
+    const int* ratings = reader.ReadArray<int>(document_count);
+    const int* statuses = reader.ReadArray<int>(document_count);
+    const uint64_t* term_offsets = reader.ReadArray<uint64_t>(document_count + 1);
+    check_offsets(term_offsets, document_count);
+    const TermFrequency* document_terms = reader.ReadArray<TermFrequency>(term_offsets[document_count]);
+    if (!reader.AtEnd()) {
+        throw runtime_error("corrupt snapshot"s);
+    }
+
+    for (size_t i = 0; i < document_count; ++i) {
+        if (ids[i] < 0 || (i > 0 && ids[i] <= ids[i - 1])
+            || statuses[i] < DocumentStatus::ACTUAL || statuses[i] > DocumentStatus::REMOVED) {
+            throw runtime_error("corrupt snapshot"s);
         }
     }
-    return words_no_stop;
+
+    if (verify) {
+        // Слова каждого документа строго возрастают. Прямой индекс
+        // обходится по возрастанию id документов, и каждый его элемент
+        // должен быть очередным вхождением своего слова с той же частотой.
+        // Если после обхода все списки вхождений пройдены до конца, их id
+        // строго возрастают и принадлежат документам снимка
+        vector<uint64_t> posting_cursors(posting_offsets, posting_offsets + term_count);
+        for (size_t i = 0; i < document_count; ++i) {
+            for (uint64_t pos = term_offsets[i]; pos < term_offsets[i + 1]; ++pos) {
+                const auto [term, freq] = document_terms[pos];
+                if (term >= term_count || (pos > term_offsets[i] && term <= document_terms[pos - 1].term)) {
+                    throw runtime_error("corrupt snapshot"s);
+                }
+                const uint64_t posting = posting_cursors[term]++;
+                if (posting == posting_offsets[term + 1] || posting_ids[posting] != ids[i]
+                    || posting_freqs[posting] != freq) {
+                    throw runtime_error("corrupt snapshot"s);
+                }
+            }
+        }
+        for (TermId term = 0; term < term_count; ++term) {
+            const uint64_t first = posting_offsets[term];
+            const uint64_t last = posting_offsets[term + 1];
+            if (posting_cursors[term] != last
+                || posting_max_freqs[term] != (first == last ? 0.0 : *max_element(posting_freqs + first, posting_freqs + last))) {
+                throw runtime_error("corrupt snapshot"s);
+            }
+        }
+    }
+
+    // Списки вхождений и слова документов ссылаются на отображенный файл,
+    // который сервер удерживает, пока существуют его копии
+    server.snapshot_storage_ = reader.Storage();
+    server.word_to_document_freqs_.Resize(term_count);
+    for (TermId term = 0; term < term_count; ++term) {
+        const uint64_t first = posting_offsets[term];
+        if (posting_offsets[term + 1] > first) {
+            server.word_to_document_freqs_[term] = PostingList(posting_ids + first, posting_freqs + first,
+                                                               posting_offsets[term + 1] - first,
+                                                               posting_max_freqs[term]);
+        }
+    }
+    for (size_t i = 0; i < document_count; ++i) {
+        server.word_to_document_freqs_id_key_.emplace_hint(
+                    server.word_to_document_freqs_id_key_.end(), ids[i],
+                    DocumentTerms(document_terms + term_offsets[i], term_offsets[i + 1] - term_offsets[i]));
+        server.document_ratings_.emplace_hint(server.document_ratings_.end(), ids[i],
+                                              DocumentData{ratings[i], static_cast<DocumentStatus>(statuses[i])});
+        server.document_ids_.emplace_hint(server.document_ids_.end(), ids[i]);
+    }
+    server.word_to_document_freqs_.SetDocumentCount(document_count);
+    return server;
+}
+
+bool SearchServer::IsStopWord(string_view word) const {
+    return stop_words_.count(word);
+}
+
+void SearchServer::WordCheckOnValid(const std::string_view word) {
+    if (ContainsControlChars(word)) {
+        throw std::invalid_argument("Invalid symbol!");
+    }
 }
 
 int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
@@ -146,23 +487,70 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
             throw invalid_argument("double minus"s);
         }
     }
-    // Проверка на наличие недопустимых символов
-    WordCheckOnValid(text);
+    // Недопустимые символы проверяются при разбиении запроса на слова
     return QueryWord(text, is_minus, IsStopWord(text));
 }
 
-SearchServer::Query SearchServer::ParseQuery(const string_view text) const {
-    const auto words = SplitIntoWords(text);
+SearchServer::Query SearchServer::ParseQuery(const string_view text, bool keep_unknown_words) const {
+    QueryStageTimer parse_timer(QueryStatsTrace::Active(), QueryStage::PARSE);
+    thread_local vector<string_view> words;
+    // Проверка на наличие недопустимых символов
+    if (!SplitIntoWords(text, words)) {
+        throw invalid_argument("Invalid symbol!"s);
+    }
     Query query;
     for (const string_view word : words) {
         const auto query_word = ParseQueryWord(word);
         if (!query_word.is_stop) {
+            const TermId term = terms_.Find(query_word.data);
+            if (term == TermDictionary::NO_TERM) {
+                if (keep_unknown_words) {
+                    query.unknown_words_.push_back({string(query_word.data), query_word.is_minus});
+                }
+                continue;
+            }
             if (query_word.is_minus) {
-                query.minus_words.insert(query_word.data);
+                query.minus_terms_.push_back(term);
             } else {
-                query.plus_words.insert(query_word.data);
+                query.plus_terms_.push_back(term);
             }
         }
     }
+
+    for (auto* terms : {&query.plus_terms_, &query.minus_terms_}) {
+        sort(terms->begin(), terms->end());
+        terms->erase(unique(terms->begin(), terms->end()), terms->end());
+    }
     return query;
 }
+
+// Id слов не меняются, пока не сменился идентификатор словаря, поэтому
+// подготовленный запрос устаревает только при появлении в словаре новых
+// слов, часть из которых может оказаться неизвестными ранее словами запроса.
+// Текст разбирается заново только для запроса другого словаря
+const SearchServer::Query& SearchServer::ResolvePreparedQuery(const PreparedQuery& query, Query& reparsed) const {
+    if (query.dictionary_token_ != dictionary_token_.value) {
+        reparsed = ParseQuery(query.text_);
+        return reparsed;
+    }
+    if (query.unknown_words_.empty() || query.term_count_ == terms_.size()) {
+        return query;
+    }
+    reparsed.plus_terms_ = query.plus_terms_;
+    reparsed.minus_terms_ = query.minus_terms_;
+    AddFoundUnknownWords(query, reparsed);
+    return reparsed;
+}
+
+void SearchServer::AddFoundUnknownWords(const PreparedQuery& query, Query& resolved) const {
+    for (const PreparedQuery::UnknownWord& unknown : query.unknown_words_) {
+        const TermId term = terms_.Find(unknown.word);
+        if (term != TermDictionary::NO_TERM) {
+            (unknown.is_minus ? resolved.minus_terms_ : resolved.plus_terms_).push_back(term);
+        }
+    }
+    for (auto* terms : {&resolved.plus_terms_, &resolved.minus_terms_}) {
+        sort(terms->begin(), terms->end());
+        terms->erase(unique(terms->begin(), terms->end()), terms->end());
+    }
+}
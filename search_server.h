@@ -1,23 +1,51 @@
 #pragma once
 
 #include "document.h"
-#include "Lib/concurrent_map.h"
+#include "document_store.h"
+#include "inverted_index.h"
+#include "matched_documents.h"
+#include "metrics.h"
+#include "prepared_query.h"
+#include "query_cache.h"
+#include "query_stats.h"
+#include "relevance_accumulator.h"
+#include "term_dictionary.h"
+#include "Lib/top_k_heap.h"
+#include "Lib/work_stealing_pool.h"
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <exception>
 #include <execution>
+#include <limits>
 #include <map>
+#include <memory>
 #include <numeric>
 #include <set>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <type_traits>
 #include <vector>
 #include <iterator>
 
-#define N_BUCKETS 100
+// Способ отбора наиболее релевантных документов
+enum class RetrievalMode {
+    EXHAUSTIVE, // вычисляется релевантность всех найденных документов
+    PRUNED      // пропускаются документы, которые не могут попасть в top_k
+};
 
+// Константные методы можно вызывать из нескольких потоков одновременно,
+// изменяющие методы - только когда поиск не выполняется. Добавлять документы
+// во время поиска можно в VersionedSearchServer, хранящий две копии сервера,
+// или в SegmentedIndex
 class SearchServer {
 public:
+    // Количество документов, выводимых во время поиска по умолчанию
+    static constexpr size_t MAX_RESULT_DOCUMENT_COUNT = 5;
+
     /// Конструкторы класса
     SearchServer() = default;
 
@@ -27,38 +55,116 @@ public:
     template <typename StringCollection>
     explicit SearchServer(const StringCollection& collection);
 
-    // Добавление документа на сервер
-    template<typename Str>
-    void AddDocument(const int document_id, const Str& document,
-                     DocumentStatus status, const std::vector<int>& ratings);
+    // Добавление документа на сервер. Текст документа копируется в хранилище сервера
     void AddDocument(const int document_id, std::string_view document,
                      DocumentStatus status, const std::vector<int>& ratings);
+    // Добавление набора документов. Элементы набора - кортежи или структуры
+    // (id, текст, статус, рейтинги). Разбор текстов и построение списков
+    // вхождений выполняются параллельно при параллельной политике.
+    // При недопустимом id или слове исключение выбрасывается до изменения сервера
+    template <typename DocumentRange>
+    void AddDocuments(const DocumentRange& documents);
+    template <typename ExPol, typename DocumentRange>
+    void AddDocuments(ExPol&& ex_po, const DocumentRange& documents);
 
-    // Поиск наиболее релевантных документов
+    // Поиск top_k наиболее релевантных документов. Кроме стандартных политик
+    // принимается WorkStealingPool::Policy: части поиска выполняются в пуле.
+    // FindTopDocuments, MatchDocument и RemoveDocument записывают длительность
+    // этапов и счетчики в QueryStatsTrace::Active(), см. query_stats.h.
+    // Длительность вызовов открытых методов записывается в гистограммы metrics.h
     template <typename StatusFilter>
     std::vector<Document> FindTopDocuments(std::string_view raw_query,
-                                           StatusFilter status) const;
+                                           StatusFilter status,
+                                           size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
     std::vector<Document> FindTopDocuments(std::string_view raw_query,
-                          const DocumentStatus document_status = DocumentStatus::ACTUAL) const;
+                          const DocumentStatus document_status = DocumentStatus::ACTUAL,
+                          size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
     template <typename ExPol, typename StatusFilter>
     std::vector<Document> FindTopDocuments(ExPol&& ex_po, std::string_view raw_query,
-                                           StatusFilter status) const;
+                                           StatusFilter status,
+                                           size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
     template <typename ExPol>
     std::vector<Document> FindTopDocuments(ExPol&& ex_po,std::string_view raw_query,
-                          const DocumentStatus document_status = DocumentStatus::ACTUAL) const;
+                          const DocumentStatus document_status = DocumentStatus::ACTUAL,
+                          size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Разбор запроса для многократного выполнения. Ошибки в запросе
+    // обнаруживаются здесь, как при разборе в FindTopDocuments
+    PreparedQuery PrepareQuery(std::string_view raw_query) const;
+    // Обновление запроса после роста словаря: неизвестные при подготовке слова,
+    // появившиеся в словаре, переходят в id слов запроса. Запрос другого
+    // сервера подготавливается заново
+    void RefreshPreparedQuery(PreparedQuery& query) const;
+
+    // Поиск по подготовленному запросу, без разбора текста
+    template <typename StatusFilter>
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query,
+                                           StatusFilter status,
+                                           size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(const PreparedQuery& query,
+                          const DocumentStatus document_status = DocumentStatus::ACTUAL,
+                          size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <typename ExPol, typename StatusFilter>
+    std::vector<Document> FindTopDocuments(ExPol&& ex_po, const PreparedQuery& query,
+                                           StatusFilter status,
+                                           size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <typename ExPol>
+    std::vector<Document> FindTopDocuments(ExPol&& ex_po, const PreparedQuery& query,
+                          const DocumentStatus document_status = DocumentStatus::ACTUAL,
+                          size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Оценка стоимости поиска по запросу: суммарная длина списков вхождений плюс-слов
+    size_t EstimateQueryCost(std::string_view raw_query) const;
+    size_t EstimateQueryCost(const PreparedQuery& query) const;
+
+    // Кэш результатов поиска с отбором по статусу документов. Записи становятся
+    // недействительными при добавлении и удалении документов. Копии сервера
+    // разделяют кэш, пока не изменены
+    void EnableQueryCache(size_t capacity);
+    void DisableQueryCache();
+    QueryCacheStats GetQueryCacheStats() const;
+
+    // Способ отбора документов в FindTopDocuments, по умолчанию EXHAUSTIVE.
+    // Оба способа возвращают одинаковый результат
+    void SetRetrievalMode(RetrievalMode mode) noexcept;
+    RetrievalMode GetRetrievalMode() const noexcept;
 
     // Количество документов на сервере
     int GetDocumentCount() const;
     // Итераторы указывающие на первый и на последний id документов на сервере соответственно
     std::set<int>::iterator begin() noexcept;
     std::set<int>::iterator end() noexcept;
+    std::set<int>::const_iterator begin() const noexcept;
+    std::set<int>::const_iterator end() const noexcept;
+
+    // Текст документа, действительный до его удаления. Пустая строка,
+    // если документа нет или сервер загружен из снимка
+    std::string_view GetDocumentText(int document_id) const;
+    // Освобождение памяти, занятой текстами удаленных документов
+    void CompactDocumentTexts();
+    // Удаление из словаря слов, не встречающихся ни в одном документе, и их
+    // пустых списков вхождений. Без этого словарь только растет при добавлении
+    // и удалении документов. Id остальных слов меняются: подготовленные запросы
+    // разбираются заново, слова, ранее полученные из MatchDocument, MatchDocuments
+    // и GetWordFrequencies, становятся недействительными
+    void CompactTerms();
 
     // Возврат частоты слов в документе
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
+    // Слова документа в виде id словаря, отсортированные по id
+    const DocumentTerms& GetDocumentTerms(int document_id) const;
+    // Статистика слова по всем документам сервера (IDF, количество документов)
+    TermStatistics GetTermStatistics(std::string_view word) const;
     // Удаление документа
     void RemoveDocument(int document_id);
     template<class ExPol>
     void RemoveDocument(ExPol&& ex_po, int document_id);
+    // Удаление набора документов: вхождения группируются по словам, и каждый
+    // список вхождений переписывается один раз. При параллельной политике
+    // слова делятся между потоками. Отсутствующие id пропускаются
+    void RemoveDocuments(const std::vector<int>& document_ids);
+    template<class ExPol>
+    void RemoveDocuments(ExPol&& ex_po, const std::vector<int>& document_ids);
 
     // Матчинг документов
     std::tuple<std::vector<std::string_view>, DocumentStatus>
@@ -66,20 +172,49 @@ public:
     template <typename ExPol>
     std::tuple<std::vector<std::string_view>, DocumentStatus>
     MatchDocument(ExPol&& ex_po, const std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus>
+    MatchDocument(const PreparedQuery& query, int document_id) const;
+    template <typename ExPol>
+    std::tuple<std::vector<std::string_view>, DocumentStatus>
+    MatchDocument(ExPol&& ex_po, const PreparedQuery& query, int document_id) const;
 
-private:
-    // Максимальное количество документов, выводимых во время поиска
-    const int MAX_RESULT_DOCUMENT_COUNT = 5;
+    // Матчинг набора документов: запрос разбирается один раз, документы
+    // обрабатываются частями параллельно при параллельной политике, найденные
+    // слова всех документов записываются в один буфер. При отсутствии
+    // документа std::out_of_range выбрасывается до начала матчинга
+    MatchedDocuments MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const;
+    MatchedDocuments MatchDocuments(const PreparedQuery& query, const std::vector<int>& document_ids) const;
+    template <typename ExPol>
+    MatchedDocuments MatchDocuments(ExPol&& ex_po, std::string_view raw_query,
+                                    const std::vector<int>& document_ids) const;
+    template <typename ExPol>
+    MatchedDocuments MatchDocuments(ExPol&& ex_po, const PreparedQuery& query,
+                                    const std::vector<int>& document_ids) const;
 
+    // Сохранение индекса в двоичный снимок: стоп-слова, словарь, списки вхождений,
+    // прямой индекс, рейтинги и статусы документов. Тексты документов
+    // в снимок не входят
+    void SaveSnapshot(const std::string& path) const;
+    // Сервер, восстановленный из снимка без повторного разбора текстов.
+    // Текст слов, списки вхождений и прямой индекс обслуживаются прямо из
+    // отображенного в память файла, список вхождений или слова документа
+    // копируются при первом изменении. Загрузка занимает время, линейное
+    // по количеству слов и документов. Данные защищены контрольной суммой,
+    // verify дополнительно проверяет соответствие списков вхождений прямому
+    // индексу за время, линейное по размеру индекса. При поврежденном или
+    // несовместимом снимке выбрасывается std::runtime_error
+    static SearchServer LoadSnapshot(const std::string& path, bool verify = false);
+
+private:
     /// Контейнеры для хранения необработанных строковых данных
     std::set<std::string> stop_words_str_collect_;
-    std::map<int, std::string> originals_documents_;
+    DocumentStore document_texts_;
 
     /// Основные рабочие контейнеры для хранения обработанных данных
-    using MapKeyStrView     = std::map<std::string_view, std::map<int, double>>;
-    using MapKeyInt         = std::map<int, std::map<std::string_view, double>>;
+    using MapKeyInt         = std::map<int, DocumentTerms>;
     std::set<std::string_view> stop_words_;
-    MapKeyStrView word_to_document_freqs_;
+    TermDictionary terms_;
+    InvertedIndex word_to_document_freqs_;
     MapKeyInt word_to_document_freqs_id_key_;
     struct DocumentData {
         int rating;
@@ -87,8 +222,34 @@ private:
     };
     std::map<int, DocumentData> document_ratings_;
     std::set<int> document_ids_;
+    // Данные снимка, на которые ссылаются списки вхождений и прямой индекс
+    // загруженного сервера
+    std::shared_ptr<char[]> snapshot_storage_;
+    RetrievalMode retrieval_mode_ = RetrievalMode::EXHAUSTIVE;
+    // Поколение индекса меняется при каждом изменении документов. Номера
+    // поколений не повторяются среди всех серверов, поэтому запись кэша,
+    // созданная копией сервера, не подходит измененному оригиналу
+    uint64_t generation_ = NextGeneration();
+    std::shared_ptr<QueryCache> query_cache_;
+
+    // Идентификатор словаря, которым помечаются подготовленные запросы.
+    // Сервер, созданный копированием или перемещением, и сервер, которому
+    // присвоен другой, получают новый идентификатор, поэтому id слов
+    // из запросов, подготовленных по прежнему словарю, не используются
+    struct DictionaryToken {
+        DictionaryToken() noexcept = default;
+        DictionaryToken(const DictionaryToken&) noexcept {}
+        DictionaryToken& operator=(const DictionaryToken&) noexcept {
+            value = NextGeneration();
+            return *this;
+        }
+
+        uint64_t value = NextGeneration();
+    };
+    DictionaryToken dictionary_token_;
 
     // Приватные методы класса
+    static uint64_t NextGeneration() noexcept;
     void StringViewConstructor(std::string_view in_str);
     void CollectionParse(const std::string& in_str);
     void CollectionParse(const std::string_view in_str);
@@ -100,7 +261,8 @@ private:
     bool IsStopWord(std::string_view word) const;
     static void WordCheckOnValid(const std::string_view word);
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view text) const;
+    std::vector<std::pair<std::string_view, double>> ParseDocument(const std::string_view document) const;
+    static void SortDocumentTerms(std::vector<TermFrequency>& document_terms);
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
     struct QueryWord {
@@ -116,19 +278,80 @@ private:
 
     QueryWord ParseQueryWord(std::string_view text) const;
 
-    struct Query {
-        std::set<std::string_view> plus_words;
-        std::set<std::string_view> minus_words;
+    // Слова запроса в виде отсортированных id словаря,
+    // слова отсутствующие в словаре в запрос не попадают
+    using Query = PreparedQuery;
+
+    // Слова, отсутствующие в словаре, сохраняются при keep_unknown_words
+    Query ParseQuery(const std::string_view text, bool keep_unknown_words = false) const;
+    // Подготовленный запрос, если он действителен для сервера, иначе запрос,
+    // дополненный появившимися в словаре словами или разобранный заново в reparsed
+    const Query& ResolvePreparedQuery(const PreparedQuery& query, Query& reparsed) const;
+    // Id неизвестных при подготовке слов query, найденные в словаре,
+    // добавляются к словам resolved
+    void AddFoundUnknownWords(const PreparedQuery& query, Query& resolved) const;
+
+    using TopDocumentsHeap = TopKHeap<Document, MoreRelevant>;
+
+    template <typename ExPol>
+    static std::vector<Document> SelectTopDocuments(ExPol&& ex_po,
+                                                    const std::vector<Document>& documents,
+                                                    size_t top_k);
+
+    // Диапазон id документов [first, last], обрабатываемый одной задачей поиска
+    struct DocumentIdRange {
+        int first;
+        int last;
     };
 
-    Query ParseQuery(const std::string_view text) const;
+    // Минимальное число вхождений на одну задачу параллельного поиска
+    static constexpr size_t MIN_POSTINGS_PER_PART = 2048;
 
-    template <typename StatusFilter>
-    std::vector<Document> FindAllDocuments(const Query& query, StatusFilter status) const;
+    // Количество потоков, между которыми политика делит работу
+    template <typename ExPol>
+    static size_t GetConcurrency(const ExPol& ex_po);
+    // Вызов func(part) для каждой части из [0, part_count)
+    template <typename ExPol, typename Func>
+    static void ForEachPart(ExPol&& ex_po, size_t part_count, Func func);
+
+    template <typename ExPol>
+    std::vector<DocumentIdRange> SplitDocumentIds(const ExPol& ex_po, const Query& query) const;
+    // Участок списка вхождений слова, попадающий в диапазон id
+    PostingRun MakePostingRun(TermId term, DocumentIdRange range) const;
+    size_t CountPlusPostings(const Query& query) const;
+
+    template <typename ExPol, typename StatusFilter>
+    std::vector<Document> FindTopDocumentsParsed(ExPol&& ex_po, const Query& query,
+                                                 StatusFilter status, size_t top_k) const;
+    // Поиск с отбором по статусу через кэш результатов, если он включен
+    template <typename ExPol>
+    std::vector<Document> FindTopDocumentsByStatus(ExPol&& ex_po, const Query& query,
+                                                   DocumentStatus document_status, size_t top_k) const;
+    template <typename ExPol>
+    std::tuple<std::vector<std::string_view>, DocumentStatus>
+    MatchDocumentParsed(ExPol&& ex_po, const Query& query, int document_id) const;
+    // Документов на одну задачу параллельного матчинга набора
+    static constexpr size_t MIN_DOCUMENTS_PER_MATCH_PART = 64;
+    template <typename ExPol>
+    MatchedDocuments MatchDocumentsParsed(ExPol&& ex_po, const Query& query,
+                                          const std::vector<int>& document_ids) const;
     template <typename ExPol, typename StatusFilter>
     std::vector<Document> FindAllDocuments(ExPol&& ex_po, const Query& query, StatusFilter status) const;
-    template <typename ExPol, typename StatusFilter, typename Container>
-    void FindAllDocumentsImpl(ExPol&& ex_po, const Query& query, StatusFilter status, Container& document_to_relevance) const;
+    template <typename StatusFilter>
+    void FindAllDocumentsImpl(const Query& query, StatusFilter status, DocumentIdRange range,
+                              std::vector<Document>& matched_documents, QueryStats* stats) const;
+
+    template <typename ExPol, typename StatusFilter>
+    std::vector<Document> FindTopDocumentsPruned(ExPol&& ex_po, const Query& query,
+                                                 StatusFilter status, size_t top_k) const;
+    template <typename StatusFilter>
+    void FindTopDocumentsPrunedImpl(const Query& query, StatusFilter status, DocumentIdRange range,
+                                    TopDocumentsHeap& top_documents, QueryStats* stats) const;
+    // Статистика частей запроса, выполняемых в разных потоках: по отдельной
+    // записи на часть, если статистика собирается, иначе пустой вектор
+    static std::vector<QueryStats> MakePartStats(QueryStats* stats, size_t part_count);
+    static QueryStats* GetPartStats(std::vector<QueryStats>& part_stats, size_t part);
+    static void MergePartStats(QueryStats* stats, const std::vector<QueryStats>& part_stats);
 };
 
 // Конструктор класса SearchServer
@@ -142,203 +365,834 @@ SearchServer::SearchServer(const StringCollection& collection) {
     }
 }
 
-template <typename Str>
-void SearchServer::AddDocument(const int document_id,
-                               const Str& document,
-                               const DocumentStatus status,
-                               const std::vector<int>& ratings) {
-    CheckId(document_id);
-    auto& ref_original_doc = originals_documents_[document_id];
-    ref_original_doc = document;
-    AddDocumentWithoutCheckId(document_id,
-                              std::string_view{ref_original_doc},
-                              status,
-                              ratings);
+template <typename DocumentRange>
+void SearchServer::AddDocuments(const DocumentRange& documents) {
+    AddDocuments(std::execution::seq, documents);
 }
 
-template <typename ExPol,typename StatusFilter>
-std::vector<Document> SearchServer::FindTopDocuments(ExPol&& ex_po, const std::string_view raw_query,
-                                       StatusFilter status) const {
+template <typename ExPol, typename DocumentRange>
+void SearchServer::AddDocuments(ExPol&& ex_po, const DocumentRange& documents) {
+    OperationTimer timer(Operation::ADD_DOCUMENTS);
+    struct ParsedDocument {
+        int id;
+        std::string_view text;
+        DocumentStatus status;
+        const std::vector<int>* ratings;
+        std::vector<std::pair<std::string_view, double>> word_freqs;
+        std::vector<TermFrequency> terms;
+        std::exception_ptr error;
+    };
+
+    // Проверка id, в том числе повторов внутри набора
+    std::vector<ParsedDocument> parsed_documents;
+    for (const auto& [document_id, document, status, ratings] : documents) {
+        CheckId(document_id);
+        parsed_documents.push_back({document_id, std::string_view{document}, status, &ratings, {}, {}, nullptr});
+    }
+    timer.SetItems(parsed_documents.size());
+    std::sort(parsed_documents.begin(), parsed_documents.end(),
+              [](const ParsedDocument& lhs, const ParsedDocument& rhs) {
+        return lhs.id < rhs.id;
+    });
+    for (size_t i = 1; i < parsed_documents.size(); ++i) {
+        if (parsed_documents[i - 1].id == parsed_documents[i].id) {
+            throw std::invalid_argument("invalid id");
+        }
+    }
 
-    Query query = ParseQuery(raw_query);
+    // Разбор текстов. Исключения из параллельного алгоритма не выпускаются,
+    // а сохраняются и выбрасываются после разбора всех документов
+    std::for_each(ex_po,
+                  parsed_documents.begin(), parsed_documents.end(),
+                  [this](ParsedDocument& document) {
+        try {
+            document.word_freqs = ParseDocument(document.text);
+        } catch (...) {
+            document.error = std::current_exception();
+        }
+    });
+    for (const ParsedDocument& document : parsed_documents) {
+        if (document.error) {
+            std::rethrow_exception(document.error);
+        }
+    }
 
-    std::vector<Document> matched_documents = FindAllDocuments(ex_po, query, status);
-    sort(ex_po, matched_documents.begin(), matched_documents.end(),
-         [](const Document& lhs, const Document& rhs) {
-        const double about_zero = 1e-6;
-        if (std::abs(lhs.relevance - rhs.relevance) < about_zero){
-            return lhs.rating > rhs.rating;
-        } else {
-            return lhs.relevance > rhs.relevance;
+    // Присвоение id словам выполняется одним проходом по всем документам
+    for (ParsedDocument& document : parsed_documents) {
+        document.terms.reserve(document.word_freqs.size());
+        for (const auto& [word, term_freq] : document.word_freqs) {
+            document.terms.push_back({terms_.Intern(word), term_freq});
         }
+    }
+    std::for_each(ex_po,
+                  parsed_documents.begin(), parsed_documents.end(),
+                  [](ParsedDocument& document) {
+        SortDocumentTerms(document.terms);
     });
 
-    if (static_cast<int>(matched_documents.size()) > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    // Новые вхождения группируются по словам: вхождения слова term занимают
+    // [offsets[term], offsets[term + 1]) и упорядочены по id документа
+    std::vector<size_t> offsets(terms_.size() + 1, 0);
+    for (const ParsedDocument& document : parsed_documents) {
+        for (const TermFrequency& term_freq : document.terms) {
+            ++offsets[term_freq.term + 1];
+        }
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<int> posting_ids(offsets.back());
+    std::vector<double> posting_freqs(offsets.back());
+    std::vector<size_t> positions(offsets.begin(), offsets.end() - 1);
+    for (const ParsedDocument& document : parsed_documents) {
+        for (const auto& [term, term_freq] : document.terms) {
+            const size_t pos = positions[term]++;
+            posting_ids[pos] = document.id;
+            posting_freqs[pos] = term_freq;
+        }
     }
 
-    return matched_documents;
+    std::vector<TermId> new_terms;
+    for (TermId term = 0; term < terms_.size(); ++term) {
+        if (offsets[term + 1] > offsets[term]) {
+            new_terms.push_back(term);
+        }
+    }
+    // Каждый список вхождений объединяется с новыми вхождениями один раз,
+    // списки разных слов не пересекаются и обрабатываются независимо
+    word_to_document_freqs_.Resize(terms_.size());
+    std::for_each(ex_po,
+                  new_terms.begin(), new_terms.end(),
+                  [this, &offsets, &posting_ids, &posting_freqs](TermId term) {
+        word_to_document_freqs_[term].Merge(posting_ids.data() + offsets[term],
+                                            posting_freqs.data() + offsets[term],
+                                            offsets[term + 1] - offsets[term]);
+    });
+
+    for (ParsedDocument& document : parsed_documents) {
+        document.terms.shrink_to_fit();
+        word_to_document_freqs_id_key_.emplace(document.id, DocumentTerms(std::move(document.terms)));
+        document_ratings_[document.id] = {ComputeAverageRating(*document.ratings), document.status};
+        document_ids_.insert(document.id);
+        document_texts_.Add(document.id, document.text);
+    }
+    word_to_document_freqs_.SetDocumentCount(document_ratings_.size());
+    generation_ = NextGeneration();
+}
+
+template <typename ExPol,typename StatusFilter>
+std::vector<Document> SearchServer::FindTopDocuments(ExPol&& ex_po, const std::string_view raw_query,
+                                       StatusFilter status, size_t top_k) const {
+    OperationTimer timer(Operation::FIND_TOP_DOCUMENTS);
+    return FindTopDocumentsParsed(ex_po, ParseQuery(raw_query), status, top_k);
+}
+
+template <typename ExPol, typename StatusFilter>
+std::vector<Document> SearchServer::FindTopDocumentsParsed(ExPol&& ex_po, const Query& query,
+                                                           StatusFilter status, size_t top_k) const {
+    QueryStats* const stats = QueryStatsTrace::Active();
+    AddQueryStat(stats, &QueryStats::query_count, 1);
+    if (top_k == 0) {
+        return {};
+    }
+
+    std::vector<Document> result;
+    if (retrieval_mode_ == RetrievalMode::PRUNED) {
+        result = FindTopDocumentsPruned(ex_po, query, status, top_k);
+    } else {
+        std::vector<Document> matched_documents = FindAllDocuments(ex_po, query, status);
+        QueryStageTimer selection_timer(stats, QueryStage::SELECTION);
+        result = SelectTopDocuments(ex_po, matched_documents, top_k);
+    }
+    AddQueryStat(stats, &QueryStats::results, result.size());
+    return result;
+}
+
+template <typename ExPol, typename StatusFilter>
+std::vector<Document> SearchServer::FindTopDocuments(ExPol&& ex_po, const PreparedQuery& query,
+                                                     StatusFilter status, size_t top_k) const {
+    OperationTimer timer(Operation::FIND_TOP_DOCUMENTS);
+    Query reparsed;
+    return FindTopDocumentsParsed(ex_po, ResolvePreparedQuery(query, reparsed), status, top_k);
 }
 
 template <typename ExPol>
 std::vector<Document> SearchServer::FindTopDocuments(ExPol&& ex_po, const std::string_view raw_query,
-                                                const DocumentStatus document_status) const {
-    return FindTopDocuments(ex_po, raw_query,
-           [document_status]([[maybe_unused]] int document_id,
-                             [[maybe_unused]] DocumentStatus status,
-                             [[maybe_unused]] int rating) {
-                             return status == document_status;
-                        });
+                                                const DocumentStatus document_status,
+                                                size_t top_k) const {
+    OperationTimer timer(Operation::FIND_TOP_DOCUMENTS);
+    return FindTopDocumentsByStatus(ex_po, ParseQuery(raw_query), document_status, top_k);
+}
+
+template <typename ExPol>
+std::vector<Document> SearchServer::FindTopDocuments(ExPol&& ex_po, const PreparedQuery& query,
+                                                     const DocumentStatus document_status,
+                                                     size_t top_k) const {
+    OperationTimer timer(Operation::FIND_TOP_DOCUMENTS);
+    Query reparsed;
+    return FindTopDocumentsByStatus(ex_po, ResolvePreparedQuery(query, reparsed), document_status, top_k);
+}
+
+template <typename ExPol>
+std::vector<Document> SearchServer::FindTopDocumentsByStatus(ExPol&& ex_po, const Query& query,
+                                                             DocumentStatus document_status,
+                                                             size_t top_k) const {
+    const auto status_filter = [document_status]([[maybe_unused]] int document_id,
+                                                 [[maybe_unused]] DocumentStatus status,
+                                                 [[maybe_unused]] int rating) {
+        return status == document_status;
+    };
+    if (!query_cache_) {
+        return FindTopDocumentsParsed(ex_po, query, status_filter, top_k);
+    }
+
+    QueryCacheKey key{{query.plus_terms_.begin(), query.plus_terms_.end()},
+                      {query.minus_terms_.begin(), query.minus_terms_.end()},
+                      document_status, top_k};
+    if (auto cached = query_cache_->Find(key, generation_)) {
+        QueryStats* const stats = QueryStatsTrace::Active();
+        AddQueryStat(stats, &QueryStats::query_count, 1);
+        AddQueryStat(stats, &QueryStats::results, cached->size());
+        return std::move(*cached);
+    }
+    std::vector<Document> documents = FindTopDocumentsParsed(ex_po, query, status_filter, top_k);
+    query_cache_->Insert(std::move(key), generation_, documents);
+    return documents;
 }
 
 template <typename StatusFilter>
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query,
-                                       StatusFilter status) const {
-    return FindTopDocuments(std::execution::seq, raw_query, status);
+                                       StatusFilter status, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status, top_k);
+}
+
+template <typename StatusFilter>
+std::vector<Document> SearchServer::FindTopDocuments(const PreparedQuery& query,
+                                                     StatusFilter status, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, query, status, top_k);
+}
+
+// Отбор top_k документов ограниченной кучей. В параллельной версии
+// каждая часть документов отбирается в собственную кучу, затем кучи сливаются
+template <typename ExPol>
+std::vector<Document> SearchServer::SelectTopDocuments(ExPol&& ex_po,
+                                                       const std::vector<Document>& documents,
+                                                       size_t top_k) {
+    const size_t min_part_size = 1024;
+    const size_t part_count = std::min(GetConcurrency(ex_po), documents.size() / min_part_size + 1);
+
+    std::vector<TopDocumentsHeap> heaps(part_count, TopDocumentsHeap(top_k));
+    const size_t part_size = documents.size() / part_count + 1;
+
+    ForEachPart(ex_po, part_count, [&documents, &heaps, part_size](size_t part) {
+        const size_t first = std::min(part * part_size, documents.size());
+        const size_t last = std::min(first + part_size, documents.size());
+        for (size_t i = first; i < last; ++i) {
+            heaps[part].Push(documents[i]);
+        }
+    });
+
+    for (size_t part = 1; part < part_count; ++part) {
+        heaps.front().Merge(std::move(heaps[part]));
+    }
+    return heaps.front().TakeSorted();
 }
 
 template<class ExPol>
 void SearchServer::RemoveDocument(ExPol&& ex_po, int document_id) {
+    OperationTimer timer(Operation::REMOVE_DOCUMENT);
     auto it_doc_id = document_ids_.find(document_id);
     // Проверка наличия документа
     if (it_doc_id == document_ids_.end()) {
         return;
     }
+    QueryStats* const stats = QueryStatsTrace::Active();
+    QueryStageTimer remove_timer(stats, QueryStage::REMOVE);
+    AddQueryStat(stats, &QueryStats::query_count, 1);
 
     document_ids_.erase(it_doc_id);       // Удаление из вектора id
     document_ratings_.erase(document_id);   // Удаление из documents ratings
+    document_texts_.Remove(document_id);
+    word_to_document_freqs_.SetDocumentCount(document_ratings_.size());
+    generation_ = NextGeneration();
     auto it_wrd_to_doc_id = word_to_document_freqs_id_key_.find(document_id);
 
-    std::vector<const std::string_view*> words;
-    words.reserve((it_wrd_to_doc_id->second.size()));
+    std::vector<PostingList*> postings;
+    postings.reserve(it_wrd_to_doc_id->second.size());
+    for (const auto& [term, freq] : it_wrd_to_doc_id->second) {
+        postings.push_back(&word_to_document_freqs_[term]);
+    }
 
-    for_each(
+    // Удаление из word_to_document_freqs_: у каждого слова собственный
+    // список вхождений, поэтому списки можно обрабатывать независимо
+    std::for_each(
         ex_po,
-        it_wrd_to_doc_id->second.begin(),
-        it_wrd_to_doc_id->second.end(),
-        [&words](const auto& doc){
-            words.push_back(&doc.first);
+        postings.begin(), postings.end(),
+        [document_id](PostingList* postings_of_word) {
+            postings_of_word->Remove(document_id);
         }
     );
 
-    auto& wrd_to_docs = word_to_document_freqs_;
+    // Удаление из word_to_document_freqs_id_key_
+    word_to_document_freqs_id_key_.erase(document_id);
+    AddQueryStat(stats, &QueryStats::posting_lists, postings.size());
+    AddQueryStat(stats, &QueryStats::results, 1);
+}
 
-    // Удаление из word_to_document_freqs_
-    for_each(
-        ex_po,
-        words.begin(), words.end(),
-        [document_id, &wrd_to_docs](const std::string_view* wrd) {
-            wrd_to_docs.at(*wrd).erase(document_id);
+template<class ExPol>
+void SearchServer::RemoveDocuments(ExPol&& ex_po, const std::vector<int>& document_ids) {
+    OperationTimer timer(Operation::REMOVE_DOCUMENTS, 0);
+    std::vector<int> removed_ids;
+    removed_ids.reserve(document_ids.size());
+    for (const int document_id : document_ids) {
+        if (document_ids_.count(document_id)) {
+            removed_ids.push_back(document_id);
         }
-    );
+    }
+    std::sort(removed_ids.begin(), removed_ids.end());
+    removed_ids.erase(std::unique(removed_ids.begin(), removed_ids.end()), removed_ids.end());
+    timer.SetItems(removed_ids.size());
+    if (removed_ids.empty()) {
+        return;
+    }
+    QueryStats* const stats = QueryStatsTrace::Active();
+    QueryStageTimer remove_timer(stats, QueryStage::REMOVE);
+    AddQueryStat(stats, &QueryStats::query_count, 1);
 
-    // Удаление из word_to_document_freqs_id_key_
-    word_to_document_freqs_id_key_.erase(document_id);
+    // Пары (слово, документ) упорядочиваются по словам, документы
+    // каждого слова оказываются упорядоченными по id
+    std::vector<std::pair<TermId, int>> entries;
+    for (const int document_id : removed_ids) {
+        for (const auto& [term, freq] : word_to_document_freqs_id_key_.at(document_id)) {
+            entries.emplace_back(term, document_id);
+        }
+    }
+    std::sort(ex_po, entries.begin(), entries.end());
+
+    std::vector<PostingList*> postings;
+    std::vector<size_t> term_starts;
+    std::vector<int> entry_ids(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i == 0 || entries[i].first != entries[i - 1].first) {
+            postings.push_back(&word_to_document_freqs_[entries[i].first]);
+            term_starts.push_back(i);
+        }
+        entry_ids[i] = entries[i].second;
+    }
+    term_starts.push_back(entries.size());
+
+    // У каждого слова собственный список вхождений, части получают
+    // непересекающиеся диапазоны слов
+    const size_t term_count = postings.size();
+    const size_t part_count = std::min(GetConcurrency(ex_po), term_count);
+    ForEachPart(ex_po, part_count, [&](size_t part) {
+        const size_t first = term_count * part / part_count;
+        const size_t last = term_count * (part + 1) / part_count;
+        for (size_t i = first; i < last; ++i) {
+            postings[i]->Remove(entry_ids.data() + term_starts[i], term_starts[i + 1] - term_starts[i]);
+        }
+    });
+
+    for (const int document_id : removed_ids) {
+        document_ids_.erase(document_id);
+        document_ratings_.erase(document_id);
+        document_texts_.Remove(document_id);
+        word_to_document_freqs_id_key_.erase(document_id);
+    }
+    word_to_document_freqs_.SetDocumentCount(document_ratings_.size());
+    generation_ = NextGeneration();
+    AddQueryStat(stats, &QueryStats::posting_lists, term_count);
+    AddQueryStat(stats, &QueryStats::postings_scanned, entries.size());
+    AddQueryStat(stats, &QueryStats::results, removed_ids.size());
 }
 
 template <typename ExPol>
 std::tuple<std::vector<std::string_view>, DocumentStatus>
 SearchServer::MatchDocument(ExPol&& ex_po, const std::string_view raw_query, int document_id) const {
+    OperationTimer timer(Operation::MATCH_DOCUMENT);
     if (!document_ids_.count(document_id)) {
         throw std::out_of_range("Invalid document ID!");
     }
+    return MatchDocumentParsed(ex_po, ParseQuery(raw_query), document_id);
+}
 
-    const auto query = ParseQuery(raw_query);
-    std::set<std::string_view> wrd_p;
+template <typename ExPol>
+std::tuple<std::vector<std::string_view>, DocumentStatus>
+SearchServer::MatchDocument(ExPol&& ex_po, const PreparedQuery& query, int document_id) const {
+    OperationTimer timer(Operation::MATCH_DOCUMENT);
+    if (!document_ids_.count(document_id)) {
+        throw std::out_of_range("Invalid document ID!");
+    }
+    Query reparsed;
+    return MatchDocumentParsed(ex_po, ResolvePreparedQuery(query, reparsed), document_id);
+}
+
+template <typename ExPol>
+std::tuple<std::vector<std::string_view>, DocumentStatus>
+SearchServer::MatchDocumentParsed(ExPol&& ex_po, const Query& query, int document_id) const {
+    QueryStats* const stats = QueryStatsTrace::Active();
+    AddQueryStat(stats, &QueryStats::query_count, 1);
 
+    QueryStageTimer match_timer(stats, QueryStage::MATCH);
+    AddQueryStat(stats, &QueryStats::candidates, 1);
     const auto& wrd_to_doc_id = word_to_document_freqs_id_key_.at(document_id);
-    for (const std::string_view word : query.minus_words) {
-        if (wrd_to_doc_id.count(word)) {
+    for (const TermId term : query.minus_terms_) {
+        if (FindTerm(wrd_to_doc_id, term) != nullptr) {
+            AddQueryStat(stats, &QueryStats::excluded, 1);
             return std::tuple(std::vector<std::string_view>{}, document_ratings_.at(document_id).status);
         }
     }
 
-    std::for_each(
+    std::vector<TermId> matched_terms(query.plus_terms_.size());
+    auto matched_end = std::copy_if(
         ex_po,
-        query.plus_words.begin(),
-        query.plus_words.end(),
-        [&wrd_p, &wrd_to_doc_id, document_id](const std::string_view word){
-            auto it = wrd_to_doc_id.find(word);
-            if (it != wrd_to_doc_id.end()) {
-                wrd_p.insert(it->first);
-            }
+        query.plus_terms_.begin(),
+        query.plus_terms_.end(),
+        matched_terms.begin(),
+        [&wrd_to_doc_id](const TermId term){
+            return FindTerm(wrd_to_doc_id, term) != nullptr;
         }
     );
 
+    // Слова возвращаются в лексикографическом порядке
     std::vector<std::string_view> temp;
-    for (const std::string_view wrd : wrd_p) {
-        temp.push_back(wrd);
+    temp.reserve(std::distance(matched_terms.begin(), matched_end));
+    for (auto it = matched_terms.begin(); it != matched_end; ++it) {
+        temp.push_back(terms_.GetWord(*it));
     }
+    std::sort(temp.begin(), temp.end());
+    AddQueryStat(stats, &QueryStats::results, temp.size());
 
     return std::tuple(temp, document_ratings_.at(document_id).status);
 }
 
+template <typename ExPol>
+MatchedDocuments SearchServer::MatchDocuments(ExPol&& ex_po, std::string_view raw_query,
+                                              const std::vector<int>& document_ids) const {
+    OperationTimer timer(Operation::MATCH_DOCUMENTS, document_ids.size());
+    return MatchDocumentsParsed(ex_po, ParseQuery(raw_query), document_ids);
+}
+
+template <typename ExPol>
+MatchedDocuments SearchServer::MatchDocuments(ExPol&& ex_po, const PreparedQuery& query,
+                                              const std::vector<int>& document_ids) const {
+    OperationTimer timer(Operation::MATCH_DOCUMENTS, document_ids.size());
+    Query reparsed;
+    return MatchDocumentsParsed(ex_po, ResolvePreparedQuery(query, reparsed), document_ids);
+}
+
+// Каждому документу отводится участок на все плюс-слова запроса, части
+// набора документов заполняют свои участки независимо. Затем участки
+// сдвигаются вплотную друг к другу
+template <typename ExPol>
+MatchedDocuments SearchServer::MatchDocumentsParsed(ExPol&& ex_po, const Query& query,
+                                                    const std::vector<int>& document_ids) const {
+    QueryStats* const stats = QueryStatsTrace::Active();
+    AddQueryStat(stats, &QueryStats::query_count, 1);
+    QueryStageTimer match_timer(stats, QueryStage::MATCH);
+
+    MatchedDocuments result;
+    result.document_ids_ = document_ids;
+    result.statuses_.reserve(document_ids.size());
+    std::vector<const DocumentTerms*> document_terms;
+    document_terms.reserve(document_ids.size());
+    for (const int document_id : document_ids) {
+        const auto it = word_to_document_freqs_id_key_.find(document_id);
+        if (it == word_to_document_freqs_id_key_.end()) {
+            throw std::out_of_range("Invalid document ID!");
+        }
+        document_terms.push_back(&it->second);
+        result.statuses_.push_back(document_ratings_.at(document_id).status);
+    }
+
+    // Плюс-слова в лексикографическом порядке, тогда найденные слова
+    // документа получаются упорядоченными без сортировки
+    std::vector<std::pair<std::string_view, TermId>> plus_words;
+    plus_words.reserve(query.plus_terms_.size());
+    for (const TermId term : query.plus_terms_) {
+        plus_words.emplace_back(terms_.GetWord(term), term);
+    }
+    std::sort(plus_words.begin(), plus_words.end());
+
+    const size_t slot_count = plus_words.size();
+    const size_t document_count = document_ids.size();
+    result.words_.resize(document_count * slot_count);
+    std::vector<size_t> counts(document_count, 0);
+    std::vector<char> excluded(document_count, 0);
+    const size_t part_count = std::min(GetConcurrency(ex_po),
+                                       document_count / MIN_DOCUMENTS_PER_MATCH_PART + 1);
+    ForEachPart(ex_po, part_count, [&](size_t part) {
+        const size_t first = document_count * part / part_count;
+        const size_t last = document_count * (part + 1) / part_count;
+        for (size_t i = first; i < last; ++i) {
+            const DocumentTerms& terms = *document_terms[i];
+            excluded[i] = std::any_of(query.minus_terms_.begin(), query.minus_terms_.end(),
+                                      [&terms](TermId term) {
+                return FindTerm(terms, term) != nullptr;
+            });
+            if (excluded[i]) {
+                continue;
+            }
+            const auto slots = result.words_.begin() + i * slot_count;
+            auto out = slots;
+            for (const auto& [word, term] : plus_words) {
+                if (FindTerm(terms, term) != nullptr) {
+                    *out++ = word;
+                }
+            }
+            counts[i] = out - slots;
+        }
+    });
+
+    result.offsets_.resize(document_count + 1);
+    size_t offset = 0;
+    size_t excluded_count = 0;
+    for (size_t i = 0; i < document_count; ++i) {
+        const auto first = result.words_.begin() + i * slot_count;
+        std::move(first, first + counts[i], result.words_.begin() + offset);
+        offset += counts[i];
+        result.offsets_[i + 1] = offset;
+        excluded_count += excluded[i];
+    }
+    result.words_.resize(offset);
+    AddQueryStat(stats, &QueryStats::candidates, document_count);
+    AddQueryStat(stats, &QueryStats::excluded, excluded_count);
+    AddQueryStat(stats, &QueryStats::results, offset);
+    return result;
+}
+
+// Функции статистики частей встраиваются, чтобы без сбора статистики
+// от них не оставалось вызовов
+inline std::vector<QueryStats> SearchServer::MakePartStats(QueryStats* stats, size_t part_count) {
+    if constexpr (QUERY_STATS_ENABLED) {
+        if (stats != nullptr) {
+            return std::vector<QueryStats>(part_count);
+        }
+    }
+    return {};
+}
+
+inline QueryStats* SearchServer::GetPartStats(std::vector<QueryStats>& part_stats, size_t part) {
+    return part_stats.empty() ? nullptr : &part_stats[part];
+}
+
+inline void SearchServer::MergePartStats(QueryStats* stats, const std::vector<QueryStats>& part_stats) {
+    if constexpr (QUERY_STATS_ENABLED) {
+        for (const QueryStats& part : part_stats) {
+            stats->Merge(part);
+        }
+    }
+}
+
+template <typename ExPol>
+size_t SearchServer::GetConcurrency(const ExPol& ex_po) {
+    if constexpr (std::is_same_v<std::decay_t<ExPol>, WorkStealingPool::Policy>) {
+        return ex_po.pool->WorkerCount();
+    } else if constexpr (std::is_same_v<std::decay_t<ExPol>, std::execution::parallel_policy>) {
+        return std::max(1u, std::thread::hardware_concurrency());
+    } else {
+        return 1;
+    }
+}
+
+template <typename ExPol, typename Func>
+void SearchServer::ForEachPart(ExPol&& ex_po, size_t part_count, Func func) {
+    if constexpr (std::is_same_v<std::decay_t<ExPol>, WorkStealingPool::Policy>) {
+        ex_po.pool->ParallelFor(part_count, func);
+    } else {
+        std::vector<size_t> part_indexes(part_count);
+        std::iota(part_indexes.begin(), part_indexes.end(), 0);
+        std::for_each(ex_po, part_indexes.begin(), part_indexes.end(), func);
+    }
+}
+
+// Разбиение диапазона id документов на части для независимой обработки.
+// Последовательная версия обрабатывает весь диапазон одной частью
+template <typename ExPol>
+std::vector<SearchServer::DocumentIdRange> SearchServer::SplitDocumentIds(const ExPol& ex_po,
+                                                                          const Query& query) const {
+    if (document_ids_.empty()) {
+        return {};
+    }
+    const int64_t first_id = *document_ids_.begin();
+    const int64_t id_span = int64_t{*document_ids_.rbegin()} - first_id + 1;
+
+    size_t part_count = 1;
+    if (const size_t concurrency = GetConcurrency(ex_po); concurrency > 1) {
+        part_count = std::min({concurrency * 2,
+                               CountPlusPostings(query) / MIN_POSTINGS_PER_PART + 1,
+                               static_cast<size_t>(id_span)});
+    }
+
+    std::vector<DocumentIdRange> ranges;
+    ranges.reserve(part_count);
+    for (size_t part = 0; part < part_count; ++part) {
+        ranges.push_back({
+            static_cast<int>(first_id + id_span * part / part_count),
+            static_cast<int>(first_id + id_span * (part + 1) / part_count - 1)
+        });
+    }
+    return ranges;
+}
+
+// Поиск документов по частям диапазона id. Каждая часть обрабатывается
+// независимо со своими буферами, результаты частей склеиваются в порядке id
 template <typename ExPol, typename StatusFilter>
 std::vector<Document> SearchServer::FindAllDocuments(ExPol&& ex_po, const Query& query, StatusFilter status) const {
-    std::map<int, double> ordinary_map;
-    if (std::is_same_v<ExPol, std::execution::parallel_policy>) {
-        ConcurrentMap<int, double> document_to_relevance(N_BUCKETS);
-        FindAllDocumentsImpl(ex_po, query, status, document_to_relevance);
-        ordinary_map = document_to_relevance.BuildOrdinaryMap();
-    } else {
-        FindAllDocumentsImpl(ex_po, query, status, ordinary_map);
+    const std::vector<DocumentIdRange> ranges = SplitDocumentIds(ex_po, query);
+    if (ranges.empty()) {
+        return {};
     }
 
+    QueryStats* const stats = QueryStatsTrace::Active();
+    std::vector<QueryStats> part_stats = MakePartStats(stats, ranges.size());
+    std::vector<std::vector<Document>> parts(ranges.size());
+    ForEachPart(ex_po, ranges.size(), [this, &query, status, &ranges, &parts, &part_stats](size_t part) {
+        FindAllDocumentsImpl(query, status, ranges[part], parts[part], GetPartStats(part_stats, part));
+    });
+    MergePartStats(stats, part_stats);
+
+    if (parts.size() == 1) {
+        return std::move(parts.front());
+    }
+    QueryStageTimer collect_timer(stats, QueryStage::COLLECT);
     std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : ordinary_map) {
-        matched_documents.push_back({
-                                        document_id,
-                                        relevance,
-                                        document_ratings_.at(document_id).rating
-                                    });
+    size_t matched_count = 0;
+    for (const auto& part : parts) {
+        matched_count += part.size();
+    }
+    matched_documents.reserve(matched_count);
+    for (const auto& part : parts) {
+        matched_documents.insert(matched_documents.end(), part.begin(), part.end());
     }
-
     return matched_documents;
 }
 
-template <typename ExPol, typename StatusFilter, typename Container>
-void SearchServer::FindAllDocumentsImpl(ExPol&& ex_po, const Query& query, StatusFilter status, Container& document_to_relevance) const {
-    std::set<int> set_ids;
-
-    /// Поиск документов содержащих плюс слова
-    auto search_plus_words_func = [this, &document_to_relevance, &set_ids]
-                                  (std::string_view word){
-        auto it_docs_collection = word_to_document_freqs_.find(word);
-        if (it_docs_collection != word_to_document_freqs_.end()) {
-            const double inverse_document_freq = std::log(document_ratings_.size() * 1.0
-                                                          / it_docs_collection->second.size());
-            for (const auto [document_id, term_freq] : it_docs_collection->second) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
-                    set_ids.insert(document_id);
-            }
+template <typename StatusFilter>
+void SearchServer::FindAllDocumentsImpl(const Query& query, StatusFilter status, DocumentIdRange range,
+                                        std::vector<Document>& matched_documents, QueryStats* stats) const {
+    QueryStageTimer postings_timer(stats, QueryStage::POSTINGS);
+    std::vector<PostingRun> plus_runs;
+    plus_runs.reserve(query.plus_terms_.size());
+    size_t posting_count = 0;
+    for (const TermId term : query.plus_terms_) {
+        const PostingRun run = MakePostingRun(term, range);
+        if (run.size > 0) {
+            plus_runs.push_back(run);
+            posting_count += run.size;
+        }
+    }
+    if (posting_count == 0) {
+        return;
+    }
+    AddQueryStat(stats, &QueryStats::posting_lists, plus_runs.size());
+    AddQueryStat(stats, &QueryStats::postings_scanned, posting_count);
+    postings_timer.Stop();
+
+    QueryStageTimer exclusion_timer(stats, QueryStage::EXCLUSION);
+    std::vector<PostingRun> minus_runs;
+    size_t minus_posting_count = 0;
+    for (const TermId term : query.minus_terms_) {
+        const PostingRun run = MakePostingRun(term, range);
+        if (run.size > 0) {
+            minus_runs.push_back(run);
+            minus_posting_count += run.size;
+        }
+    }
+    AddQueryStat(stats, &QueryStats::posting_lists, minus_runs.size());
+    AddQueryStat(stats, &QueryStats::postings_scanned, minus_posting_count);
+    exclusion_timer.Stop();
+
+    AccumulateRelevance(plus_runs, minus_runs, range.first, range.last,
+                        [this, status, &matched_documents](int document_id, double relevance) {
+        const auto& document_data = document_ratings_.at(document_id);
+        if (status(document_id, document_data.status, document_data.rating)) {
+            matched_documents.push_back({document_id, relevance, document_data.rating});
+        }
+    }, stats);
+}
+
+// Отбор top_k документов с динамическим отсечением (MaxScore).
+// Каждая часть диапазона id отбирает документы в собственную кучу
+template <typename ExPol, typename StatusFilter>
+std::vector<Document> SearchServer::FindTopDocumentsPruned(ExPol&& ex_po, const Query& query,
+                                                           StatusFilter status, size_t top_k) const {
+    const std::vector<DocumentIdRange> ranges = SplitDocumentIds(ex_po, query);
+    if (ranges.empty()) {
+        return {};
+    }
+
+    QueryStats* const stats = QueryStatsTrace::Active();
+    std::vector<QueryStats> part_stats = MakePartStats(stats, ranges.size());
+    std::vector<TopDocumentsHeap> heaps(ranges.size(), TopDocumentsHeap(top_k));
+    ForEachPart(ex_po, ranges.size(), [this, &query, status, &ranges, &heaps, &part_stats](size_t part) {
+        FindTopDocumentsPrunedImpl(query, status, ranges[part], heaps[part], GetPartStats(part_stats, part));
+    });
+    MergePartStats(stats, part_stats);
+
+    QueryStageTimer selection_timer(stats, QueryStage::SELECTION);
+    for (size_t part = 1; part < heaps.size(); ++part) {
+        heaps.front().Merge(std::move(heaps[part]));
+    }
+    return heaps.front().TakeSorted();
+}
+
+// Документы обходятся по возрастанию id одновременно по всем спискам вхождений.
+// Слова упорядочены по наибольшему вкладу в релевантность; префикс слов, сумма
+// вкладов которых не позволяет документу попасть в кучу, считается необязательным:
+// документы, содержащие только такие слова, пропускаются, а остальные слова
+// проверяются лишь пока документ еще может обогнать худший из отобранных
+template <typename StatusFilter>
+void SearchServer::FindTopDocumentsPrunedImpl(const Query& query, StatusFilter status, DocumentIdRange range,
+                                              TopDocumentsHeap& top_documents, QueryStats* stats) const {
+    // Исключение минус-словами чередуется с обходом, поэтому весь обход
+    // относится к этапу POSTINGS
+    QueryStageTimer postings_timer(stats, QueryStage::POSTINGS);
+    struct TermCursor {
+        PostingRun run;
+        size_t pos;
+        size_t query_pos;
+
+        bool Seek(int document_id) {
+            pos = std::lower_bound(run.document_ids + pos, run.document_ids + run.size, document_id)
+                  - run.document_ids;
+            return pos < run.size && run.document_ids[pos] == document_id;
         }
     };
 
-    std::for_each(ex_po,
-                  query.plus_words.begin(), query.plus_words.end(),
-                  search_plus_words_func);
-
-    std::vector<int> vec_ids(set_ids.begin(), set_ids.end());
-
-    /// Исключение документов содержащих минус слова
-    /// или если функция фильтрации status возвращает false
-    auto& ref_minus_words = query.minus_words;
-    auto exclude_docs_with_minus_words_func = [this, &document_to_relevance, &ref_minus_words, status]
-                                    (const int id){
-        if (!status(id,
-                    document_ratings_.at(id).status,
-                    document_ratings_.at(id).rating)) {
-             document_to_relevance.erase(id);
-        } else {
-            for (auto word : ref_minus_words) {
-                if (word_to_document_freqs_id_key_.at(id).count(word)) {
-                    document_to_relevance.erase(id);
-                }
-            }
+    std::vector<TermCursor> cursors;
+    cursors.reserve(query.plus_terms_.size());
+    for (size_t i = 0; i < query.plus_terms_.size(); ++i) {
+        const PostingRun run = MakePostingRun(query.plus_terms_[i], range);
+        if (run.size > 0) {
+            cursors.push_back({run, 0, i});
+        }
+    }
+    if (cursors.empty()) {
+        return;
+    }
+    std::sort(cursors.begin(), cursors.end(), [](const TermCursor& lhs, const TermCursor& rhs) {
+        return lhs.run.max_relevance < rhs.run.max_relevance;
+    });
+    // Наибольшая релевантность документа, содержащего только слова [0, i]
+    std::vector<double> max_relevance_prefix(cursors.size());
+    double max_relevance = 0.0;
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        max_relevance += cursors[i].run.max_relevance;
+        max_relevance_prefix[i] = max_relevance;
+    }
+
+    std::vector<TermCursor> minus_cursors;
+    for (const TermId term : query.minus_terms_) {
+        const PostingRun run = MakePostingRun(term, range);
+        if (run.size > 0) {
+            minus_cursors.push_back({run, 0, 0});
         }
+    }
+
+    // Вклады слов в релевантность текущего документа в порядке слов запроса,
+    // чтобы сумма совпадала с полным перебором
+    std::vector<double> contributions(query.plus_terms_.size(), 0.0);
+
+    // Документ с релевантностью не выше порога не может вытеснить худший из
+    // отобранных даже за счет рейтинга. Небольшой запас покрывает погрешность
+    // суммирования оценок сверху
+    const double about_zero = 1e-6;
+    const double bound_slack = 1e-9;
+    auto min_relevance = [&top_documents, about_zero, bound_slack]() {
+        return top_documents.Full()
+               ? top_documents.Worst().relevance - about_zero - bound_slack
+               : -std::numeric_limits<double>::infinity();
     };
 
-    std::for_each(ex_po,
-                  set_ids.begin(), set_ids.end(),
-                  exclude_docs_with_minus_words_func);
+    size_t candidate_count = 0;
+    size_t excluded_count = 0;
+    size_t first_essential = 0;
+    while (true) {
+        const double threshold = min_relevance();
+        while (first_essential < cursors.size() && max_relevance_prefix[first_essential] <= threshold) {
+            ++first_essential;
+        }
+        if (first_essential == cursors.size()) {
+            break;
+        }
+
+        int document_id = std::numeric_limits<int>::max();
+        bool found = false;
+        for (size_t i = first_essential; i < cursors.size(); ++i) {
+            const TermCursor& cursor = cursors[i];
+            if (cursor.pos < cursor.run.size && cursor.run.document_ids[cursor.pos] <= document_id) {
+                document_id = cursor.run.document_ids[cursor.pos];
+                found = true;
+            }
+        }
+        if (!found) {
+            break;
+        }
+
+        std::fill(contributions.begin(), contributions.end(), 0.0);
+        double relevance_bound = 0.0;
+        for (size_t i = first_essential; i < cursors.size(); ++i) {
+            TermCursor& cursor = cursors[i];
+            if (cursor.pos < cursor.run.size && cursor.run.document_ids[cursor.pos] == document_id) {
+                const double contribution = cursor.run.term_freqs[cursor.pos] * cursor.run.inverse_document_freq;
+                contributions[cursor.query_pos] = contribution;
+                relevance_bound += contribution;
+                ++cursor.pos;
+            }
+        }
+
+        bool pruned = false;
+        for (size_t i = first_essential; i-- > 0;) {
+            if (relevance_bound + max_relevance_prefix[i] <= threshold) {
+                pruned = true;
+                break;
+            }
+            TermCursor& cursor = cursors[i];
+            if (cursor.Seek(document_id)) {
+                const double contribution = cursor.run.term_freqs[cursor.pos] * cursor.run.inverse_document_freq;
+                contributions[cursor.query_pos] = contribution;
+                relevance_bound += contribution;
+                ++cursor.pos;
+            }
+        }
+        if (pruned) {
+            continue;
+        }
+
+        ++candidate_count;
+        bool excluded = false;
+        for (TermCursor& cursor : minus_cursors) {
+            if (cursor.Seek(document_id)) {
+                excluded = true;
+                break;
+            }
+        }
+        if (excluded) {
+            ++excluded_count;
+            continue;
+        }
+
+        const auto& document_data = document_ratings_.at(document_id);
+        if (!status(document_id, document_data.status, document_data.rating)) {
+            continue;
+        }
+        double relevance = 0.0;
+        for (const double contribution : contributions) {
+            relevance += contribution;
+        }
+        top_documents.Push({document_id, relevance, document_data.rating});
+    }
+
+    if constexpr (QUERY_STATS_ENABLED) {
+        // Просмотренными считаются вхождения до позиций курсоров
+        size_t posting_count = 0;
+        for (const auto* group : {&cursors, &minus_cursors}) {
+            for (const TermCursor& cursor : *group) {
+                posting_count += cursor.pos;
+            }
+        }
+        AddQueryStat(stats, &QueryStats::posting_lists, cursors.size() + minus_cursors.size());
+        AddQueryStat(stats, &QueryStats::postings_scanned, posting_count);
+    }
+    AddQueryStat(stats, &QueryStats::candidates, candidate_count);
+    AddQueryStat(stats, &QueryStats::excluded, excluded_count);
 }
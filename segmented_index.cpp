@@ -0,0 +1,645 @@
+#include "segmented_index.h"
+#include "string_processing.h"
+#include "Lib/thread_priority.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+
+using namespace std;
+
+SegmentedIndex::SegmentedIndex(string_view stop_words, SegmentedIndexOptions options)
+    : options_(options) {
+    vector<string_view> words;
+    if (!SplitIntoWords(stop_words, words)) {
+        throw invalid_argument("Invalid symbol!"s);
+    }
+    stop_words_.insert(words.begin(), words.end());
+    published_terms_ = std::make_shared<const TermDictionary>();
+    memtable_ = make_shared<Memtable>(options_.memtable_size,
+                                      options_.memtable_size * MEMTABLE_TERMS_PER_DOCUMENT);
+    memtable_deleted_ = make_shared<const vector<int>>();
+    version_.store(new Version{published_terms_, nullptr, {}, {{memtable_, 0, memtable_deleted_}}, 0});
+    merge_thread_ = thread([this] {
+        SetIdleThreadPriority();
+        MergeLoop();
+    });
+}
+
+SegmentedIndex::~SegmentedIndex() {
+    {
+        lock_guard lock(merge_mutex_);
+        stopping_ = true;
+    }
+    merge_cv_.notify_all();
+    merge_thread_.join();
+    delete version_.load();
+}
+
+SegmentedIndex::Memtable::Memtable(size_t capacity, size_t term_capacity)
+    : documents(new MemtableDocument[max<size_t>(capacity, 1)])
+    , term_capacity(term_capacity) {
+    // Таблица заполняется не больше чем наполовину
+    size_t slot_count = 1;
+    while (slot_count < term_capacity * 2) {
+        slot_count *= 2;
+    }
+    last_positions_.reset(new atomic<uint64_t>[slot_count]);
+    for (size_t i = 0; i < slot_count; ++i) {
+        last_positions_[i].store(EMPTY_SLOT, memory_order_relaxed);
+    }
+    slot_mask_ = slot_count - 1;
+}
+
+size_t SegmentedIndex::Memtable::FindSlot(TermId term) const {
+    const uint64_t key = uint64_t{term} + 1;
+    for (size_t slot = (key * 0x9E3779B97F4A7C15ull >> 32) & slot_mask_;; slot = (slot + 1) & slot_mask_) {
+        const uint64_t value = last_positions_[slot].load(memory_order_acquire);
+        if (value == EMPTY_SLOT || value >> 32 == key) {
+            return slot;
+        }
+    }
+}
+
+int SegmentedIndex::Memtable::FindLast(TermId term) const {
+    const uint64_t value = last_positions_[FindSlot(term)].load(memory_order_acquire);
+    return value == EMPTY_SLOT ? -1 : static_cast<int>(static_cast<uint32_t>(value));
+}
+
+void SegmentedIndex::Memtable::SetLast(TermId term, int position) {
+    const size_t slot = FindSlot(term);
+    if (last_positions_[slot].load(memory_order_relaxed) == EMPTY_SLOT) {
+        ++term_count;
+    }
+    last_positions_[slot].store((uint64_t{term} + 1) << 32 | static_cast<uint32_t>(position),
+                                memory_order_release);
+}
+
+size_t SegmentedIndex::Tombstones::size() const {
+    return ids.size() + (base ? base->ids.size() : 0);
+}
+
+bool SegmentedIndex::Tombstones::Contains(int document_id) const {
+    return binary_search(ids.begin(), ids.end(), document_id) || (base && base->Contains(document_id));
+}
+
+int SegmentedIndex::Tombstones::CountTerm(TermId term) const {
+    const auto it = lower_bound(term_counts.begin(), term_counts.end(), term,
+                                [](const pair<TermId, int>& lhs, TermId rhs) {
+        return lhs.first < rhs;
+    });
+    const int count = it != term_counts.end() && it->first == term ? it->second : 0;
+    return base ? count + base->CountTerm(term) : count;
+}
+
+vector<int> SegmentedIndex::Tombstones::AllIds() const {
+    if (!base) {
+        return ids;
+    }
+    vector<int> result;
+    result.reserve(size());
+    merge(ids.begin(), ids.end(), base->ids.begin(), base->ids.end(), back_inserter(result));
+    return result;
+}
+
+TermId SegmentedIndex::Version::Find(string_view word) const {
+    const TermId term = terms->Find(word);
+    if (term != TermDictionary::NO_TERM || !recent_terms) {
+        return term;
+    }
+    const auto it = recent_terms->find(word);
+    return it == recent_terms->end() ? TermDictionary::NO_TERM : it->second;
+}
+
+void SegmentedIndex::AddDocument(int document_id, string_view document,
+                                 DocumentStatus status, const vector<int>& ratings) {
+    if (document_id < 0) {
+        throw invalid_argument("invalid id"s);
+    }
+    // Разбор текста не требует блокировки и не мешает поиску
+    const auto word_freqs = ParseDocument(document);
+    int rating_sum = 0;
+    for (const int rating : ratings) {
+        rating_sum += rating;
+    }
+
+    bool sealed = false;
+    {
+        lock_guard lock(write_mutex_);
+        if (document_ids_.count(document_id) > 0) {
+            throw invalid_argument("invalid id"s);
+        }
+        vector<TermFrequency> terms;
+        terms.reserve(word_freqs.size());
+        for (const auto& [word, term_freq] : word_freqs) {
+            terms.push_back({terms_.Intern(word), term_freq});
+        }
+        sort(terms.begin(), terms.end(), [](const TermFrequency& lhs, const TermFrequency& rhs) {
+            return lhs.term < rhs.term;
+        });
+        if (memtable_->term_count + terms.size() > memtable_->term_capacity) {
+            SealMemtable();
+            sealed = true;
+            if (terms.size() > memtable_->term_capacity) {
+                memtable_ = make_shared<Memtable>(options_.memtable_size, terms.size());
+            }
+        }
+
+        // Место документа не видно ни одной опубликованной версии, позиции
+        // в таблице слов обновляются после его записи
+        const int position = static_cast<int>(memtable_size_);
+        MemtableDocument& memtable_document = memtable_->documents[position];
+        memtable_document.id = document_id;
+        memtable_document.document.rating = ratings.empty() ? 0 : rating_sum / static_cast<int>(ratings.size());
+        memtable_document.document.status = status;
+        memtable_document.previous_positions.reserve(terms.size());
+        for (const TermFrequency& term_freq : terms) {
+            memtable_document.previous_positions.push_back(memtable_->FindLast(term_freq.term));
+        }
+        memtable_document.document.terms = DocumentTerms(move(terms));
+        for (const TermFrequency& term_freq : memtable_document.document.terms) {
+            memtable_->SetLast(term_freq.term, position);
+        }
+        memtable_positions_.emplace(document_id, position);
+        ++memtable_size_;
+        document_ids_.insert(document_id);
+        ++document_count_;
+
+        if (memtable_size_ >= options_.memtable_size) {
+            SealMemtable();
+            sealed = true;
+        }
+        Publish();
+    }
+    if (sealed) {
+        RequestMerge();
+    }
+}
+
+void SegmentedIndex::RemoveDocument(int document_id) {
+    bool merge_needed = false;
+    {
+        lock_guard lock(write_mutex_);
+        if (document_ids_.erase(document_id) == 0) {
+            return;
+        }
+        --document_count_;
+
+        if (const auto it = memtable_positions_.find(document_id); it != memtable_positions_.end()) {
+            auto deleted = make_shared<vector<int>>(*memtable_deleted_);
+            deleted->insert(upper_bound(deleted->begin(), deleted->end(), it->second), it->second);
+            memtable_deleted_ = move(deleted);
+            memtable_positions_.erase(it);
+        } else if (const auto frozen = find_if(frozen_memtables_.begin(), frozen_memtables_.end(),
+                                               [document_id](const FrozenMemtable& frozen) {
+                       return frozen.positions.count(document_id) > 0;
+                   });
+                   frozen != frozen_memtables_.end()) {
+            const int position = frozen->positions.at(document_id);
+            auto deleted = make_shared<vector<int>>(*frozen->memtable.deleted);
+            deleted->insert(upper_bound(deleted->begin(), deleted->end(), position), position);
+            frozen->memtable.deleted = move(deleted);
+            frozen->positions.erase(document_id);
+        } else {
+            // Документ закрытого сегмента отмечается удаленным. Id может
+            // встречаться и среди удаленных документов более старого сегмента
+            for (SegmentRef& segment_ref : segments_) {
+                const auto& documents = segment_ref.segment->documents;
+                if (documents.count(document_id) == 0 || segment_ref.deleted->Contains(document_id)) {
+                    continue;
+                }
+                segment_ref.deleted = AddTombstones(*segment_ref.deleted, *segment_ref.segment, {document_id});
+                merge_needed = static_cast<double>(segment_ref.deleted->size())
+                               >= options_.max_deleted_share * documents.size();
+                break;
+            }
+        }
+        Publish();
+    }
+    if (merge_needed) {
+        RequestMerge();
+    }
+}
+
+vector<Document> SegmentedIndex::FindTopDocuments(string_view raw_query,
+                                                  DocumentStatus document_status,
+                                                  size_t top_k) const {
+    return FindTopDocuments(execution::seq, raw_query, document_status, top_k);
+}
+
+int SegmentedIndex::GetDocumentCount() const {
+    const auto guard = epochs_.Pin();
+    return static_cast<int>(version_.load()->document_count);
+}
+
+size_t SegmentedIndex::GetSegmentCount() const {
+    const auto guard = epochs_.Pin();
+    return version_.load()->segments.size();
+}
+
+void SegmentedIndex::Flush() {
+    {
+        lock_guard lock(write_mutex_);
+        SealMemtable();
+        Publish();
+    }
+    RequestMerge();
+}
+
+void SegmentedIndex::WaitForMerges() {
+    unique_lock lock(merge_mutex_);
+    merge_cv_.wait(lock, [this] {
+        return !merge_requested_ && !merging_;
+    });
+}
+
+vector<pair<string_view, double>> SegmentedIndex::ParseDocument(string_view document) const {
+    return ComputeWordFrequencies(document, [this](string_view word) {
+        return stop_words_.count(word) > 0;
+    });
+}
+
+// Разбор запроса по правилам SearchServer. Слова ищутся в словаре версии,
+// IDF плюс-слов вычисляется позже по сегментам версии
+SegmentedIndex::Query SegmentedIndex::ParseQuery(const Version& version, string_view text) const {
+    thread_local vector<string_view> words;
+    if (!SplitIntoWords(text, words)) {
+        throw invalid_argument("Invalid symbol!"s);
+    }
+
+    vector<TermId> plus_terms;
+    Query query;
+    for (string_view word : words) {
+        bool is_minus = false;
+        if (word[0] == '-') {
+            is_minus = true;
+            word.remove_prefix(1);
+            if (word.empty()) {
+                throw invalid_argument("empty minus word"s);
+            }
+            if (word.front() == '-') {
+                throw invalid_argument("double minus"s);
+            }
+        }
+        if (stop_words_.count(word) > 0) {
+            continue;
+        }
+        const TermId term = version.Find(word);
+        if (term == TermDictionary::NO_TERM) {
+            continue;
+        }
+        (is_minus ? query.minus_terms : plus_terms).push_back(term);
+    }
+
+    for (auto* terms : {&plus_terms, &query.minus_terms}) {
+        sort(terms->begin(), terms->end());
+        terms->erase(unique(terms->begin(), terms->end()), terms->end());
+    }
+    for (TermId term : plus_terms) {
+        query.plus_terms.push_back({term, 0.0});
+    }
+    return query;
+}
+
+void SegmentedIndex::ScanMemtable(const MemtableRef& memtable, const Query& query,
+                                  vector<MemtableMatch>& matches, vector<double>& freqs,
+                                  vector<int>& document_freqs) {
+    const MemtableDocument* documents = memtable.memtable->documents.get();
+    const vector<int>& deleted = *memtable.deleted;
+    const int size = static_cast<int>(memtable.size);
+
+    // Вхождения плюс-слов: позиция документа, номер слова в запросе и частота.
+    // Цепочка слова может начинаться с документов, добавленных после версии
+    thread_local vector<tuple<int, size_t, double>> entries;
+    entries.clear();
+    const size_t plus_count = query.plus_terms.size();
+    for (size_t i = 0; i < plus_count; ++i) {
+        const TermId term = query.plus_terms[i].term;
+        for (int position = memtable.memtable->FindLast(term); position >= 0;) {
+            const MemtableDocument& document = documents[position];
+            const size_t index = FindTerm(document.document.terms, term) - document.document.terms.data();
+            if (position < size && !binary_search(deleted.begin(), deleted.end(), position)) {
+                entries.emplace_back(position, i, document.document.terms[index].freq);
+            }
+            position = document.previous_positions[index];
+        }
+    }
+    sort(entries.begin(), entries.end());
+
+    for (size_t i = 0; i < entries.size();) {
+        const int position = get<0>(entries[i]);
+        const size_t freqs_pos = freqs.size();
+        freqs.resize(freqs_pos + plus_count, 0.0);
+        for (; i < entries.size() && get<0>(entries[i]) == position; ++i) {
+            const size_t term_index = get<1>(entries[i]);
+            freqs[freqs_pos + term_index] = get<2>(entries[i]);
+            ++document_freqs[term_index];
+        }
+        const DocumentTerms& terms = documents[position].document.terms;
+        const bool excluded = any_of(query.minus_terms.begin(), query.minus_terms.end(), [&terms](TermId term) {
+            return FindTerm(terms, term) != nullptr;
+        });
+        matches.push_back({&documents[position], freqs_pos, excluded});
+    }
+}
+
+// Документная частота слова в закрытом сегменте - длина его списка
+// вхождений без документов, отмеченных удаленными
+void SegmentedIndex::ComputeInverseDocumentFreqs(const Version& version, Query& query,
+                                                 vector<int>& document_freqs) {
+    const double log_document_count = log(static_cast<double>(version.document_count));
+    for (size_t i = 0; i < query.plus_terms.size(); ++i) {
+        const TermId term = query.plus_terms[i].term;
+        for (const SegmentRef& segment_ref : version.segments) {
+            if (const PostingList* postings = segment_ref.segment->postings.Find(term)) {
+                document_freqs[i] += static_cast<int>(postings->size()) - segment_ref.deleted->CountTerm(term);
+            }
+        }
+        query.plus_terms[i].inverse_document_freq = document_freqs[i] > 0
+                ? log_document_count - log(static_cast<double>(document_freqs[i]))
+                : 0.0;
+    }
+}
+
+// Заморозка изменяемого сегмента, вызывается под блокировкой писателей.
+// Сегмент больше не изменяется, кроме отметок удаления, и закрывается
+// фоновым потоком
+void SegmentedIndex::SealMemtable() {
+    if (memtable_size_ == 0) {
+        return;
+    }
+    frozen_memtables_.push_back({{memtable_, memtable_size_, memtable_deleted_}, move(memtable_positions_)});
+    if (frozen_memtables_.size() > MAX_FROZEN_MEMTABLES) {
+        Segment segment = BuildSegment(frozen_memtables_.front());
+        if (!segment.documents.empty()) {
+            segments_.push_back({make_shared<const Segment>(move(segment)), make_shared<const Tombstones>()});
+        }
+        frozen_memtables_.erase(frozen_memtables_.begin());
+    }
+    memtable_ = make_shared<Memtable>(options_.memtable_size,
+                                      options_.memtable_size * MEMTABLE_TERMS_PER_DOCUMENT);
+    memtable_size_ = 0;
+    memtable_deleted_ = make_shared<const vector<int>>();
+    memtable_positions_.clear();
+}
+
+// Закрытый сегмент из неудаленных документов замороженного. Документы
+// копируются: опубликованные версии продолжают читать замороженный сегмент
+SegmentedIndex::Segment SegmentedIndex::BuildSegment(const FrozenMemtable& frozen) {
+    Segment segment;
+    for (const auto& [document_id, position] : frozen.positions) {
+        const SegmentDocument& document = frozen.memtable.memtable->documents[position].document;
+        segment.documents.emplace_hint(segment.documents.end(), document_id, document);
+        for (const auto& [term, term_freq] : document.terms) {
+            segment.postings[term].Add(document_id, term_freq);
+        }
+    }
+    return segment;
+}
+
+// Сегмент строится без блокировки писателей. Документы, удаленные во время
+// построения, отмечаются удаленными в новом сегменте. Сегмент, который
+// за это время закрыл писатель, отбрасывается
+void SegmentedIndex::CloseFrozenMemtables() {
+    while (true) {
+        FrozenMemtable frozen;
+        {
+            lock_guard lock(write_mutex_);
+            if (frozen_memtables_.empty()) {
+                return;
+            }
+            frozen = frozen_memtables_.front();
+        }
+        Segment segment = BuildSegment(frozen);
+
+        lock_guard lock(write_mutex_);
+        const auto it = find_if(frozen_memtables_.begin(), frozen_memtables_.end(),
+                                [&frozen](const FrozenMemtable& current) {
+            return current.memtable.memtable == frozen.memtable.memtable;
+        });
+        if (it == frozen_memtables_.end()) {
+            continue;
+        }
+        vector<int> deleted;
+        for (const auto& [document_id, position] : frozen.positions) {
+            if (it->positions.count(document_id) == 0) {
+                deleted.push_back(document_id);
+            }
+        }
+        frozen_memtables_.erase(it);
+        if (!segment.documents.empty()) {
+            auto closed = make_shared<const Segment>(move(segment));
+            auto tombstones = AddTombstones(Tombstones{}, *closed, deleted);
+            segments_.push_back({move(closed), move(tombstones)});
+        }
+        Publish();
+    }
+}
+
+// Публикация состояния писателей, вызывается под блокировкой писателей.
+// Новые слова добавляются в небольшую таблицу версии, словарь копируется
+// целиком, только когда их накопилось больше MAX_RECENT_TERMS
+void SegmentedIndex::Publish() {
+    const size_t published_count = published_terms_->size() + (recent_terms_ ? recent_terms_->size() : 0);
+    if (terms_.size() - published_terms_->size() > MAX_RECENT_TERMS) {
+        published_terms_ = make_shared<const TermDictionary>(terms_);
+        recent_terms_.reset();
+    } else if (terms_.size() != published_count) {
+        auto recent_terms = recent_terms_ ? make_shared<RecentTerms>(*recent_terms_) : make_shared<RecentTerms>();
+        for (TermId term = static_cast<TermId>(published_count); term < terms_.size(); ++term) {
+            recent_terms->emplace(terms_.GetWord(term), term);
+        }
+        recent_terms_ = move(recent_terms);
+    }
+    vector<MemtableRef> memtables;
+    memtables.reserve(frozen_memtables_.size() + 1);
+    for (const FrozenMemtable& frozen : frozen_memtables_) {
+        memtables.push_back(frozen.memtable);
+    }
+    memtables.push_back({memtable_, memtable_size_, memtable_deleted_});
+    const Version* old_version = version_.exchange(
+                new Version{published_terms_, recent_terms_, segments_, move(memtables), document_count_});
+    epochs_.Retire(old_version);
+    epochs_.Reclaim();
+}
+
+void SegmentedIndex::RequestMerge() {
+    {
+        lock_guard lock(merge_mutex_);
+        merge_requested_ = true;
+    }
+    merge_cv_.notify_all();
+}
+
+void SegmentedIndex::MergeLoop() {
+    unique_lock lock(merge_mutex_);
+    while (true) {
+        merge_cv_.wait(lock, [this] {
+            return merge_requested_ || stopping_;
+        });
+        if (stopping_) {
+            return;
+        }
+        merge_requested_ = false;
+        merging_ = true;
+        lock.unlock();
+
+        // Сегменты закрываются и сливаются без блокировки индекса, поиск
+        // и добавление документов продолжаются во время слияния
+        CloseFrozenMemtables();
+        for (auto sources = PickMerge(); !sources.empty(); sources = PickMerge()) {
+            ReplaceSegments(sources, MergeSegments(sources));
+        }
+
+        lock.lock();
+        merging_ = false;
+        merge_cv_.notify_all();
+    }
+}
+
+// Сегмент с большой долей удаленных документов перестраивается отдельно.
+// Остальные сегменты распределяются по уровням размера, отличающимся
+// в merge_factor раз, и сливаются по merge_factor сегментов одного уровня
+vector<SegmentedIndex::SegmentRef> SegmentedIndex::PickMerge() {
+    lock_guard lock(write_mutex_);
+    map<int, vector<SegmentRef>> levels;
+    for (const SegmentRef& segment_ref : segments_) {
+        const size_t document_count = segment_ref.segment->documents.size();
+        const size_t live_count = document_count - segment_ref.deleted->size();
+        if (static_cast<double>(segment_ref.deleted->size()) >= options_.max_deleted_share * document_count) {
+            return {segment_ref};
+        }
+
+        int level = 0;
+        for (size_t level_size = options_.memtable_size * options_.merge_factor;
+             live_count >= level_size; level_size *= options_.merge_factor) {
+            ++level;
+        }
+        auto& level_segments = levels[level];
+        level_segments.push_back(segment_ref);
+        if (level_segments.size() >= max<size_t>(options_.merge_factor, 2)) {
+            return level_segments;
+        }
+    }
+    return {};
+}
+
+SegmentedIndex::Segment SegmentedIndex::MergeSegments(const vector<SegmentRef>& sources) {
+    Segment merged;
+    vector<int> ids;
+    vector<double> freqs;
+    for (const SegmentRef& source : sources) {
+        const vector<int> deleted = source.deleted->AllIds();
+        const auto is_deleted = [&deleted](int document_id) {
+            return binary_search(deleted.begin(), deleted.end(), document_id);
+        };
+
+        for (const auto& [document_id, document] : source.segment->documents) {
+            if (!is_deleted(document_id)) {
+                merged.documents.emplace(document_id, document);
+            }
+        }
+
+        const InvertedIndex& postings = source.segment->postings;
+        merged.postings.Resize(postings.size());
+        for (TermId term = 0; term < postings.size(); ++term) {
+            const PostingList* source_postings = postings.Find(term);
+            if (source_postings == nullptr) {
+                continue;
+            }
+            ids.clear();
+            freqs.clear();
+            for (size_t i = 0; i < source_postings->size(); ++i) {
+                const int document_id = source_postings->DocumentIds()[i];
+                if (!is_deleted(document_id)) {
+                    ids.push_back(document_id);
+                    freqs.push_back(source_postings->TermFreqs()[i]);
+                }
+            }
+            merged.postings[term].Merge(ids.data(), freqs.data(), ids.size());
+        }
+    }
+    return merged;
+}
+
+// Замена исходных сегментов результатом слияния. Документы, удаленные
+// во время слияния, вошли в новый сегмент и отмечаются удаленными в нем
+void SegmentedIndex::ReplaceSegments(const vector<SegmentRef>& sources, Segment merged) {
+    lock_guard lock(write_mutex_);
+    vector<int> deleted;
+    for (const SegmentRef& source : sources) {
+        const auto it = find_if(segments_.begin(), segments_.end(), [&source](const SegmentRef& segment_ref) {
+            return segment_ref.segment == source.segment;
+        });
+        const vector<int> current_ids = it->deleted->AllIds();
+        const vector<int> source_ids = source.deleted->AllIds();
+        set_difference(current_ids.begin(), current_ids.end(), source_ids.begin(), source_ids.end(),
+                       back_inserter(deleted));
+        segments_.erase(it);
+    }
+    if (!merged.documents.empty()) {
+        sort(deleted.begin(), deleted.end());
+        auto segment = make_shared<const Segment>(move(merged));
+        auto tombstones = AddTombstones(Tombstones{}, *segment, deleted);
+        segments_.push_back({move(segment), move(tombstones)});
+    }
+    Publish();
+}
+
+shared_ptr<const SegmentedIndex::Tombstones> SegmentedIndex::AddTombstones(const Tombstones& tombstones,
+                                                                            const Segment& segment,
+                                                                            const vector<int>& ids) {
+    Tombstones added;
+    added.ids = ids;
+    vector<TermId> added_terms;
+    for (const int document_id : ids) {
+        for (const auto& [term, term_freq] : segment.documents.at(document_id).terms) {
+            added_terms.push_back(term);
+        }
+    }
+    sort(added_terms.begin(), added_terms.end());
+    for (const TermId term : added_terms) {
+        if (added.term_counts.empty() || added.term_counts.back().first != term) {
+            added.term_counts.emplace_back(term, 0);
+        }
+        ++added.term_counts.back().second;
+    }
+
+    // Последние отметки копируются, пока их немного, затем переносятся
+    // в основные одним копированием
+    auto recent = make_shared<Tombstones>(MergeTombstones(tombstones, added));
+    if (recent->ids.size() <= MAX_RECENT_TOMBSTONES) {
+        recent->base = tombstones.base;
+        return recent;
+    }
+    auto result = make_shared<Tombstones>();
+    result->base = tombstones.base ? make_shared<const Tombstones>(MergeTombstones(*tombstones.base, *recent))
+                                   : move(recent);
+    return result;
+}
+
+SegmentedIndex::Tombstones SegmentedIndex::MergeTombstones(const Tombstones& lhs, const Tombstones& rhs) {
+    Tombstones result;
+    result.ids.reserve(lhs.ids.size() + rhs.ids.size());
+    merge(lhs.ids.begin(), lhs.ids.end(), rhs.ids.begin(), rhs.ids.end(), back_inserter(result.ids));
+
+    // Слияние упорядоченных счетчиков слов
+    auto& term_counts = result.term_counts;
+    term_counts.reserve(lhs.term_counts.size() + rhs.term_counts.size());
+    auto lhs_it = lhs.term_counts.begin();
+    auto rhs_it = rhs.term_counts.begin();
+    while (lhs_it != lhs.term_counts.end() && rhs_it != rhs.term_counts.end()) {
+        if (lhs_it->first < rhs_it->first) {
+            term_counts.push_back(*lhs_it++);
+        } else if (rhs_it->first < lhs_it->first) {
+            term_counts.push_back(*rhs_it++);
+        } else {
+            term_counts.emplace_back(lhs_it->first, lhs_it->second + rhs_it->second);
+            ++lhs_it;
+            ++rhs_it;
+        }
+    }
+    term_counts.insert(term_counts.end(), lhs_it, lhs.term_counts.end());
+    term_counts.insert(term_counts.end(), rhs_it, rhs.term_counts.end());
+    return result;
+}
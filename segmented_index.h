@@ -0,0 +1,425 @@
+#pragma once
+
+#include "document.h"
+#include "inverted_index.h"
+#include "relevance_accumulator.h"
+#include "term_dictionary.h"
+#include "Lib/epoch_reclaimer.h"
+#include "Lib/top_k_heap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Параметры сегментированного индекса
+struct SegmentedIndexOptions {
+    // Количество документов изменяемого сегмента, при котором он закрывается
+    size_t memtable_size = 4096;
+    // Количество закрытых сегментов, при котором наименьшие из них сливаются
+    size_t merge_factor = 4;
+    // Доля удаленных документов, при которой сегмент перестраивается
+    double max_deleted_share = 0.5;
+};
+
+// Индекс из неизменяемых сегментов и небольшого изменяемого сегмента.
+// Новые документы попадают в изменяемый сегмент, заполненный сегмент
+// замораживается, и фоновый поток закрывает его, строя списки вхождений.
+// Удаление закрытого документа только отмечает его, фоновый поток
+// сливает мелкие сегменты и перестраивает сегменты с большой долей удаленных
+// документов, физически удаляя их.
+// Словарь общий для всех сегментов, документная частота слов запроса
+// складывается по сегментам версии без удаленных документов, поэтому
+// релевантность совпадает с релевантностью SearchServer с теми же документами.
+//
+// Поиск работает с опубликованной неизменяемой версией индекса и не берет
+// блокировок: версия закрепляется эпохой, замененные версии удаляются после
+// завершения закрепивших их поисков. Каждое добавление и удаление публикует
+// новую версию, поэтому изменения видны поиску сразу после возврата из метода.
+// Публикация копирует список закрытых сегментов, а не их данные: изменяемый
+// сегмент только дописывается, и версия видит его документы до своей длины.
+//
+// Фоновый поток работает с наименьшим приоритетом и получает процессор,
+// когда он не нужен поиску и писателям, поэтому закрытие сегментов и слияния
+// не увеличивают задержку поиска. Пока сегменты не закрыты, поиск читает
+// их как изменяемые. Если замороженных сегментов больше
+// MAX_FROZEN_MEMTABLES, старейший закрывает писатель
+class SegmentedIndex {
+public:
+    static constexpr size_t MAX_RESULT_DOCUMENT_COUNT = 5;
+
+    explicit SegmentedIndex(std::string_view stop_words,
+                            SegmentedIndexOptions options = SegmentedIndexOptions{});
+    SegmentedIndex(const SegmentedIndex&) = delete;
+    SegmentedIndex& operator=(const SegmentedIndex&) = delete;
+    ~SegmentedIndex();
+
+    void AddDocument(int document_id, std::string_view document,
+                     DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+
+    template <typename StatusFilter>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, StatusFilter status,
+                                           size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+                                           DocumentStatus document_status = DocumentStatus::ACTUAL,
+                                           size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    // Параллельная версия обходит сегменты параллельно
+    template <typename ExPol, typename StatusFilter>
+    std::vector<Document> FindTopDocuments(ExPol&& ex_po, std::string_view raw_query,
+                                           StatusFilter status,
+                                           size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+    template <typename ExPol>
+    std::vector<Document> FindTopDocuments(ExPol&& ex_po, std::string_view raw_query,
+                                           DocumentStatus document_status = DocumentStatus::ACTUAL,
+                                           size_t top_k = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Количество документов и закрытых сегментов опубликованной версии
+    int GetDocumentCount() const;
+    size_t GetSegmentCount() const;
+
+    // Закрытие изменяемого сегмента и публикация всех изменений
+    void Flush();
+    // Ожидание завершения слияний, необходимых по текущему состоянию
+    void WaitForMerges();
+
+private:
+    struct SegmentDocument {
+        DocumentTerms terms;
+        int rating;
+        DocumentStatus status;
+    };
+
+    // Сегмент: списки вхождений и прямой индекс своих документов
+    struct Segment {
+        InvertedIndex postings;
+        std::map<int, SegmentDocument> documents;
+    };
+
+    // Отсортированные id удаленных документов закрытого сегмента и количество
+    // удаленных документов с каждым словом, упорядоченное по id слова.
+    // Последние отметки хранятся отдельно от основных, поэтому удаление
+    // документа копирует не больше MAX_RECENT_TOMBSTONES отметок
+    struct Tombstones {
+        std::vector<int> ids;
+        std::vector<std::pair<TermId, int>> term_counts;
+        // Основные отметки без собственных основных, id не пересекаются с ids
+        std::shared_ptr<const Tombstones> base;
+
+        size_t size() const;
+        bool Contains(int document_id) const;
+        // Количество документов сегмента со словом, отмеченных удаленными
+        int CountTerm(TermId term) const;
+        // Id всех отметок по возрастанию
+        std::vector<int> AllIds() const;
+    };
+
+    // Закрытый сегмент и его удаленные документы. Оба объекта неизменяемы,
+    // при удалении документа отметки заменяются копией
+    struct SegmentRef {
+        std::shared_ptr<const Segment> segment;
+        std::shared_ptr<const Tombstones> deleted;
+    };
+
+    // Документ изменяемого сегмента. Для каждого слова документа хранится
+    // позиция предыдущего документа сегмента с этим словом или -1
+    struct MemtableDocument {
+        int id;
+        SegmentDocument document;
+        std::vector<int> previous_positions;
+    };
+
+    // Документы изменяемого сегмента в порядке добавления. Место под
+    // memtable_size документов выделяется сразу, поэтому документы не
+    // перемещаются: писатель дописывает новые в конец, а поиск читает
+    // документы, опубликованные до закрепленной им версии.
+    // Документы с одним словом связаны в цепочку от последнего к первому.
+    // Позиции последних документов хранятся в таблице с открытой адресацией
+    // фиксированного размера; писатель обновляет их после записи документа,
+    // поэтому поиск не видит незаписанных документов
+    struct Memtable {
+        Memtable(size_t capacity, size_t term_capacity);
+
+        // Позиция последнего документа со словом или -1
+        int FindLast(TermId term) const;
+        // Вызывается только писателем, слов не больше term_capacity
+        void SetLast(TermId term, int position);
+
+        std::unique_ptr<MemtableDocument[]> documents;
+        size_t term_capacity;
+        // Количество слов в таблице, изменяется только писателем
+        size_t term_count = 0;
+
+    private:
+        static constexpr uint64_t EMPTY_SLOT = 0;
+
+        size_t FindSlot(TermId term) const;
+
+        // Слот хранит id слова, увеличенный на 1, в старших 32 битах и позицию
+        std::unique_ptr<std::atomic<uint64_t>[]> last_positions_;
+        size_t slot_mask_;
+    };
+
+    // Изменяемый сегмент в опубликованной версии: первые size документов
+    // и отсортированные позиции удаленных из них. Удаленный id может быть
+    // добавлен снова, поэтому отмечается позиция, а не id
+    struct MemtableRef {
+        std::shared_ptr<const Memtable> memtable;
+        size_t size = 0;
+        std::shared_ptr<const std::vector<int>> deleted;
+    };
+
+    // Слова, добавленные в словарь после копирования, опубликованного в версии
+    using RecentTerms = std::unordered_map<std::string_view, TermId>;
+
+    // Заполненный изменяемый сегмент, который еще не закрыт, и позиции
+    // его неудаленных документов по id
+    struct FrozenMemtable {
+        MemtableRef memtable;
+        std::map<int, int> positions;
+    };
+
+    // Опубликованное состояние индекса, не изменяется после публикации
+    struct Version {
+        std::shared_ptr<const TermDictionary> terms;
+        std::shared_ptr<const RecentTerms> recent_terms;
+        std::vector<SegmentRef> segments;
+        // Замороженные сегменты и последним - текущий изменяемый
+        std::vector<MemtableRef> memtables;
+        size_t document_count = 0;
+
+        // Id слова в словаре версии или TermDictionary::NO_TERM
+        TermId Find(std::string_view word) const;
+    };
+
+    // Слово запроса с обратной документной частотой версии
+    struct QueryTerm {
+        TermId term;
+        double inverse_document_freq;
+    };
+    struct Query {
+        std::vector<QueryTerm> plus_terms;
+        std::vector<TermId> minus_terms;
+    };
+
+    // Документ изменяемого сегмента, содержащий плюс-слова запроса. Частоты
+    // плюс-слов в нем хранятся в буфере поиска с позиции freqs_pos
+    struct MemtableMatch {
+        const MemtableDocument* document;
+        size_t freqs_pos;
+        bool excluded;
+    };
+
+    using TopDocumentsHeap = TopKHeap<Document, MoreRelevant>;
+
+    // Количество новых слов, после которого словарь версии копируется заново
+    static constexpr size_t MAX_RECENT_TERMS = 1024;
+    // Размер таблицы слов изменяемого сегмента на один документ. Сегмент
+    // с большим количеством различных слов закрывается раньше
+    static constexpr size_t MEMTABLE_TERMS_PER_DOCUMENT = 8;
+    // Количество замороженных сегментов, сверх которого писатель
+    // закрывает их сам, не дожидаясь фонового потока
+    static constexpr size_t MAX_FROZEN_MEMTABLES = 8;
+    // Количество последних отметок удаления, сверх которого они
+    // переносятся в основные
+    static constexpr size_t MAX_RECENT_TOMBSTONES = 1024;
+
+    SegmentedIndexOptions options_;
+    std::set<std::string, std::less<>> stop_words_;
+
+    // Состояние писателей, защищено write_mutex_. Количество документов
+    // учитывает и документы изменяемого сегмента
+    std::mutex write_mutex_;
+    TermDictionary terms_;
+    std::shared_ptr<const TermDictionary> published_terms_;
+    std::shared_ptr<const RecentTerms> recent_terms_;
+    size_t document_count_ = 0;
+    std::set<int> document_ids_;
+    std::shared_ptr<Memtable> memtable_;
+    size_t memtable_size_ = 0;
+    std::shared_ptr<const std::vector<int>> memtable_deleted_;
+    // Позиции неудаленных документов изменяемого сегмента по id
+    std::map<int, int> memtable_positions_;
+    std::vector<FrozenMemtable> frozen_memtables_;
+    std::vector<SegmentRef> segments_;
+
+    // Опубликованная версия и удаление замененных версий
+    std::atomic<const Version*> version_{nullptr};
+    mutable EpochReclaimer epochs_;
+
+    // Фоновое слияние сегментов
+    std::mutex merge_mutex_;
+    std::condition_variable merge_cv_;
+    bool merge_requested_ = false;
+    bool merging_ = false;
+    bool stopping_ = false;
+    std::thread merge_thread_;
+
+    std::vector<std::pair<std::string_view, double>> ParseDocument(std::string_view document) const;
+    Query ParseQuery(const Version& version, std::string_view text) const;
+    // Поиск плюс-слов запроса в изменяемом сегменте версии. Найденные документы
+    // дописываются в matches, их количество с каждым плюс-словом прибавляется
+    // к document_freqs
+    static void ScanMemtable(const MemtableRef& memtable, const Query& query,
+                             std::vector<MemtableMatch>& matches, std::vector<double>& freqs,
+                             std::vector<int>& document_freqs);
+    // Обратная документная частота плюс-слов запроса по всем сегментам версии
+    static void ComputeInverseDocumentFreqs(const Version& version, Query& query,
+                                            std::vector<int>& document_freqs);
+
+    void SealMemtable();
+    static Segment BuildSegment(const FrozenMemtable& frozen);
+    // Закрытие замороженных сегментов фоновым потоком
+    void CloseFrozenMemtables();
+    void Publish();
+    void RequestMerge();
+    void MergeLoop();
+    // Выбор сегментов для слияния, пустой результат - слияние не требуется
+    std::vector<SegmentRef> PickMerge();
+    static Segment MergeSegments(const std::vector<SegmentRef>& sources);
+    void ReplaceSegments(const std::vector<SegmentRef>& sources, Segment merged);
+    // Отметки удаления tombstones, дополненные документами ids сегмента.
+    // Id в ids упорядочены и еще не отмечены
+    static std::shared_ptr<const Tombstones> AddTombstones(const Tombstones& tombstones, const Segment& segment,
+                                                           const std::vector<int>& ids);
+    // Объединение собственных отметок, основные отметки не учитываются
+    static Tombstones MergeTombstones(const Tombstones& lhs, const Tombstones& rhs);
+
+    template <typename StatusFilter>
+    static void FindInMemtable(const std::vector<MemtableMatch>& matches, const std::vector<double>& freqs,
+                               const Query& query, StatusFilter status, TopDocumentsHeap& top_documents);
+    template <typename StatusFilter>
+    static void FindInSegment(const Segment& segment, const Tombstones& deleted,
+                              const Query& query, StatusFilter status, TopDocumentsHeap& top_documents);
+};
+
+template <typename ExPol, typename StatusFilter>
+std::vector<Document> SegmentedIndex::FindTopDocuments(ExPol&& ex_po, std::string_view raw_query,
+                                                       StatusFilter status, size_t top_k) const {
+    const auto guard = epochs_.Pin();
+    const Version& version = *version_.load(std::memory_order_seq_cst);
+    Query query = ParseQuery(version, raw_query);
+    if (query.plus_terms.empty() || top_k == 0) {
+        return {};
+    }
+
+    // Документная частота слов складывается из изменяемых сегментов,
+    // документы которых находятся один раз, и закрытых сегментов
+    thread_local std::vector<MemtableMatch> memtable_matches;
+    thread_local std::vector<double> memtable_freqs;
+    memtable_matches.clear();
+    memtable_freqs.clear();
+    std::vector<int> document_freqs(query.plus_terms.size(), 0);
+    for (const MemtableRef& memtable : version.memtables) {
+        ScanMemtable(memtable, query, memtable_matches, memtable_freqs, document_freqs);
+    }
+    ComputeInverseDocumentFreqs(version, query, document_freqs);
+
+    const std::vector<SegmentRef>& segments = version.segments;
+    std::vector<TopDocumentsHeap> segment_top_documents(segments.size(), TopDocumentsHeap(top_k));
+    std::vector<size_t> indexes(segments.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    std::for_each(ex_po,
+                  indexes.begin(), indexes.end(),
+                  [&](size_t index) {
+        FindInSegment(*segments[index].segment, *segments[index].deleted,
+                      query, status, segment_top_documents[index]);
+    });
+    TopDocumentsHeap top_documents(top_k);
+    FindInMemtable(memtable_matches, memtable_freqs, query, status, top_documents);
+    for (TopDocumentsHeap& segment_top : segment_top_documents) {
+        top_documents.Merge(std::move(segment_top));
+    }
+    return top_documents.TakeSorted();
+}
+
+template <typename ExPol>
+std::vector<Document> SegmentedIndex::FindTopDocuments(ExPol&& ex_po, std::string_view raw_query,
+                                                       DocumentStatus document_status,
+                                                       size_t top_k) const {
+    return FindTopDocuments(ex_po, raw_query,
+           [document_status]([[maybe_unused]] int document_id,
+                             [[maybe_unused]] DocumentStatus status,
+                             [[maybe_unused]] int rating) {
+                             return status == document_status;
+                        }, top_k);
+}
+
+template <typename StatusFilter>
+std::vector<Document> SegmentedIndex::FindTopDocuments(std::string_view raw_query,
+                                                       StatusFilter status, size_t top_k) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status, top_k);
+}
+
+// Релевантность документов изменяемого сегмента. Вклады слов суммируются
+// в порядке слов запроса, как в AccumulateRelevance
+template <typename StatusFilter>
+void SegmentedIndex::FindInMemtable(const std::vector<MemtableMatch>& matches, const std::vector<double>& freqs,
+                                    const Query& query, StatusFilter status, TopDocumentsHeap& top_documents) {
+    for (const MemtableMatch& match : matches) {
+        const int document_id = match.document->id;
+        const SegmentDocument& document = match.document->document;
+        if (match.excluded || !status(document_id, document.status, document.rating)) {
+            continue;
+        }
+        double relevance = 0.0;
+        for (size_t i = 0; i < query.plus_terms.size(); ++i) {
+            if (const double term_freq = freqs[match.freqs_pos + i]; term_freq != 0.0) {
+                relevance += term_freq * query.plus_terms[i].inverse_document_freq;
+            }
+        }
+        top_documents.Push({document_id, relevance, document.rating});
+    }
+}
+
+// Поиск в одном сегменте тем же накопителем релевантности, что и в
+// SearchServer, по диапазону id документов сегмента. Удаленные документы
+// исключаются вместе с документами, содержащими минус-слова
+template <typename StatusFilter>
+void SegmentedIndex::FindInSegment(const Segment& segment, const Tombstones& deleted,
+                                   const Query& query, StatusFilter status,
+                                   TopDocumentsHeap& top_documents) {
+    std::vector<PostingRun> plus_runs;
+    plus_runs.reserve(query.plus_terms.size());
+    for (const QueryTerm& query_term : query.plus_terms) {
+        if (const PostingList* postings = segment.postings.Find(query_term.term)) {
+            plus_runs.push_back({postings->DocumentIds(), postings->TermFreqs(), postings->size(),
+                                 query_term.inverse_document_freq,
+                                 postings->MaxTermFreq() * query_term.inverse_document_freq});
+        }
+    }
+    if (plus_runs.empty()) {
+        return;
+    }
+    std::vector<PostingRun> minus_runs{{deleted.ids.data(), nullptr, deleted.ids.size(), 0.0, 0.0}};
+    if (deleted.base) {
+        minus_runs.push_back({deleted.base->ids.data(), nullptr, deleted.base->ids.size(), 0.0, 0.0});
+    }
+    for (const TermId term : query.minus_terms) {
+        if (const PostingList* postings = segment.postings.Find(term)) {
+            minus_runs.push_back({postings->DocumentIds(), postings->TermFreqs(),
+                                  postings->size(), 0.0, 0.0});
+        }
+    }
+
+    AccumulateRelevance(plus_runs, minus_runs, segment.documents.begin()->first, segment.documents.rbegin()->first,
+                        [&segment, status, &top_documents](int document_id, double relevance) {
+        const SegmentDocument& document = segment.documents.at(document_id);
+        if (status(document_id, document.status, document.rating)) {
+            top_documents.Push({document_id, relevance, document.rating});
+        }
+    }, nullptr);
+}
@@ -0,0 +1,213 @@
+#include "snapshot_file.h"
+
+#include <filesystem>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SNAPSHOT_USE_MMAP
+#endif
+
+using namespace std;
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'S', 'S', 'R', 'V', 'S', 'N', 'A', 'P'};
+// Записывается в порядке байт машины, на другой архитектуре снимок не читается
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t payload_size;
+    uint64_t checksum;
+};
+static_assert(sizeof(SnapshotHeader) % 8 == 0);
+
+// Контрольная сумма данных снимка: четыре независимые цепочки
+// умножений по 8-байтным словам, чтобы проверка не ограничивала загрузку
+uint64_t ComputeChecksum(const char* data, size_t size) {
+    constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+    uint64_t lanes[4] = {PRIME_1, PRIME_2, ~PRIME_1, ~PRIME_2};
+    const auto mix = [](uint64_t lane, uint64_t word) {
+        lane ^= word * PRIME_2;
+        lane = (lane << 31) | (lane >> 33);
+        return lane * PRIME_1;
+    };
+
+    size_t pos = 0;
+    for (; pos + 32 <= size; pos += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            memcpy(&word, data + pos + lane * 8, 8);
+            lanes[lane] = mix(lanes[lane], word);
+        }
+    }
+    uint64_t tail[4] = {0, 0, 0, 0};
+    if (pos < size) {
+        memcpy(tail, data + pos, size - pos);
+    }
+    for (int lane = 0; lane < 4; ++lane) {
+        lanes[lane] = mix(lanes[lane], tail[lane]);
+    }
+
+    uint64_t checksum = size;
+    for (uint64_t lane : lanes) {
+        checksum = mix(checksum, lane);
+    }
+    return checksum;
+}
+
+// Содержимое файла целиком: отображение в память там, где оно доступно,
+// иначе обычное чтение
+shared_ptr<char[]> MapFile(const string& path, size_t& size) {
+#ifdef SNAPSHOT_USE_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("cannot open snapshot "s + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw runtime_error("cannot open snapshot "s + path);
+    }
+    size = static_cast<size_t>(file_stat.st_size);
+    if (size == 0) {
+        close(fd);
+        return {};
+    }
+    // Закрытое отображение с правом записи нужно только ради типа char*,
+    // данные снимка не изменяются, поэтому страницы не копируются
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw runtime_error("cannot map snapshot "s + path);
+    }
+    return shared_ptr<char[]>(static_cast<char*>(data), [size](char* ptr) {
+        munmap(ptr, size);
+    });
+#else
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file) {
+        throw runtime_error("cannot open snapshot "s + path);
+    }
+    size = static_cast<size_t>(file.tellg());
+    shared_ptr<char[]> data(new char[size]);
+    file.seekg(0);
+    if (!file.read(data.get(), size)) {
+        throw runtime_error("cannot read snapshot "s + path);
+    }
+    return data;
+#endif
+}
+
+} // namespace
+
+void SnapshotWriter::WriteStrings(const vector<string_view>& strings) {
+    vector<uint64_t> offsets;
+    offsets.reserve(strings.size() + 1);
+    uint64_t offset = 0;
+    offsets.push_back(offset);
+    for (string_view str : strings) {
+        offset += str.size();
+        offsets.push_back(offset);
+    }
+
+    WriteValue<uint64_t>(strings.size());
+    WriteArray(offsets);
+    string text;
+    text.reserve(offset);
+    for (string_view str : strings) {
+        text += str;
+    }
+    WriteArray(text.data(), text.size());
+}
+
+void SnapshotWriter::Save(const string& path) const {
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.payload_size = buffer_.size();
+    header.checksum = ComputeChecksum(buffer_.data(), buffer_.size());
+
+    const string tmp_path = path + ".tmp"s;
+    {
+        ofstream file(tmp_path, ios::binary | ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(buffer_.data(), buffer_.size());
+        if (!file.flush()) {
+            throw runtime_error("cannot write snapshot "s + tmp_path);
+        }
+    }
+    filesystem::rename(tmp_path, path);
+}
+
+SnapshotReader::SnapshotReader(const string& path) {
+    size_t file_size = 0;
+    shared_ptr<char[]> file = MapFile(path, file_size);
+
+    SnapshotHeader header;
+    if (file_size < sizeof(header)) {
+        throw runtime_error("not a snapshot file"s);
+    }
+    memcpy(&header, file.get(), sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error("not a snapshot file"s);
+    }
+    if (header.version != SNAPSHOT_VERSION || header.byte_order != BYTE_ORDER_MARK) {
+        throw runtime_error("unsupported snapshot version"s);
+    }
+    if (header.payload_size != file_size - sizeof(header)) {
+        throw runtime_error("truncated snapshot"s);
+    }
+
+    size_ = header.payload_size;
+    // Указатель на данные после заголовка, разделяющий владение файлом
+    data_ = shared_ptr<char[]>(file, file.get() + sizeof(header));
+    if (ComputeChecksum(data_.get(), size_) != header.checksum) {
+        throw runtime_error("snapshot checksum mismatch"s);
+    }
+}
+
+vector<string_view> SnapshotReader::ReadStrings() {
+    const auto count = ReadValue<uint64_t>();
+    if (count >= size_ / sizeof(uint64_t)) {
+        throw runtime_error("truncated snapshot"s);
+    }
+    const uint64_t* offsets = ReadArray<uint64_t>(count + 1);
+    const char* text = ReadArray<char>(offsets[count]);
+
+    vector<string_view> strings;
+    strings.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1]) {
+            throw runtime_error("corrupt snapshot"s);
+        }
+        strings.emplace_back(text + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    return strings;
+}
+
+shared_ptr<char[]> SnapshotReader::Storage() const noexcept {
+    return data_;
+}
+
+bool SnapshotReader::AtEnd() const noexcept {
+    return pos_ == size_;
+}
+
+const char* SnapshotReader::Take(size_t bytes) {
+    const size_t aligned_bytes = (bytes + 7) / 8 * 8;
+    if (aligned_bytes > size_ - pos_) {
+        throw runtime_error("truncated snapshot"s);
+    }
+    const char* data = data_.get() + pos_;
+    pos_ += aligned_bytes;
+    return data;
+}
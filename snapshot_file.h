@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Версия формата снимка, увеличивается при любом изменении раскладки данных
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+// Запись двоичного снимка. Данные накапливаются в буфере, каждый массив
+// выравнивается по 8 байт, чтобы при чтении из отображенного в память файла
+// на него можно было ссылаться напрямую. Save записывает перед данными
+// заголовок с версией формата и контрольной суммой
+class SnapshotWriter {
+public:
+    template <typename T>
+    void WriteValue(T value) {
+        WriteArray(&value, 1);
+    }
+    template <typename T>
+    void WriteArray(const T* values, size_t count);
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        WriteArray(values.data(), values.size());
+    }
+    // Набор строк: количество, смещения строк в общем тексте и сам текст
+    void WriteStrings(const std::vector<std::string_view>& strings);
+
+    // Запись во временный файл с последующим переименованием,
+    // чтобы прерванное сохранение не испортило существующий снимок
+    void Save(const std::string& path) const;
+
+private:
+    std::vector<char> buffer_;
+};
+
+// Чтение снимка, отображенного в память. Конструктор проверяет заголовок
+// и контрольную сумму, методы чтения - выход за границы данных.
+// При ошибке выбрасывается std::runtime_error
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const std::string& path);
+
+    template <typename T>
+    T ReadValue() {
+        T value;
+        std::memcpy(&value, ReadArray<T>(1), sizeof(T));
+        return value;
+    }
+    // Указатель на count элементов внутри снимка
+    template <typename T>
+    const T* ReadArray(size_t count);
+    // Строки, записанные WriteStrings, ссылаются на данные снимка
+    std::vector<std::string_view> ReadStrings();
+
+    // Владелец данных снимка: пока жива копия указателя,
+    // строки и массивы, полученные из снимка, остаются действительными
+    std::shared_ptr<char[]> Storage() const noexcept;
+    // Все данные снимка прочитаны
+    bool AtEnd() const noexcept;
+
+private:
+    std::shared_ptr<char[]> data_;
+    size_t size_ = 0;
+    size_t pos_ = 0;
+
+    const char* Take(size_t bytes);
+};
+
+template <typename T>
+void SnapshotWriter::WriteArray(const T* values, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 8);
+    const size_t bytes = count * sizeof(T);
+    const size_t aligned_bytes = (bytes + 7) / 8 * 8;
+    const size_t pos = buffer_.size();
+    buffer_.resize(pos + aligned_bytes, 0);
+    if (bytes > 0) {
+        std::memcpy(buffer_.data() + pos, values, bytes);
+    }
+}
+
+template <typename T>
+const T* SnapshotReader::ReadArray(size_t count) {
+    static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= 8);
+    if (count > size_ / sizeof(T)) {
+        throw std::runtime_error("truncated snapshot");
+    }
+    return reinterpret_cast<const T*>(Take(count * sizeof(T)));
+}
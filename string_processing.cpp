@@ -1,21 +1,138 @@
 #include "string_processing.h"
 
-#include <execution>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
+namespace {
+
+// Маски блока текста: i-й бит соответствует i-му байту блока
+struct BlockMasks {
+    uint32_t spaces;
+    uint32_t control_chars;
+};
+
+// Проверка блока не более чем из 32 байт без векторных инструкций
+BlockMasks ScanBlockScalar(const char* data, size_t size) {
+    BlockMasks masks{0, 0};
+    for (size_t i = 0; i < size; ++i) {
+        const auto byte = static_cast<unsigned char>(data[i]);
+        masks.spaces |= uint32_t{byte == ' '} << i;
+        masks.control_chars |= uint32_t{byte < ' '} << i;
+    }
+    return masks;
+}
+
+#if defined(__AVX2__)
+constexpr size_t BLOCK_SIZE = 32;
+
+BlockMasks ScanBlock(const char* data) {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    const __m256i spaces = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '));
+    // Беззнаковое сравнение byte <= 31: min(byte, 31) == byte
+    const __m256i control_chars = _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, _mm256_set1_epi8(0x1F)), bytes);
+    return {static_cast<uint32_t>(_mm256_movemask_epi8(spaces)),
+            static_cast<uint32_t>(_mm256_movemask_epi8(control_chars))};
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr size_t BLOCK_SIZE = 16;
+
+BlockMasks ScanBlock(const char* data) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    const __m128i spaces = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+    // Беззнаковое сравнение byte <= 31: min(byte, 31) == byte
+    const __m128i control_chars = _mm_cmpeq_epi8(_mm_min_epu8(bytes, _mm_set1_epi8(0x1F)), bytes);
+    return {static_cast<uint32_t>(_mm_movemask_epi8(spaces)),
+            static_cast<uint32_t>(_mm_movemask_epi8(control_chars))};
+}
+#else
+constexpr size_t BLOCK_SIZE = 32;
+
+BlockMasks ScanBlock(const char* data) {
+    return ScanBlockScalar(data, BLOCK_SIZE);
+}
+#endif
+
+int CountTrailingZeros(uint32_t value) {
+#if defined(__GNUC__)
+    return __builtin_ctz(value);
+#else
+    int count = 0;
+    while ((value & 1) == 0) {
+        value >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+} // namespace
+
 vector<string_view> SplitIntoWords(string_view text) {
     vector<string_view> result;
-    const int64_t pos_end = text.npos;
-    while (true) {
-        int64_t space = text.find(' ', 0);
-        result.push_back(space == pos_end ? text.substr(0) : text.substr(0, space));
-        if (space == pos_end) {
-            break;
-        } else {
-            text.remove_prefix(space + 1);
+    SplitIntoWords(text, result);
+    return result;
+}
+
+// Текст обрабатывается блоками: по маске пробелов находятся позиции, где
+// слово начинается или заканчивается, а маска управляющих символов проверяется
+// в том же проходе
+bool SplitIntoWords(string_view text, vector<string_view>& words) {
+    words.clear();
+    const char* data = text.data();
+    bool in_word = false;
+    size_t word_begin = 0;
+
+    auto process_block = [data, &words, &in_word, &word_begin](size_t offset, uint32_t spaces, size_t size) {
+        const uint32_t size_mask = size == 32 ? ~uint32_t{0} : (uint32_t{1} << size) - 1;
+        const uint32_t letters = ~spaces & size_mask;
+        const uint32_t prev_letters = (letters << 1) | uint32_t{in_word};
+        // Границы слов - позиции, где байт и предыдущий байт различаются
+        uint32_t boundaries = (letters ^ prev_letters) & size_mask;
+        while (boundaries != 0) {
+            const size_t pos = offset + CountTrailingZeros(boundaries);
+            if (in_word) {
+                words.emplace_back(data + word_begin, pos - word_begin);
+            } else {
+                word_begin = pos;
+            }
+            in_word = !in_word;
+            boundaries &= boundaries - 1;
+        }
+    };
+
+    size_t offset = 0;
+    for (; offset + BLOCK_SIZE <= text.size(); offset += BLOCK_SIZE) {
+        const BlockMasks masks = ScanBlock(data + offset);
+        if (masks.control_chars != 0) {
+            return false;
         }
+        process_block(offset, masks.spaces, BLOCK_SIZE);
+    }
+    if (offset < text.size()) {
+        const BlockMasks masks = ScanBlockScalar(data + offset, text.size() - offset);
+        if (masks.control_chars != 0) {
+            return false;
+        }
+        process_block(offset, masks.spaces, text.size() - offset);
+    }
+    if (in_word) {
+        words.emplace_back(data + word_begin, text.size() - word_begin);
     }
 
-    return result;
+    return true;
+}
+
+bool ContainsControlChars(string_view text) {
+    size_t offset = 0;
+    for (; offset + BLOCK_SIZE <= text.size(); offset += BLOCK_SIZE) {
+        if (ScanBlock(text.data() + offset).control_chars != 0) {
+            return true;
+        }
+    }
+    return ScanBlockScalar(text.data() + offset, text.size() - offset).control_chars != 0;
 }
@@ -1,7 +1,44 @@
 #pragma once
 
+#include <algorithm>
 #include <numeric>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+// Разбиение текста на слова по пробелам. Пустые слова, возникающие
+// при нескольких пробелах подряд, в результат не попадают
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
+// Разбиение текста на слова в переданный буфер (предыдущее содержимое удаляется)
+// с одновременной проверкой символов. Возвращает false, если текст содержит
+// управляющие символы (коды 0-31)
+bool SplitIntoWords(std::string_view text, std::vector<std::string_view>& words);
+// Проверка текста на наличие управляющих символов (коды 0-31)
+bool ContainsControlChars(std::string_view text);
+
+// Разбор текста документа: слова без стоп-слов в лексикографическом порядке
+// и их частоты (доля слова среди всех слов документа, кроме стоп-слов).
+// Частоты накапливаются сложением, чтобы совпадать у всех индексов.
+// При управляющих символах в тексте выбрасывается std::invalid_argument
+template <typename IsStopWord>
+std::vector<std::pair<std::string_view, double>> ComputeWordFrequencies(std::string_view document,
+                                                                        IsStopWord is_stop_word) {
+    thread_local std::vector<std::string_view> words;
+    if (!SplitIntoWords(document, words)) {
+        throw std::invalid_argument("Invalid symbol!");
+    }
+    words.erase(std::remove_if(words.begin(), words.end(), is_stop_word), words.end());
+    std::sort(words.begin(), words.end());
+
+    const double inv_word_count = 1.0 / words.size();
+    std::vector<std::pair<std::string_view, double>> word_freqs;
+    for (std::string_view word : words) {
+        if (word_freqs.empty() || word_freqs.back().first != word) {
+            word_freqs.emplace_back(word, 0.0);
+        }
+        word_freqs.back().second += inv_word_count;
+    }
+    return word_freqs;
+}
@@ -0,0 +1,65 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+TermId TermDictionary::Intern(string_view word) {
+    const auto it = ids_.find(word);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+
+    const TermId term = static_cast<TermId>(words_.size());
+    const string_view stored = Store(word);
+    words_.push_back(stored);
+    ids_.emplace(stored, term);
+    return term;
+}
+
+TermId TermDictionary::Find(string_view word) const {
+    const auto it = ids_.find(word);
+    return it == ids_.end() ? NO_TERM : it->second;
+}
+
+string_view TermDictionary::GetWord(TermId term) const {
+    return words_.at(term);
+}
+
+bool TermDictionary::Assign(shared_ptr<char[]> storage, const vector<string_view>& words) {
+    chunks_.push_back(move(storage));
+    words_.reserve(words.size());
+    ids_.reserve(words.size());
+    for (string_view word : words) {
+        // Второй id одного слова недостижим через Find
+        if (word.empty() || !ids_.emplace(word, static_cast<TermId>(words_.size())).second) {
+            return false;
+        }
+        words_.push_back(word);
+    }
+    return true;
+}
+
+size_t TermDictionary::size() const noexcept {
+    return words_.size();
+}
+
+// Копирование текста слова в блок словаря
+string_view TermDictionary::Store(string_view word) {
+    if (word.empty()) {
+        return {};
+    }
+    if (cursor_.free < word.size()) {
+        const size_t chunk_size = max(CHUNK_SIZE, word.size());
+        chunks_.push_back(shared_ptr<char[]>(new char[chunk_size]));
+        cursor_.pos = chunks_.back().get();
+        cursor_.free = chunk_size;
+    }
+
+    memcpy(cursor_.pos, word.data(), word.size());
+    const string_view stored(cursor_.pos, word.size());
+    cursor_.pos += word.size();
+    cursor_.free -= word.size();
+    return stored;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Плотный идентификатор слова, выдается словарем при первой встрече слова
+using TermId = uint32_t;
+
+// Словарь слов: сопоставляет каждому слову плотный 32-битный id.
+// Текст слов хранится в собственных блоках памяти, которые никогда не
+// освобождаются и не перемещаются, поэтому string_view, полученные из
+// словаря, действительны все время жизни словаря и его копий.
+// Слова из словаря не удаляются: словарь без слов, переставших встречаться
+// в документах, строится заново (SearchServer::CompactTerms)
+class TermDictionary {
+public:
+    // Значение, возвращаемое Find для неизвестного слова
+    static constexpr TermId NO_TERM = std::numeric_limits<TermId>::max();
+
+    // Id слова, при отсутствии слово добавляется в словарь
+    TermId Intern(std::string_view word);
+    // Id слова или NO_TERM, если слово не встречалось
+    TermId Find(std::string_view word) const;
+    // Текст слова по его id
+    std::string_view GetWord(TermId term) const;
+    // Заполнение пустого словаря словами, текст которых уже размещен в storage
+    // (например, в загруженном снимке). Id слова - его позиция в words.
+    // Возвращает false, если среди words есть пустое или повторное слово;
+    // заполненный при этом словарь использовать нельзя
+    bool Assign(std::shared_ptr<char[]> storage, const std::vector<std::string_view>& words);
+
+    size_t size() const noexcept;
+
+private:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    // Позиция записи в последнем блоке. Копия словаря разделяет с оригиналом
+    // уже заполненные блоки, но пишет новые слова в собственный блок
+    struct WriteCursor {
+        WriteCursor() = default;
+        WriteCursor(const WriteCursor&) {}
+        WriteCursor& operator=(const WriteCursor&) {
+            pos = nullptr;
+            free = 0;
+            return *this;
+        }
+
+        char* pos = nullptr;
+        size_t free = 0;
+    };
+
+    std::vector<std::shared_ptr<char[]>> chunks_;
+    WriteCursor cursor_;
+    std::vector<std::string_view> words_;
+    std::unordered_map<std::string_view, TermId> ids_;
+
+    std::string_view Store(std::string_view word);
+};
@@ -0,0 +1,67 @@
+#include "versioned_search_server.h"
+
+#include <string>
+#include <thread>
+
+using namespace std;
+
+VersionedSearchServer::VersionedSearchServer(string_view stop_words)
+    : servers_{SearchServer(stop_words), SearchServer(stop_words)}
+    , current_(&servers_[0]) {
+}
+
+VersionedSearchServer::VersionedSearchServer(const SearchServer& server)
+    : servers_{server, server}
+    , current_(&servers_[0]) {
+}
+
+void VersionedSearchServer::AddDocument(int document_id, string_view document,
+                                        DocumentStatus status, const vector<int>& ratings) {
+    Update([document_id, document = string(document), status, ratings](SearchServer& server) {
+        server.AddDocument(document_id, document, status, ratings);
+    });
+}
+
+void VersionedSearchServer::RemoveDocument(int document_id) {
+    Update([document_id](SearchServer& server) {
+        server.RemoveDocument(document_id);
+    });
+}
+
+void VersionedSearchServer::Update(Change update) {
+    lock_guard lock(write_mutex_);
+    SearchServer& standby = AcquireStandby();
+    update(standby);
+
+    // Предыдущая копия освобождается, когда завершатся поиски, начатые
+    // до замены указателя
+    current_.store(&standby, memory_order_seq_cst);
+    pending_.push_back(move(update));
+    standby_released_.store(false, memory_order_relaxed);
+    epochs_.Retire([this] {
+        standby_released_.store(true, memory_order_release);
+    });
+}
+
+int VersionedSearchServer::GetDocumentCount() const {
+    return Read([](const SearchServer& server) {
+        return server.GetDocumentCount();
+    });
+}
+
+// Вторая копия после завершения читающих ее поисков, с примененными
+// изменениями текущей. Вызывается под write_mutex_
+SearchServer& VersionedSearchServer::AcquireStandby() {
+    while (!standby_released_.load(memory_order_acquire)) {
+        epochs_.Reclaim();
+        if (!standby_released_.load(memory_order_acquire)) {
+            this_thread::yield();
+        }
+    }
+    SearchServer& standby = current_.load(memory_order_relaxed) == &servers_[0] ? servers_[1] : servers_[0];
+    for (const Change& change : pending_) {
+        change(standby);
+    }
+    pending_.clear();
+    return standby;
+}
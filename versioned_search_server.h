@@ -0,0 +1,77 @@
+#pragma once
+
+#include "document.h"
+#include "search_server.h"
+#include "Lib/epoch_reclaimer.h"
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// SearchServer, в который можно добавлять документы во время поиска.
+// Хранятся две копии сервера: поиск читает опубликованную, писатель изменяет
+// вторую и публикует ее заменой указателя. Поиск закрепляет эпоху и не берет
+// блокировок, поэтому писатель не задерживает его. Перед следующим
+// изменением писатель ждет завершения поисков, начатых до публикации,
+// догоняет вторую копию изменениями первой и применяет новое изменение.
+// Каждое изменение выполняется дважды, а индекс занимает вдвое больше памяти,
+// поэтому режим включается явно вместо SearchServer
+class VersionedSearchServer {
+public:
+    explicit VersionedSearchServer(std::string_view stop_words);
+    // Обе копии создаются из готового сервера, например загруженного из снимка
+    explicit VersionedSearchServer(const SearchServer& server);
+    VersionedSearchServer(const VersionedSearchServer&) = delete;
+    VersionedSearchServer& operator=(const VersionedSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document,
+                     DocumentStatus status, const std::vector<int>& ratings);
+    void RemoveDocument(int document_id);
+    // Произвольное изменение, например добавление набора документов одной
+    // публикацией. Применяется к обеим копиям и должно изменять их одинаково.
+    // Ко второй копии update применяется при следующем изменении, поэтому
+    // не должно ссылаться на объекты, которые к тому времени изменятся.
+    // Исключение при первом применении отменяет публикацию
+    void Update(std::function<void(SearchServer&)> update);
+
+    // Чтение опубликованной копии. Ссылка на сервер действительна только
+    // внутри read
+    template <typename Reader>
+    auto Read(Reader read) const {
+        const auto guard = epochs_.Pin();
+        return read(*current_.load(std::memory_order_seq_cst));
+    }
+
+    // Поиск с теми же аргументами, что у SearchServer::FindTopDocuments
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(Args&&... args) const {
+        return Read([&](const SearchServer& server) {
+            return server.FindTopDocuments(std::forward<Args>(args)...);
+        });
+    }
+
+    int GetDocumentCount() const;
+
+private:
+    using Change = std::function<void(SearchServer&)>;
+
+    std::array<SearchServer, 2> servers_;
+    std::atomic<const SearchServer*> current_;
+
+    // Состояние писателей, защищено write_mutex_. Изменения, опубликованные
+    // в текущей копии и еще не примененные ко второй
+    std::mutex write_mutex_;
+    std::vector<Change> pending_;
+    // Поиски, начатые во второй копии до публикации текущей, завершены
+    std::atomic<bool> standby_released_{true};
+
+    // Разрушается первым: оставшиеся отметки освобождения обращаются
+    // к standby_released_
+    mutable EpochReclaimer epochs_;
+
+    SearchServer& AcquireStandby();
+};